@@ -0,0 +1,54 @@
+#include <FrameJacker.h>
+#include "Clock.h"
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Invocation and copy cost of the callback type against std::function and a raw function pointer.
+// Callables sit in vectors, like in a callback snapshot, so the calls cannot be inlined.
+static uint64_t g_Sink = 0;
+
+static void RawCallback(const FrameEvent& frame) { g_Sink += frame.frameIndex; }
+
+template<typename Callable>
+static void Measure(const char* name, const Callable& callable) {
+    static constexpr uint32_t kCallbacks = 16;
+    static constexpr uint32_t kRounds = 1000000;
+
+    std::vector<Callable> callables(kCallbacks, callable);
+    FrameEvent frame = {};
+
+    uint64_t start = Clock::Now();
+    for (uint32_t round = 0; round < kRounds; round++) {
+        frame.frameIndex = round;
+        for (const Callable& target : callables)
+            target(frame);
+    }
+    double perCall = (double)(Clock::Now() - start) / ((uint64_t)kRounds * kCallbacks);
+
+    // Publishing a snapshot copies every callback once
+    start = Clock::Now();
+    for (uint32_t round = 0; round < kRounds / 100; round++) {
+        std::vector<Callable> copy = callables;
+        g_Sink += copy.size();
+    }
+    double perCopy = (double)(Clock::Now() - start) / ((uint64_t)(kRounds / 100) * kCallbacks);
+
+    std::printf("%-24s %12.2f %12.2f\n", name, perCall, perCopy);
+}
+
+int main() {
+    uint64_t local = 0;
+    uint64_t* counter = &local;
+
+    std::printf("%-24s %12s %12s\n", "callable", "ns per call", "ns per copy");
+    Measure("function pointer", &RawCallback);
+    Measure("Delegate (function)", Delegate<void(const FrameEvent&)>(&RawCallback));
+    Measure("Delegate (lambda)", Delegate<void(const FrameEvent&)>([counter](const FrameEvent& frame) { *counter += frame.frameIndex; }));
+    Measure("std::function (lambda)",
+        std::function<void(const FrameEvent&)>([counter](const FrameEvent& frame) { *counter += frame.frameIndex; }));
+
+    return (g_Sink + local) == 42 ? 1 : 0;
+}
@@ -0,0 +1,42 @@
+#include "CallbackRegistry.h"
+#include "Clock.h"
+#include <cstdio>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Cost of one present through the callback path (snapshot pin, frame tracking, OnPresent and
+// OnPostPresent dispatch with budget accounting) for 1 to 64 subscribers doing trivial work
+int main() {
+    static constexpr uint32_t kPresents = 200000;
+    static uint64_t sink = 0;
+    int swapChain = 0;
+
+    std::printf("%12s %16s %20s\n", "subscribers", "ns per present", "ns per subscriber");
+    for (uint32_t count = 1; count <= 64; count *= 2) {
+        std::vector<SubscriptionId> ids;
+        for (uint32_t i = 0; i < count; i++) {
+            Callbacks callbacks;
+            callbacks.OnPresent = [](const FrameEvent& frame) { sink += frame.frameIndex; };
+            callbacks.OnPostPresent = [](const FrameEvent& frame) { sink ^= frame.presentDuration; };
+            ids.push_back(CallbackRegistry::Subscribe(callbacks));
+        }
+
+        uint64_t start = Clock::Now();
+        for (uint32_t i = 0; i < kPresents; i++) {
+            CallbackScope callbacks;
+            callbacks.BeginFrame(API::D3D11, &swapChain);
+            callbacks.OnPresent();
+            callbacks.BeginOriginalPresent();
+            callbacks.OnPostPresent();
+        }
+        double perPresent = (double)(Clock::Now() - start) / kPresents;
+
+        std::printf("%12u %16.1f %20.1f\n", count, perPresent, perPresent / count);
+
+        for (SubscriptionId id : ids)
+            CallbackRegistry::Unsubscribe(id);
+    }
+
+    return sink == 42 ? 1 : 0;
+}
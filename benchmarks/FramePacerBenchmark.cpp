@@ -0,0 +1,71 @@
+#include "FramePacer.h"
+#include "Clock.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Present-to-present intervals under the frame limiter, with a little CPU work per frame, next to
+// a plain sleep_for limiter at the same rate. Spread between p1 and p99 is the pacing jitter.
+static void Work() {
+    volatile double sink = 0;
+    for (int i = 0; i < 20000; i++)
+        sink = sink + i;
+}
+
+static void Report(const char* name, double fps, std::vector<uint64_t>& intervals) {
+    std::sort(intervals.begin(), intervals.end());
+    size_t count = intervals.size();
+    std::printf("%-10s %8.0f %12.3f %12.3f %12.3f %12.3f\n", name, fps, intervals[count / 100] / 1e6,
+        intervals[count / 2] / 1e6, intervals[count * 99 / 100] / 1e6, intervals.back() / 1e6);
+}
+
+int main() {
+    static constexpr double kSeconds = 2.0;
+
+    std::printf("%-10s %8s %12s %12s %12s %12s\n", "limiter", "fps", "p1 ms", "p50 ms", "p99 ms", "max ms");
+    for (double fps : { 60.0, 144.0, 240.0, 500.0 }) {
+        uint32_t frames = (uint32_t)(fps * kSeconds);
+        std::vector<uint64_t> intervals;
+        intervals.reserve(frames);
+
+        FramePacer::SetLimit(fps);
+        uint64_t last = 0;
+        for (uint32_t i = 0; i < frames; i++) {
+            FramePacer::Wait();
+            uint64_t now = Clock::Now();
+            if (last)
+                intervals.push_back(now - last);
+            last = now;
+            Work();
+        }
+        FrameLimitStats stats = FramePacer::GetStats();
+        FramePacer::SetLimit(0.0);
+        Report("FramePacer", fps, intervals);
+        std::printf("%10s jitter avg %.1f us, max %.1f us, spin margin %.1f us\n", "",
+            stats.averageJitterMicroseconds, stats.maxJitterMicroseconds, stats.spinMicroseconds);
+
+        // Sleeping for whatever is left of the interval, as most in-game limiters do
+        intervals.clear();
+        uint64_t interval = (uint64_t)(1e9 / fps);
+        last = 0;
+        uint64_t frameStart = Clock::Now();
+        for (uint32_t i = 0; i < frames; i++) {
+            uint64_t elapsed = Clock::Now() - frameStart;
+            if (elapsed < interval)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(interval - elapsed));
+            uint64_t now = Clock::Now();
+            frameStart = now;
+            if (last)
+                intervals.push_back(now - last);
+            last = now;
+            Work();
+        }
+        Report("sleep_for", fps, intervals);
+    }
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <FrameJacker/Histogram.h>
+#include "Clock.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Record cost on the present path, and the cost of the queries a stats panel makes, per precision
+int main() {
+    static constexpr uint32_t kValues = 1 << 16;
+    static constexpr uint32_t kRecords = 20000000;
+    static constexpr uint32_t kQueries = 2000;
+
+    std::mt19937_64 random(1);
+    std::exponential_distribution<> frameTimes(1.0 / 16.6e6);
+    std::vector<uint64_t> values(kValues);
+    for (auto& value : values)
+        value = (uint64_t)frameTimes(random);
+
+    uint64_t sink = 0;
+    std::printf("%10s %10s %16s %18s %14s\n", "precision", "memory", "ns per Record", "us per percentile", "us per copy");
+    for (uint32_t precisionBits : { 4u, 6u, 8u, 10u, 12u }) {
+        Histogram histogram(Histogram::kDefaultHighestValue, precisionBits);
+
+        uint64_t start = Clock::Now();
+        for (uint32_t i = 0; i < kRecords; i++)
+            histogram.Record(values[i & (kValues - 1)]);
+        double perRecord = (double)(Clock::Now() - start) / kRecords;
+
+        start = Clock::Now();
+        for (uint32_t i = 0; i < kQueries; i++)
+            sink += histogram.GetValueAtPercentile(99.0);
+        double perPercentile = (double)(Clock::Now() - start) / kQueries / 1000.0;
+
+        start = Clock::Now();
+        for (uint32_t i = 0; i < kQueries; i++) {
+            Histogram copy = histogram;
+            sink += copy.GetTotalCount();
+        }
+        double perCopy = (double)(Clock::Now() - start) / kQueries / 1000.0;
+
+        std::printf("%10u %9zuK %16.2f %18.2f %14.2f\n", precisionBits, histogram.GetMemorySize() / 1024,
+            perRecord, perPercentile, perCopy);
+    }
+
+    return sink == 42 ? 1 : 0;
+}
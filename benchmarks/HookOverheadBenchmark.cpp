@@ -0,0 +1,80 @@
+#include "CallbackRegistry.h"
+#include "Clock.h"
+#include "FrameTelemetry.h"
+#include "ResizeCoalescer.h"
+#include "StutterDetector.h"
+#include <cstdio>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Hook overhead as reported by Stats::GetOverhead for a synthetic present source driving the whole
+// present path: resize coalescing, stutter detection and subscribers on every event. The
+// subscribers spin, so a regression that counts their time as overhead shows up right away.
+static void Spin(uint64_t nanoseconds) {
+    uint64_t start = Clock::Now();
+    while (Clock::Now() - start < nanoseconds) {}
+}
+
+int main() {
+    static constexpr uint32_t kPresents = 20000;
+    static constexpr uint32_t kResizeInterval = 1000;
+    static constexpr uint32_t kStutterInterval = 250;
+    static constexpr uint64_t kPresentNanoseconds = 20000;
+    static constexpr uint64_t kCallbackNanoseconds = 10000;
+    int swapChain = 0;
+
+    ResizeCoalescer::SetSettleTime(1);
+    StutterSettings settings;
+    settings.WindowFrames = 32;
+    StutterDetector::Configure(settings);
+
+    std::printf("%12s %16s %16s %12s %12s\n", "subscribers", "overhead us", "wall us", "resizes", "stutters");
+    for (uint32_t count = 1; count <= 16; count *= 2) {
+        uint64_t resizes = 0;
+        uint64_t stutters = 0;
+        std::vector<SubscriptionId> ids;
+        for (uint32_t i = 0; i < count; i++) {
+            Callbacks callbacks;
+            callbacks.OnPresent = [](const FrameEvent&) { Spin(kCallbackNanoseconds); };
+            callbacks.OnPostPresent = [](const FrameEvent&) { Spin(kCallbackNanoseconds); };
+            callbacks.OnResize = [&resizes](const ResizeEvent& resize) {
+                if (resize.settled)
+                    resizes++;
+                Spin(kCallbackNanoseconds);
+            };
+            callbacks.OnStutter = [&stutters](const StutterEvent&) {
+                stutters++;
+                Spin(kCallbackNanoseconds);
+            };
+            ids.push_back(CallbackRegistry::Subscribe(callbacks));
+        }
+
+        FrameTelemetry::Reset();
+        uint64_t start = Clock::Now();
+        for (uint32_t i = 0; i < kPresents; i++) {
+            CallbackScope callbacks;
+            if (i % kResizeInterval == 0) {
+                ResizeEvent resize = { API::D3D11, 1280 + i % 7, 720, 0, &swapChain, false };
+                callbacks.OnResize(resize);
+                callbacks.DeferResize(resize);
+            }
+
+            callbacks.BeginFrame(API::D3D11, &swapChain);
+            callbacks.OnPresent();
+            callbacks.BeginOriginalPresent();
+            Spin(i % kStutterInterval == kStutterInterval - 1 ? kPresentNanoseconds * 50 : kPresentNanoseconds);
+            callbacks.OnPostPresent();
+        }
+        double wall = (double)(Clock::Now() - start) / kPresents / 1000.0;
+
+        OverheadStats overhead = FrameTelemetry::GetOverhead();
+        std::printf("%12u %16.2f %16.2f %12llu %12llu\n", count, overhead.averageMicroseconds, wall,
+            (unsigned long long)resizes, (unsigned long long)stutters);
+
+        for (SubscriptionId id : ids)
+            CallbackRegistry::Unsubscribe(id);
+    }
+
+    return 0;
+}
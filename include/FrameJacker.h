@@ -1,6 +1,9 @@
 ﻿#pragma once
-#include <functional>
+#include <cstdint>
 #include <memory>
+#include <vector>
+#include "FrameJacker/Delegate.h"
+#include "FrameJacker/Histogram.h"
 
 namespace FrameJacker {
     #ifdef _WIN64
@@ -37,11 +40,292 @@ namespace FrameJacker {
         void* extra;            // API-specific extra data if needed
     };
 
+    // Filled in once per frame by the present hook. Timestamps are nanoseconds on FrameJacker's
+    // monotonic clock (QueryPerformanceCounter).
+    struct FrameEvent {
+        API api;
+        uint64_t frameIndex;                // Starts at 0, one per present
+        uint64_t timestamp;                 // Entry into the present hook
+        uint64_t previousFrameDuration;     // Present-to-present time of the previous frame, 0 for the first
+        uint64_t presentDuration;           // Time blocked inside the original present call, OnPostPresent only
+        uint32_t syncInterval;              // DXGI only
+        uint32_t flags;                     // DXGI only
+        void* swapChain;                    // IDXGISwapChain*, VkSwapchainKHR, HDC (OpenGL), IDirect3DDevice9* (D3D9)
+        void* queue;                        // ID3D12CommandQueue* (once known), VkQueue
+    };
+
+    struct ResizeEvent {
+        API api;
+        uint32_t width;         // 0 = unchanged/window size, as passed to the API (see settled)
+        uint32_t height;
+        uint32_t format;        // DXGI_FORMAT, D3DFORMAT or VkFormat
+        void* swapChain;        // IDXGISwapChain*, VkSwapchainKHR, IDirect3DDevice9* (D3D9)
+
+        // Without resize coalescing every event is settled. With it, each resize call first delivers
+        // an unsettled event before the swap chain is touched (release back buffer references
+        // here), and a single settled event with the final size follows at the first present after
+        // the size stops changing (rebuild resources here).
+        bool settled;
+    };
+
+    // One present in the history handed to OnStutter
+    struct StutterFrame {
+        uint64_t frameIndex;
+        uint64_t timestamp;             // Entry into the present hook
+        uint64_t frameDuration;         // Present-to-present time ending at this present
+        uint64_t presentDuration;       // Time blocked inside the original present
+        uint64_t submissions;           // Command queue submissions, with submission statistics enabled
+        uint64_t drawCalls;             // With draw statistics enabled
+        bool resized;                   // A resize event was delivered since the previous present
+    };
+
+    // A frame that took much longer than the frames around it. history and the values in it are only
+    // valid during the callback.
+    struct StutterEvent {
+        API api;
+        uint64_t frameIndex;
+        double frameMilliseconds;
+        double medianMilliseconds;      // Moving median before this frame
+        double madMilliseconds;         // Median absolute deviation over the same window
+        const StutterFrame* history;    // Oldest first, the stuttering frame last
+        uint32_t historyCount;
+    };
+
+    // Each frame runs three phases in order: OnPresent (pre-present), OnRender (overlay) and, once the
+    // original present call has returned, OnPostPresent. Work that does not have to land in the
+    // current frame (pacing, latency measurement, capture fences) belongs in OnPostPresent.
     struct Callbacks {
-        std::function<void()> OnPresent;
-        std::function<void()> OnResize;
-        std::function<void(void*)> OnDeviceCreated;
-        std::function<void(const RenderContext&)> OnRender; 
+        Delegate<void(const FrameEvent&)> OnPresent;
+        Delegate<void(const ResizeEvent&)> OnResize;
+        Delegate<void(void*)> OnDeviceCreated;
+        Delegate<void(const RenderContext&)> OnRender;
+        Delegate<void(const FrameEvent&)> OnPostPresent;
+        Delegate<void(const StutterEvent&)> OnStutter;     // After OnPostPresent, needs Stats::SetStutterDetection
+
+        int Priority = 0;       // Lower runs first within each phase, ties keep subscription order
+        bool Async = false;     // Run OnPresent on a FrameJacker worker thread instead of the render thread
+
+        // When the average per-frame cost of this subscriber's render-thread callbacks exceeds the
+        // budget, they only run every ThrottleInterval frames until the cost drops below half of it.
+        // OnResize, OnDeviceCreated and OnStutter count towards the cost but are never skipped.
+        double BudgetMicroseconds = 0.0;    // 0 = unlimited
+        uint32_t ThrottleInterval = 4;
+    };
+
+    using SubscriptionId = uint32_t;
+
+    struct CallbackStats {
+        SubscriptionId id;
+        uint64_t frames;                // Frames the callbacks ran
+        uint64_t skippedFrames;         // Frames skipped while throttled
+        double lastMicroseconds;        // Summed over all render-thread callbacks
+        double averageMicroseconds;
+        double maxMicroseconds;
+        bool throttled;
+    };
+
+    // Frame-time statistics over the last 1024 presents (fewer right after startup or Reset).
+    // Frame times are bucketed at 50 us, so percentiles are accurate to that resolution.
+    struct FrameStats {
+        uint64_t frames;                // Frames recorded since startup or the last Reset
+        uint32_t windowFrames;          // Frames the statistics below are computed over
+        double averageMilliseconds;
+        double averageFps;
+        double p50Milliseconds;
+        double p99Milliseconds;
+        double p999Milliseconds;
+        double onePercentLowFps;        // FPS over the slowest 1% of frames in the window
+
+        // Time blocked inside the original present call (vsync, queue backpressure, driver
+        // throttling) and the rest of the frame. A frame whose present time dominates is GPU or
+        // vsync bound, one whose CPU time dominates is CPU bound.
+        double averagePresentMilliseconds;
+        double p99PresentMilliseconds;
+        double averageCpuMilliseconds;
+    };
+
+    // Time FrameJacker itself adds to each frame: the present hook bodies (device lookup, dispatch,
+    // overlay compositing, bookkeeping), excluding the original present call and user callbacks.
+    struct OverheadStats {
+        uint64_t frames;
+        double lastMicroseconds;
+        double averageMicroseconds;
+        double maxMicroseconds;
+    };
+
+    static constexpr uint32_t kMaxTrackedQueues = 8;
+    static constexpr uint32_t kUnknownQueueType = 0xFFFFFFFF;
+
+    // Work one command queue was given between the last two presents
+    struct QueueSubmissionStats {
+        void* queue;                    // ID3D12CommandQueue*, VkQueue
+        uint32_t type;                  // D3D12_COMMAND_LIST_TYPE, or the VkQueueFlags of the queue's family
+        uint64_t submissions;           // ExecuteCommandLists, vkQueueSubmit and vkQueueSubmit2 calls
+        uint64_t batches;               // VkSubmitInfo(2) entries, one per call on D3D12
+        uint64_t commandLists;          // Command lists or command buffers
+        uint64_t waitSemaphores;        // Vulkan only
+        uint64_t signalSemaphores;      // Vulkan only
+        double submitMicroseconds;      // CPU time inside the submit calls
+    };
+
+    // Command queue submissions between the last two presents. Many small submissions per frame
+    // usually mean the title is paying CPU overhead for batching it could do itself.
+    struct SubmissionStats {
+        uint64_t frames;                // Frames counted while enabled
+        uint64_t submissions;
+        uint64_t batches;
+        uint64_t commandLists;
+        double submitMicroseconds;
+        uint64_t directSubmissions;         // By D3D12 queue type, or Vulkan graphics, compute and transfer-only families
+        uint64_t computeSubmissions;
+        uint64_t copySubmissions;
+        uint32_t queueCount;            // Queues seen so far; beyond kMaxTrackedQueues they share the last entry
+        QueueSubmissionStats queues[kMaxTrackedQueues];
+    };
+
+    // Draw and state calls issued between the last two presents, on every thread, including those
+    // made by OnRender callbacks
+    struct DrawStats {
+        uint64_t frames;                // Frames counted while enabled
+        uint64_t drawCalls;
+        uint64_t textureBinds;          // SetTexture, glBindTexture
+        uint64_t renderStateChanges;    // SetRenderState (D3D9)
+        uint64_t shaderChanges;         // SetVertexShader, SetPixelShader, glUseProgram
+        uint64_t dispatches;            // D3D11 only from here on
+        uint64_t maps;
+        uint64_t unmaps;
+        uint64_t resourceUpdates;       // UpdateSubresource
+        uint64_t resourceCopies;        // CopyResource
+
+        // CPU time spent inside the calls above, when enabled with measureCpuTime (D3D11, OpenGL draws)
+        double drawMicroseconds;
+        double dispatchMicroseconds;
+        double mapMicroseconds;         // Map and Unmap, including stalls waiting for the GPU
+        double transferMicroseconds;    // UpdateSubresource and CopyResource
+    };
+
+    // How closely the frame limiter hits its deadlines, since the limit was last set
+    struct FrameLimitStats {
+        double targetFps;               // 0 when the limiter is off
+        uint64_t frames;                // Presents that were held back
+        double averageWaitMilliseconds;
+        double averageJitterMicroseconds;   // How late the limiter released the present
+        double maxJitterMicroseconds;
+        double spinMicroseconds;        // Current busy-wait margin before each deadline
+    };
+
+    // What the low latency mode is doing, as of the last present on the swap chain it follows
+    struct LatencyStats {
+        bool enabled;
+        uint64_t frames;
+        double delayMilliseconds;           // Frame start held back after the last present
+        double averageDelayMilliseconds;
+        double renderMilliseconds;          // Game's frame, from the hook returning to the next present
+        double blockedMilliseconds;         // Present call plus frame limiter wait, what is left to shave
+    };
+
+    // A frame counts as a stutter when it takes longer than Threshold times the moving median of the
+    // last WindowFrames frames and more than MadThreshold median absolute deviations above it.
+    struct StutterSettings {
+        bool Enabled = true;
+        double Threshold = 2.0;
+        double MadThreshold = 5.0;      // 0 = only the median multiple counts
+        uint32_t WindowFrames = 64;     // 8 to 256
+        uint32_t HistoryFrames = 120;   // Frames passed to OnStutter, up to 1024
+    };
+
+    // Present modes a VulkanSwapchainPolicy can ask for, with the values of VkPresentModeKHR
+    enum class VulkanPresentMode : int32_t {
+        Keep = -1,
+        Immediate = 0,
+        Mailbox = 1,
+        Fifo = 2,
+        FifoRelaxed = 3
+    };
+
+    // Rewrites applied to the game's vkCreateSwapchainKHR calls. Whatever the surface does not
+    // support is left as the game asked for it.
+    struct VulkanSwapchainPolicy {
+        VulkanPresentMode PresentMode = VulkanPresentMode::Keep;
+        uint32_t MinImageCount = 0;     // 0 keeps the game's count, otherwise clamped to the surface's range
+    };
+
+    // Built-in present-to-present telemetry, recorded by every present hook. Get never blocks the
+    // render thread and can be called from any thread.
+    class Stats {
+    public:
+        static FrameStats Get();
+        static OverheadStats GetOverhead();
+        static void Reset();
+
+        // Opt-in full-session frame-time distribution (nanoseconds) in constant memory. GetHistogram
+        // returns a copy; subtract an earlier copy from a later one to get the frames in between.
+        // Disabling pauses recording and keeps the data; enabling again with the same precisionBits
+        // continues it, a different precisionBits starts a new histogram.
+        static void SetHistogramEnabled(bool enabled, uint32_t precisionBits = Histogram::kDefaultPrecisionBits);
+        static Histogram GetHistogram();
+
+        // Publish a record per frame into a named shared memory ring that tools in other processes
+        // can poll with SharedTelemetryReader (FrameJacker/SharedTelemetry.h). capacity is rounded
+        // up to a power of two.
+        static bool SetSharedTelemetryEnabled(bool enabled, uint32_t capacity = 1024);
+
+        // Opt-in counting of D3D12 ExecuteCommandLists and Vulkan vkQueueSubmit/vkQueueSubmit2 calls
+        // per queue
+        static void SetSubmissionStatsEnabled(bool enabled);
+        static SubmissionStats GetSubmissions();
+
+        // Opt-in counting of draw and state calls (D3D9, D3D11 immediate context, OpenGL). The extra
+        // hooks are installed the first time a frame is presented with this enabled, and cost next
+        // to nothing once disabled again. measureCpuTime also times each call (D3D11, OpenGL).
+        static void SetDrawStatsEnabled(bool enabled, bool measureCpuTime = false);
+        static DrawStats GetDraws();
+
+        // Streaming stutter detection in the present hooks, reported through Callbacks::OnStutter
+        static void SetStutterDetection(const StutterSettings& settings);
+        static uint64_t GetStutterCount();
+
+        static FrameLimitStats GetFrameLimit();
+        static LatencyStats GetLatency();
+    };
+
+    // PresentMon-style capture of one record per present into a compressed binary file, written by
+    // a background thread. Convert it with ConvertTraceToCsv (FrameJacker/TraceFile.h) or the
+    // FrameJackerTraceToCsv tool.
+    class Trace {
+    public:
+        // Fails while the previous capture is still being written out
+        static bool Start(const char* path);
+        static void Stop();
+        static bool IsRecording();
+
+        // Records lost because the writer thread fell two blocks behind a presenting thread
+        static uint64_t GetDroppedRecords();
+    };
+
+    // Timeline of FrameJacker's own work (present hook, original present, every subscriber callback,
+    // resizes, swap chain creation, DX12 command list submissions) in Chrome trace-event JSON, which
+    // chrome://tracing and ui.perfetto.dev open. Events collect in per-thread buffers while enabled.
+    class Timeline {
+    public:
+        static void SetEnabled(bool enabled);
+        static bool IsEnabled();
+
+        // Writes everything buffered so far to path and consumes it
+        static bool Export(const char* path);
+
+        // Enables the timeline and appends to path from a background thread every 100 ms until
+        // StopStreaming, which disables it again. Stops a previous stream first and fails if that
+        // one has not closed its file yet.
+        static bool StartStreaming(const char* path);
+        static void StopStreaming();
+
+        // User zones: pass BeginZone's result to EndZone. name is stored by pointer, use a literal.
+        static uint64_t BeginZone();
+        static void EndZone(const char* name, uint64_t begin);
+
+        // Events lost because a thread's buffer (4096 events) filled before it was exported
+        static uint64_t GetDroppedEvents();
     };
 
     class IGraphicsHook {
@@ -58,11 +342,51 @@ namespace FrameJacker {
         static void Shutdown();
         static void SetCallbacks(const Callbacks& callbacks);
         static API GetActiveAPI();
-        ;
-        static Callbacks s_Callbacks; 
+
+        // Coalesce bursts of resizes (e.g. dragging a window edge) into one settled OnResize, delivered
+        // once no resize has happened for settleMilliseconds. 0 (the default) disables coalescing.
+        static void SetResizeCoalescing(uint32_t settleMilliseconds);
+
+        // Retained overlay (D3D11, D3D12, Vulkan and OpenGL): OnRender draws into an offscreen layer, bound as
+        // RenderContext::renderTarget, and only runs again after InvalidateOverlay or once per
+        // 1/maxRedrawsPerSecond (0 = only when invalidated). The layer is composited every frame.
+        static void SetRetainedOverlay(bool enabled, double maxRedrawsPerSecond = 0.0);
+        static void InvalidateOverlay();
+
+        // Caps the frame rate by holding each present back until its slot, on every API. Sleeps on a
+        // high-resolution timer and spins the last fraction of a millisecond. 0 disables the cap.
+        static void SetFrameLimit(double fps);
+
+        // Low latency mode: holds the present hook back after each present just long enough that the
+        // game's next frame reaches its present right as the GPU or display can take it, so input is
+        // sampled later. Pairs with SetFrameLimit, whose wait it moves to the start of the frame.
+        static void SetLowLatencyMode(bool enabled);
+
+        // Lets D3D11/D3D12 swap chains queue at most this many frames (1 to 16). Swap chains created
+        // with DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT are held in the present hook until
+        // the queue has room. 0 gives the game back its own setting.
+        static void SetMaximumFrameLatency(uint32_t frames);
+
+        // Present mode and image count for Vulkan swapchains created from now on. Takes effect when
+        // the game next creates its swapchain (usually on resize); devices created before Install
+        // are left alone.
+        static void SetVulkanSwapchainPolicy(const VulkanSwapchainPolicy& policy);
+
+        // Each subscriber gets its own set of callbacks. Within each phase they run by Priority, lowest
+        // first, and in subscription order among equal priorities.
+        // A callback may still be running on the render thread when Unsubscribe returns.
+        static SubscriptionId Subscribe(const Callbacks& callbacks);
+        static bool Unsubscribe(SubscriptionId id);
+
+        // Frames an Async subscriber missed because its queue was full when the frame was presented.
+        static uint64_t GetDroppedEvents(SubscriptionId id);
+
+        static bool GetCallbackStats(SubscriptionId id, CallbackStats& stats);
+        static std::vector<CallbackStats> GetCallbackStats();
 
     private:
         static std::unique_ptr<IGraphicsHook> s_ActiveHook;
+        static SubscriptionId s_DefaultSubscription;
     };
 
 #define DEBUG_LOG(fmt, ...) \
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace FrameJacker {
+
+    // Fixed-size, allocation-free callable used for every hook callback. The target is stored inline,
+    // so it must fit in Capacity bytes and be trivially copyable: free functions, captureless lambdas
+    // and lambdas capturing pointers, references or plain values all qualify. Copying a Delegate is a
+    // memcpy and invoking it is a single indirect call.
+    template<typename Signature, size_t Capacity = 4 * sizeof(void*)>
+    class Delegate;
+
+    template<typename R, typename... Args, size_t Capacity>
+    class Delegate<R(Args...), Capacity> {
+    public:
+        Delegate() = default;
+        Delegate(std::nullptr_t) {}
+
+        template<typename F, typename Fn = std::decay_t<F>,
+            typename = std::enable_if_t<!std::is_same_v<Fn, Delegate> && std::is_invocable_r_v<R, Fn&, Args...>>>
+        Delegate(F&& function) {
+            static_assert(sizeof(Fn) <= Capacity, "Callable is too large for Delegate, capture a pointer instead");
+            static_assert(alignof(Fn) <= alignof(std::max_align_t), "Callable is over-aligned for Delegate");
+            static_assert(std::is_trivially_copyable_v<Fn>, "Delegate requires a trivially copyable callable");
+
+            Fn target(std::forward<F>(function));
+            if constexpr (std::is_pointer_v<Fn>) {
+                if (!target)
+                    return;
+            }
+
+            ::new (static_cast<void*>(m_Storage)) Fn(target);
+            m_Invoker = &Invoke<Fn>;
+        }
+
+        Delegate& operator=(std::nullptr_t) {
+            m_Invoker = nullptr;
+            return *this;
+        }
+
+        explicit operator bool() const { return m_Invoker != nullptr; }
+
+        R operator()(Args... args) const {
+            return m_Invoker(m_Storage, std::forward<Args>(args)...);
+        }
+
+    private:
+        template<typename Fn>
+        static R Invoke(void* storage, Args... args) {
+            return (*static_cast<Fn*>(storage))(std::forward<Args>(args)...);
+        }
+
+        alignas(std::max_align_t) mutable unsigned char m_Storage[Capacity] = {};
+        R(*m_Invoker)(void*, Args...) = nullptr;
+    };
+
+}
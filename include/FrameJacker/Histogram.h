@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace FrameJacker {
+
+    // Log-linear histogram in the style of HdrHistogram. Values are grouped into power-of-two ranges
+    // that are each split into 2^(precisionBits - 1) equal buckets, so every recorded value is kept to
+    // within 1 / 2^(precisionBits - 1) of its true value (precisionBits = 8: 0.8%) using constant
+    // memory. Record is a single relaxed atomic increment and never allocates or locks, so one thread
+    // may record while others copy, merge or query the histogram.
+    class Histogram {
+    public:
+        static constexpr uint64_t kDefaultHighestValue = 60000000000ull;   // 60 s in nanoseconds
+        static constexpr uint32_t kDefaultPrecisionBits = 8;
+
+        explicit Histogram(uint64_t highestValue = kDefaultHighestValue, uint32_t precisionBits = kDefaultPrecisionBits);
+        Histogram(const Histogram& other);
+        Histogram& operator=(const Histogram& other);
+
+        // Values above the highest trackable value are counted in the top bucket
+        void Record(uint64_t value, uint64_t count = 1);
+        void Reset();
+
+        // Both require a histogram with the same highest value and precision and return false
+        // otherwise. Subtract turns two snapshots of the same histogram into the interval between them.
+        bool Merge(const Histogram& other);
+        bool Subtract(const Histogram& other);
+        bool IsCompatible(const Histogram& other) const;
+
+        uint64_t GetTotalCount() const;
+        uint64_t GetMin() const;
+        uint64_t GetMax() const;
+        double GetMean() const;
+        uint64_t GetValueAtPercentile(double percentile) const;     // percentile in [0, 100]
+
+        uint64_t GetHighestValue() const { return m_HighestValue; }
+        uint32_t GetPrecisionBits() const { return m_PrecisionBits; }
+        size_t GetBucketCount() const { return m_BucketCount; }
+        size_t GetMemorySize() const { return m_BucketCount * sizeof(uint64_t); }
+
+        // Smallest and largest value that share a bucket with value
+        uint64_t GetLowestEquivalent(uint64_t value) const;
+        uint64_t GetHighestEquivalent(uint64_t value) const;
+
+    private:
+        size_t IndexOf(uint64_t value) const;
+        uint64_t LowestOf(size_t index) const;
+        uint64_t HighestOf(size_t index) const;
+
+        uint64_t m_HighestValue;
+        uint32_t m_PrecisionBits;
+        uint64_t m_SubBucketCount;
+        uint64_t m_SubBucketHalfCount;
+        size_t m_BucketCount;
+        std::unique_ptr<std::atomic<uint64_t>[]> m_Counts;
+    };
+
+}
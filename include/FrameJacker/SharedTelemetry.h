@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace FrameJacker {
+
+    // Layout of the shared memory ring FrameJacker publishes frame records into (see
+    // Stats::SetSharedTelemetryEnabled). Only fixed-width fields, so 32 and 64-bit processes can
+    // share it. The ring is named after the game's process id.
+    static constexpr uint32_t kSharedTelemetryMagic = 0x524A4A46;  // "FJJR"
+    static constexpr uint32_t kSharedTelemetryVersion = 1;
+
+    // Each slot carries its own sequence: 2n + 1 while record n is being written, 2n + 2 once it
+    // is complete. A reader that sees a different value before and after copying lost a race with
+    // the writer and must discard the copy.
+    struct alignas(8) SharedFrameRecord {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> frameIndex;
+        std::atomic<uint64_t> timestamp;            // Present hook entry, nanoseconds on a monotonic clock
+        std::atomic<uint64_t> frameDuration;        // Present-to-present time of the previous frame
+        std::atomic<uint64_t> presentDuration;      // Time blocked inside the original present
+        std::atomic<uint32_t> api;                  // FrameJacker::API
+        std::atomic<uint32_t> width;                // Back buffer size, 0 if unknown
+        std::atomic<uint32_t> height;
+        std::atomic<uint32_t> reserved;
+    };
+
+    struct alignas(64) SharedTelemetryHeader {
+        std::atomic<uint32_t> magic;                // Written last, once the header is valid
+        uint32_t version;
+        uint32_t capacity;                          // Number of records, a power of two
+        uint32_t recordSize;
+        uint32_t headerSize;
+        uint32_t processId;
+        std::atomic<uint64_t> published;            // Records started so far, record n lives in slot n % capacity
+    };
+
+    static_assert(sizeof(SharedFrameRecord) == 56, "SharedFrameRecord layout changed");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared telemetry needs lock-free 64-bit atomics");
+
+    inline void FormatSharedTelemetryName(uint32_t processId, char* name, size_t size) {
+#ifdef _WIN32
+        snprintf(name, size, "Local\\FrameJacker.Telemetry.%u", processId);
+#else
+        snprintf(name, size, "/FrameJacker.Telemetry.%u", processId);
+#endif
+    }
+
+    // Plain copy of one record as handed out by SharedTelemetryReader
+    struct FrameRecord {
+        uint64_t frameIndex;
+        uint64_t timestamp;
+        uint64_t frameDuration;
+        uint64_t presentDuration;
+        uint32_t api;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // Reader side for monitoring tools running in another process. Polling never blocks or
+    // signals the game; a reader that polls too slowly just misses records.
+    class SharedTelemetryReader {
+    public:
+        SharedTelemetryReader() = default;
+        ~SharedTelemetryReader();
+
+        SharedTelemetryReader(const SharedTelemetryReader&) = delete;
+        SharedTelemetryReader& operator=(const SharedTelemetryReader&) = delete;
+
+        bool Open(uint32_t processId);
+        void Close();
+        bool IsOpen() const { return m_Header != nullptr; }
+
+        // Copies up to maxRecords records published since the previous call, oldest first. Starts
+        // with the oldest record still in the ring after Open.
+        size_t Read(FrameRecord* records, size_t maxRecords);
+
+        // Records that were overwritten before they could be read
+        uint64_t GetMissed() const { return m_Missed; }
+
+    private:
+        void* m_Mapping = nullptr;
+        const SharedTelemetryHeader* m_Header = nullptr;
+        const SharedFrameRecord* m_Records = nullptr;
+        uint64_t m_Next = 0;
+        uint64_t m_Missed = 0;
+    };
+
+}
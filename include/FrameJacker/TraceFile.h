@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace FrameJacker {
+
+    // On-disk format written by Trace::Start: a TraceFileHeader followed by blocks, each a
+    // TraceBlockHeader and its records, LZ4 block compressed when that made them smaller. Blocks
+    // come from different presenting threads, so records are only ordered within a block.
+    static constexpr char kTraceMagic[8] = { 'F', 'J', 'T', 'R', 'A', 'C', 'E', 0 };
+    static constexpr uint32_t kTraceVersion = 1;
+
+    struct TraceFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t startTimestamp;        // Clock at Trace::Start, nanoseconds
+    };
+
+    enum TraceBlockFlags : uint32_t {
+        TraceBlockCompressed = 1,
+    };
+
+    struct TraceBlockHeader {
+        uint32_t storedSize;            // Bytes following this header
+        uint32_t recordCount;
+        uint32_t threadId;
+        uint32_t flags;                 // TraceBlockFlags
+    };
+
+    struct TraceRecord {
+        uint64_t frameIndex;
+        uint64_t timestamp;             // Present hook entry, nanoseconds
+        uint64_t frameDuration;         // Present-to-present time of the previous frame
+        uint64_t presentDuration;       // Time blocked inside the original present
+        uint32_t width;
+        uint32_t height;
+        uint8_t api;                    // FrameJacker::API
+        uint8_t syncInterval;
+        uint16_t flags;                 // DXGI present flags
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(TraceRecord) == 48, "TraceRecord layout changed");
+
+    struct TraceRecordEx : TraceRecord {
+        uint32_t threadId;
+    };
+
+    // Reads every record of a trace, sorted by frame index. Returns false if the file is missing or
+    // not a trace; a truncated final block (e.g. the game crashed) is skipped.
+    bool ReadTraceFile(const char* path, TraceFileHeader& header, std::vector<TraceRecordEx>& records);
+
+    // PresentMon-style CSV, one row per frame
+    bool ConvertTraceToCsv(const char* tracePath, const char* csvPath);
+
+}
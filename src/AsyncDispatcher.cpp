@@ -0,0 +1,145 @@
+#include "AsyncDispatcher.h"
+#include "TimelineRecorder.h"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FrameJacker {
+
+    static constexpr uint32_t kWorkerCount = 2;
+
+    struct AsyncWorker {
+        std::atomic<uint32_t> signal = 0;
+        std::atomic<bool> stop = false;
+        std::atomic<bool> running = false;
+    };
+
+    static AsyncWorker g_Workers[kWorkerCount];
+
+    static std::mutex g_ChannelsMutex;
+    static std::vector<std::shared_ptr<AsyncChannel>> g_Channels;
+    static std::atomic<uint32_t> g_ChannelsVersion = 1;
+    static uint32_t g_NextWorker = 0;
+
+    static void Wake(AsyncWorker& worker) {
+        worker.signal.fetch_add(1, std::memory_order_release);
+        worker.signal.notify_one();
+    }
+
+    static void WorkerMain(uint32_t index) {
+        AsyncWorker& worker = g_Workers[index];
+        std::vector<std::shared_ptr<AsyncChannel>> channels;
+        uint32_t version = 0;
+
+        DEBUG_LOG("Async worker %u started", index);
+
+        while (!worker.stop.load(std::memory_order_acquire)) {
+            uint32_t seen = worker.signal.load(std::memory_order_acquire);
+
+            if (g_ChannelsVersion.load(std::memory_order_acquire) != version) {
+                std::lock_guard<std::mutex> lock(g_ChannelsMutex);
+                channels.clear();
+                for (const auto& channel : g_Channels) {
+                    if (channel->worker == index)
+                        channels.push_back(channel);
+                }
+                version = g_ChannelsVersion.load(std::memory_order_relaxed);
+            }
+
+            bool idle = true;
+            for (const auto& channel : channels) {
+                FrameEvent frame;
+                while (channel->queue.TryPop(frame)) {
+                    idle = false;
+                    if (channel->closed.load(std::memory_order_relaxed))
+                        continue;
+
+                    TimelineScope timeline("OnPresent (async)", "frame", frame.frameIndex);
+                    channel->onPresent(frame);
+                    channel->delivered.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            if (idle)
+                worker.signal.wait(seen, std::memory_order_acquire);
+        }
+
+        DEBUG_LOG("Async worker %u stopped", index);
+        worker.running.store(false, std::memory_order_release);
+    }
+
+    std::shared_ptr<AsyncChannel> AsyncDispatcher::Attach(const Delegate<void(const FrameEvent&)>& onPresent) {
+        auto channel = std::make_shared<AsyncChannel>();
+        channel->onPresent = onPresent;
+
+        {
+            std::lock_guard<std::mutex> lock(g_ChannelsMutex);
+            channel->worker = g_NextWorker++ % kWorkerCount;
+            g_Channels.push_back(channel);
+            g_ChannelsVersion.fetch_add(1, std::memory_order_release);
+        }
+
+        Start();
+        Wake(g_Workers[channel->worker]);
+        return channel;
+    }
+
+    void AsyncDispatcher::Detach(const std::shared_ptr<AsyncChannel>& channel) {
+        channel->closed.store(true, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock(g_ChannelsMutex);
+            for (auto it = g_Channels.begin(); it != g_Channels.end(); ++it) {
+                if (*it == channel) {
+                    g_Channels.erase(it);
+                    break;
+                }
+            }
+            g_ChannelsVersion.fetch_add(1, std::memory_order_release);
+        }
+
+        Wake(g_Workers[channel->worker]);
+    }
+
+    void AsyncDispatcher::Post(AsyncChannel* channel, const FrameEvent& frame) {
+        if (!channel->queue.TryPush(frame)) {
+            channel->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Wake(g_Workers[channel->worker]);
+    }
+
+    void AsyncDispatcher::Start() {
+        std::lock_guard<std::mutex> lock(g_ChannelsMutex);
+        if (g_Channels.empty())
+            return;
+
+        for (uint32_t i = 0; i < kWorkerCount; i++) {
+            AsyncWorker& worker = g_Workers[i];
+            if (worker.running.load(std::memory_order_acquire))
+                continue;
+
+            worker.stop.store(false, std::memory_order_relaxed);
+            worker.running.store(true, std::memory_order_relaxed);
+            std::thread(WorkerMain, i).detach();
+        }
+    }
+
+    void AsyncDispatcher::Stop() {
+        for (auto& worker : g_Workers) {
+            worker.stop.store(true, std::memory_order_release);
+            Wake(worker);
+        }
+
+        // Shutdown is usually called from DllMain, where joining a thread deadlocks on the loader
+        // lock, so only wait (bounded) for the workers to leave their loop.
+        for (auto& worker : g_Workers) {
+            for (int i = 0; i < 1000 && worker.running.load(std::memory_order_acquire); i++)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "FrameJacker.h"
+#include "MpscQueue.h"
+#include <atomic>
+#include <memory>
+
+namespace FrameJacker {
+
+    // Per-subscriber mailbox for Callbacks::Async subscribers. The render thread pushes, the worker
+    // that owns the channel drains it.
+    struct AsyncChannel {
+        Delegate<void(const FrameEvent&)> onPresent;
+        uint32_t worker = 0;
+        MpscQueue<FrameEvent, 256> queue;
+        std::atomic<uint64_t> delivered = 0;
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<bool> closed = false;
+    };
+
+    class AsyncDispatcher {
+    public:
+        static std::shared_ptr<AsyncChannel> Attach(const Delegate<void(const FrameEvent&)>& onPresent);
+        static void Detach(const std::shared_ptr<AsyncChannel>& channel);
+
+        static void Post(AsyncChannel* channel, const FrameEvent& frame);
+
+        static void Start();
+        static void Stop();
+    };
+
+}
@@ -0,0 +1,148 @@
+#include "BlockCompression.h"
+#include <cstdint>
+#include <cstring>
+
+namespace FrameJacker {
+
+    static constexpr size_t kMinMatch = 4;
+    static constexpr size_t kLastLiterals = 5;         // The format requires the block to end in literals
+    static constexpr size_t kMatchSearchLimit = 12;     // No match may start within 12 bytes of the end
+    static constexpr uint32_t kHashBits = 12;
+    static constexpr size_t kMaxOffset = 65535;
+
+    static uint32_t Read32(const uint8_t* data) {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static uint32_t Hash(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - kHashBits);
+    }
+
+    static uint8_t* WriteLength(uint8_t* out, size_t length) {
+        for (; length >= 255; length -= 255)
+            *out++ = 255;
+        *out++ = (uint8_t)length;
+        return out;
+    }
+
+    size_t BlockCompression::Compress(const void* source, size_t size, void* destination, size_t capacity) {
+        if (capacity < GetBound(size))
+            return 0;
+
+        const uint8_t* input = static_cast<const uint8_t*>(source);
+        const uint8_t* end = input + size;
+        const uint8_t* anchor = input;
+        uint8_t* out = static_cast<uint8_t*>(destination);
+        uint32_t table[1 << kHashBits] = {};     // Position + 1, 0 = empty
+
+        if (size > kMatchSearchLimit) {
+            const uint8_t* matchEnd = end - kLastLiterals;
+            const uint8_t* searchEnd = end - kMatchSearchLimit;
+
+            for (const uint8_t* ip = input; ip < searchEnd;) {
+                uint32_t sequence = Read32(ip);
+                uint32_t& entry = table[Hash(sequence)];
+                const uint8_t* match = entry ? input + entry - 1 : nullptr;
+                entry = (uint32_t)(ip - input) + 1;
+
+                if (!match || (size_t)(ip - match) > kMaxOffset || Read32(match) != sequence) {
+                    ip++;
+                    continue;
+                }
+
+                size_t matchLength = kMinMatch;
+                while (ip + matchLength < matchEnd && match[matchLength] == ip[matchLength])
+                    matchLength++;
+
+                size_t literalLength = (size_t)(ip - anchor);
+                uint8_t* token = out++;
+                *token = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+                if (literalLength >= 15)
+                    out = WriteLength(out, literalLength - 15);
+                memcpy(out, anchor, literalLength);
+                out += literalLength;
+
+                uint16_t offset = (uint16_t)(ip - match);
+                *out++ = (uint8_t)offset;
+                *out++ = (uint8_t)(offset >> 8);
+
+                size_t extraLength = matchLength - kMinMatch;
+                *token |= (uint8_t)(extraLength >= 15 ? 15 : extraLength);
+                if (extraLength >= 15)
+                    out = WriteLength(out, extraLength - 15);
+
+                ip += matchLength;
+                anchor = ip;
+            }
+        }
+
+        size_t literalLength = (size_t)(end - anchor);
+        *out++ = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+        if (literalLength >= 15)
+            out = WriteLength(out, literalLength - 15);
+        memcpy(out, anchor, literalLength);
+        out += literalLength;
+
+        size_t compressed = (size_t)(out - static_cast<uint8_t*>(destination));
+        return compressed < size ? compressed : 0;
+    }
+
+    bool BlockCompression::Decompress(const void* source, size_t size, void* destination, size_t decompressedSize) {
+        const uint8_t* in = static_cast<const uint8_t*>(source);
+        const uint8_t* inEnd = in + size;
+        uint8_t* out = static_cast<uint8_t*>(destination);
+        uint8_t* outStart = out;
+        uint8_t* outEnd = out + decompressedSize;
+
+        auto readLength = [&](size_t length) -> size_t {
+            if (length != 15)
+                return length;
+            uint8_t next;
+            do {
+                if (in >= inEnd)
+                    return SIZE_MAX;
+                next = *in++;
+                length += next;
+            } while (next == 255);
+            return length;
+        };
+
+        while (in < inEnd) {
+            uint8_t token = *in++;
+
+            size_t literalLength = readLength(token >> 4);
+            if (literalLength == SIZE_MAX || literalLength > (size_t)(inEnd - in) || literalLength > (size_t)(outEnd - out))
+                return false;
+            memcpy(out, in, literalLength);
+            in += literalLength;
+            out += literalLength;
+
+            if (in == inEnd)
+                break;  // Last sequence has no match
+
+            if (inEnd - in < 2)
+                return false;
+            size_t offset = (size_t)in[0] | (size_t)in[1] << 8;
+            in += 2;
+
+            size_t matchLength = readLength(token & 15);
+            if (matchLength == SIZE_MAX)
+                return false;
+            matchLength += kMinMatch;
+
+            if (!offset || offset > (size_t)(out - outStart) || matchLength > (size_t)(outEnd - out))
+                return false;
+
+            // Byte by byte, matches may overlap their own output
+            const uint8_t* match = out - offset;
+            for (size_t i = 0; i < matchLength; i++)
+                out[i] = match[i];
+            out += matchLength;
+        }
+
+        return out == outEnd;
+    }
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+namespace FrameJacker {
+
+    // LZ4 block format compressor (greedy, single hash probe). Fast enough to keep up with trace
+    // blocks on a background thread, and readable by any LZ4 block decoder.
+    class BlockCompression {
+    public:
+        static size_t GetBound(size_t size) { return size + size / 255 + 16; }
+
+        // Returns the compressed size, or 0 if the data did not shrink or did not fit
+        static size_t Compress(const void* source, size_t size, void* destination, size_t capacity);
+
+        // Returns false on malformed input or if the output is not exactly decompressedSize bytes
+        static bool Decompress(const void* source, size_t size, void* destination, size_t decompressedSize);
+    };
+
+}
@@ -0,0 +1,286 @@
+#include "CallbackRegistry.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+namespace FrameJacker {
+
+    static const CallbackSnapshot g_EmptySnapshot = {};
+    static std::atomic<const CallbackSnapshot*> g_CurrentSnapshot = &g_EmptySnapshot;
+
+    // Epoch-based reclamation. Every reading thread owns a slot holding the epoch it entered at (0
+    // while idle). An object retired at epoch e can only still be seen by readers whose slot is
+    // at most e, so it is freed as soon as no slot is, without waiting for all readers to go idle.
+    struct ReaderSlot {
+        std::atomic<uint64_t> epoch = 0;
+        uint32_t depth = 0;                 // Owning thread only, hooks can nest
+        ReaderSlot* next = nullptr;
+    };
+
+    struct RetiredObject {
+        void* object;
+        void (*destroy)(void*);
+        uint64_t epoch;
+    };
+
+    static std::atomic<uint64_t> g_Epoch = 1;
+    static std::atomic<ReaderSlot*> g_ReaderSlots = nullptr;       // Never freed, one per thread that ever read
+    static thread_local ReaderSlot* t_ReaderSlot = nullptr;
+
+    static std::mutex g_RetiredMutex;
+    static std::vector<RetiredObject> g_RetiredObjects;
+    static std::atomic<uint32_t> g_RetiredCount = 0;
+
+    // Writer-side state, only touched with g_WriterMutex held
+    static std::mutex g_WriterMutex;
+    static std::vector<Subscriber> g_Subscribers;
+    static SubscriptionId g_NextSubscriptionId = 1;
+
+    static ReaderSlot* AcquireReaderSlot() {
+        auto* slot = new ReaderSlot();
+        ReaderSlot* head = g_ReaderSlots.load(std::memory_order_relaxed);
+        do {
+            slot->next = head;
+        } while (!g_ReaderSlots.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+        return slot;
+    }
+
+    // g_RetiredMutex held
+    static void FreeRetiredObjects() {
+        uint64_t oldest = UINT64_MAX;
+        for (ReaderSlot* slot = g_ReaderSlots.load(std::memory_order_acquire); slot; slot = slot->next) {
+            uint64_t epoch = slot->epoch.load();
+            if (epoch && epoch < oldest)
+                oldest = epoch;
+        }
+
+        auto end = std::remove_if(g_RetiredObjects.begin(), g_RetiredObjects.end(), [&](const RetiredObject& retired) {
+            if (retired.epoch < oldest) {
+                retired.destroy(retired.object);
+                return true;
+            }
+            return false;
+        });
+        g_RetiredObjects.erase(end, g_RetiredObjects.end());
+        g_RetiredCount.store((uint32_t)g_RetiredObjects.size(), std::memory_order_relaxed);
+    }
+
+    const CallbackSnapshot* CallbackRegistry::EnterRead() {
+        ReaderSlot* slot = t_ReaderSlot;
+        if (!slot)
+            slot = t_ReaderSlot = AcquireReaderSlot();
+
+        // Publishing the epoch before loading the snapshot is what makes the check in
+        // FreeRetiredObjects sound, so both stay sequentially consistent
+        if (slot->depth++ == 0)
+            slot->epoch.store(g_Epoch.load());
+        return g_CurrentSnapshot.load();
+    }
+
+    void CallbackRegistry::LeaveRead() {
+        ReaderSlot* slot = t_ReaderSlot;
+        if (--slot->depth)
+            return;
+        slot->epoch.store(0, std::memory_order_release);
+
+        // Objects retired while this thread was reading would otherwise wait for the next publish.
+        // Never block the render thread for it.
+        if (g_RetiredCount.load(std::memory_order_relaxed) && g_RetiredMutex.try_lock()) {
+            FreeRetiredObjects();
+            g_RetiredMutex.unlock();
+        }
+    }
+
+    size_t CallbackRegistry::GetRetiredSnapshotCount() {
+        return g_RetiredCount.load(std::memory_order_relaxed);
+    }
+
+    void CallbackRegistry::Retire(void* object, void (*destroy)(void*)) {
+        // Readers entering from here on see at least the new epoch, and with it whatever replaced
+        // the object. Never wait for the others: this may be called from inside a callback.
+        uint64_t epoch = g_Epoch.fetch_add(1);
+        std::lock_guard<std::mutex> lock(g_RetiredMutex);
+        g_RetiredObjects.push_back({ object, destroy, epoch });
+        FreeRetiredObjects();
+    }
+
+    static std::shared_ptr<AsyncChannel> AttachIfAsync(const Callbacks& callbacks) {
+        if (!callbacks.Async || !callbacks.OnPresent)
+            return nullptr;
+        return AsyncDispatcher::Attach(callbacks.OnPresent);
+    }
+
+    static std::shared_ptr<SubscriberState> CreateState(SubscriptionId id, const Callbacks& callbacks) {
+        auto state = std::make_shared<SubscriberState>();
+        state->id = id;
+        state->budgetNanoseconds = (uint64_t)(callbacks.BudgetMicroseconds * 1000.0);
+        state->throttleInterval = callbacks.ThrottleInterval ? callbacks.ThrottleInterval : 1;
+        return state;
+    }
+
+    void SubscriberState::EndFrame() {
+        uint64_t elapsed = frameNanoseconds.exchange(0, std::memory_order_relaxed);
+
+        if (runThisFrame.load(std::memory_order_relaxed)) {
+            uint64_t average = averageNanoseconds.load(std::memory_order_relaxed);
+            average = frames.load(std::memory_order_relaxed) == 0 ? elapsed : average - average / 16 + elapsed / 16;
+
+            frames.fetch_add(1, std::memory_order_relaxed);
+            lastNanoseconds.store(elapsed, std::memory_order_relaxed);
+            averageNanoseconds.store(average, std::memory_order_relaxed);
+            if (elapsed > maxNanoseconds.load(std::memory_order_relaxed))
+                maxNanoseconds.store(elapsed, std::memory_order_relaxed);
+
+            // Only re-evaluated on frames that actually ran, so a throttled subscriber is judged on
+            // what a single run costs. Releasing at half the budget keeps it from flapping.
+            if (budgetNanoseconds) {
+                bool wasThrottled = throttled.load(std::memory_order_relaxed);
+                if (!wasThrottled && average > budgetNanoseconds) {
+                    throttled.store(true, std::memory_order_relaxed);
+                    DEBUG_LOG("Subscriber %u over budget (%.1f us), running every %u frames",
+                        id, average / 1000.0, throttleInterval);
+                }
+                else if (wasThrottled && average < budgetNanoseconds / 2) {
+                    throttled.store(false, std::memory_order_relaxed);
+                    DEBUG_LOG("Subscriber %u back within budget (%.1f us)", id, average / 1000.0);
+                }
+            }
+        }
+        else {
+            // Events still ran, charge them to the next frame the subscriber runs
+            skippedFrames.fetch_add(1, std::memory_order_relaxed);
+            if (elapsed)
+                frameNanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        }
+
+        bool runNext = true;
+        if (throttled.load(std::memory_order_relaxed)) {
+            uint32_t sinceRun = framesSinceRun.load(std::memory_order_relaxed) + 1;
+            runNext = sinceRun >= throttleInterval;
+            framesSinceRun.store(runNext ? 0 : sinceRun, std::memory_order_relaxed);
+        }
+        runThisFrame.store(runNext, std::memory_order_relaxed);
+    }
+
+    CallbackStats SubscriberState::GetStats() const {
+        CallbackStats stats = {};
+        stats.id = id;
+        stats.frames = frames.load(std::memory_order_relaxed);
+        stats.skippedFrames = skippedFrames.load(std::memory_order_relaxed);
+        stats.lastMicroseconds = lastNanoseconds.load(std::memory_order_relaxed) / 1000.0;
+        stats.averageMicroseconds = averageNanoseconds.load(std::memory_order_relaxed) / 1000.0;
+        stats.maxMicroseconds = maxNanoseconds.load(std::memory_order_relaxed) / 1000.0;
+        stats.throttled = throttled.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void CallbackRegistry::Publish(std::vector<Subscriber> subscribers) {
+        std::vector<const Subscriber*> ordered;
+        for (const auto& subscriber : subscribers)
+            ordered.push_back(&subscriber);
+        std::stable_sort(ordered.begin(), ordered.end(), [](const Subscriber* a, const Subscriber* b) {
+            return a->callbacks.Priority < b->callbacks.Priority;
+        });
+
+        auto* snapshot = new CallbackSnapshot();
+        for (const Subscriber* subscriber : ordered) {
+            const Callbacks& callbacks = subscriber->callbacks;
+            SubscriberState* state = subscriber->state.get();
+
+            if (subscriber->asyncChannel) snapshot->asyncPresent.push_back(subscriber->asyncChannel.get());
+            else if (callbacks.OnPresent) snapshot->onPresent.push_back({ callbacks.OnPresent, state });
+            if (callbacks.OnResize) snapshot->onResize.push_back({ callbacks.OnResize, state });
+            if (callbacks.OnDeviceCreated) snapshot->onDeviceCreated.push_back({ callbacks.OnDeviceCreated, state });
+            if (callbacks.OnRender) snapshot->onRender.push_back({ callbacks.OnRender, state });
+            if (callbacks.OnPostPresent) snapshot->onPostPresent.push_back({ callbacks.OnPostPresent, state });
+            if (callbacks.OnStutter) snapshot->onStutter.push_back({ callbacks.OnStutter, state });
+
+            if ((callbacks.OnPresent && !subscriber->asyncChannel) || callbacks.OnResize || callbacks.OnDeviceCreated
+                || callbacks.OnRender || callbacks.OnPostPresent || callbacks.OnStutter)
+                snapshot->timedStates.push_back(state);
+        }
+        snapshot->subscribers = std::move(subscribers);
+
+        const CallbackSnapshot* previous = g_CurrentSnapshot.exchange(snapshot);
+        if (previous != &g_EmptySnapshot)
+            Retire((void*)previous, [](void* object) { delete static_cast<const CallbackSnapshot*>(object); });
+    }
+
+    SubscriptionId CallbackRegistry::Subscribe(const Callbacks& callbacks) {
+        std::lock_guard<std::mutex> lock(g_WriterMutex);
+
+        SubscriptionId id = g_NextSubscriptionId++;
+        g_Subscribers.push_back({ id, callbacks, AttachIfAsync(callbacks), CreateState(id, callbacks) });
+        Publish(g_Subscribers);
+
+        DEBUG_LOG("Subscriber %u added (%zu total)", id, g_Subscribers.size());
+        return id;
+    }
+
+    bool CallbackRegistry::Replace(SubscriptionId id, const Callbacks& callbacks) {
+        std::lock_guard<std::mutex> lock(g_WriterMutex);
+
+        for (auto& subscriber : g_Subscribers) {
+            if (subscriber.id == id) {
+                if (subscriber.asyncChannel)
+                    AsyncDispatcher::Detach(subscriber.asyncChannel);
+                subscriber.callbacks = callbacks;
+                subscriber.asyncChannel = AttachIfAsync(callbacks);
+                subscriber.state = CreateState(id, callbacks);
+                Publish(g_Subscribers);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool CallbackRegistry::Unsubscribe(SubscriptionId id) {
+        std::lock_guard<std::mutex> lock(g_WriterMutex);
+
+        for (auto it = g_Subscribers.begin(); it != g_Subscribers.end(); ++it) {
+            if (it->id == id) {
+                if (it->asyncChannel)
+                    AsyncDispatcher::Detach(it->asyncChannel);
+                g_Subscribers.erase(it);
+                Publish(g_Subscribers);
+                DEBUG_LOG("Subscriber %u removed (%zu remaining)", id, g_Subscribers.size());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t CallbackRegistry::GetDroppedEvents(SubscriptionId id) {
+        std::lock_guard<std::mutex> lock(g_WriterMutex);
+
+        for (const auto& subscriber : g_Subscribers) {
+            if (subscriber.id == id && subscriber.asyncChannel)
+                return subscriber.asyncChannel->dropped.load(std::memory_order_relaxed);
+        }
+        return 0;
+    }
+
+    bool CallbackRegistry::GetCallbackStats(SubscriptionId id, CallbackStats& stats) {
+        std::lock_guard<std::mutex> lock(g_WriterMutex);
+
+        for (const auto& subscriber : g_Subscribers) {
+            if (subscriber.id == id) {
+                stats = subscriber.state->GetStats();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<CallbackStats> CallbackRegistry::GetCallbackStats() {
+        std::lock_guard<std::mutex> lock(g_WriterMutex);
+
+        std::vector<CallbackStats> stats;
+        stats.reserve(g_Subscribers.size());
+        for (const auto& subscriber : g_Subscribers)
+            stats.push_back(subscriber.state->GetStats());
+        return stats;
+    }
+
+}
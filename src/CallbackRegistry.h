@@ -0,0 +1,238 @@
+#pragma once
+#include "FrameJacker.h"
+#include "AsyncDispatcher.h"
+#include "Clock.h"
+#include "FramePacer.h"
+#include "FrameTracker.h"
+#include "LatencyScheduler.h"
+#include "ResizeCoalescer.h"
+#include "StutterDetector.h"
+#include "TimelineRecorder.h"
+#include <vector>
+
+namespace FrameJacker {
+
+    // Cost accounting and throttling for one subscriber's render-thread callbacks. Written by the
+    // render thread, read by GetCallbackStats from any thread.
+    struct SubscriberState {
+        SubscriptionId id = 0;
+        uint64_t budgetNanoseconds = 0;
+        uint32_t throttleInterval = 1;
+
+        std::atomic<bool> runThisFrame = true;
+        std::atomic<uint64_t> frameNanoseconds = 0;
+        std::atomic<uint32_t> framesSinceRun = 0;
+
+        std::atomic<uint64_t> frames = 0;
+        std::atomic<uint64_t> skippedFrames = 0;
+        std::atomic<uint64_t> lastNanoseconds = 0;
+        std::atomic<uint64_t> averageNanoseconds = 0;
+        std::atomic<uint64_t> maxNanoseconds = 0;
+        std::atomic<bool> throttled = false;
+
+        void EndFrame();
+        CallbackStats GetStats() const;
+    };
+
+    struct Subscriber {
+        SubscriptionId id;
+        Callbacks callbacks;
+        std::shared_ptr<AsyncChannel> asyncChannel;
+        std::shared_ptr<SubscriberState> state;
+    };
+
+    template<typename Signature>
+    struct TimedCallback {
+        Delegate<Signature> callback;
+        SubscriberState* state;
+    };
+
+    // Published once and never modified afterwards, so the hooks can read it without locking.
+    struct CallbackSnapshot {
+        std::vector<Subscriber> subscribers;
+        std::vector<SubscriberState*> timedStates;
+        std::vector<TimedCallback<void(const FrameEvent&)>> onPresent;
+        std::vector<AsyncChannel*> asyncPresent;
+        std::vector<TimedCallback<void(const ResizeEvent&)>> onResize;
+        std::vector<TimedCallback<void(void*)>> onDeviceCreated;
+        std::vector<TimedCallback<void(const RenderContext&)>> onRender;
+        std::vector<TimedCallback<void(const FrameEvent&)>> onPostPresent;
+        std::vector<TimedCallback<void(const StutterEvent&)>> onStutter;
+    };
+
+    class CallbackRegistry {
+    public:
+        static SubscriptionId Subscribe(const Callbacks& callbacks);
+        static bool Replace(SubscriptionId id, const Callbacks& callbacks);
+        static bool Unsubscribe(SubscriptionId id);
+        static uint64_t GetDroppedEvents(SubscriptionId id);
+        static bool GetCallbackStats(SubscriptionId id, CallbackStats& stats);
+        static std::vector<CallbackStats> GetCallbackStats();
+
+        static const CallbackSnapshot* EnterRead();
+        static void LeaveRead();
+
+        // Frees object once every thread that was between EnterRead and LeaveRead has left. Anything
+        // the present hooks load inside a CallbackScope can be replaced and handed over here.
+        static void Retire(void* object, void (*destroy)(void*));
+
+        // Snapshots (and other retired objects) not freed yet
+        static size_t GetRetiredSnapshotCount();
+
+    private:
+        static void Publish(std::vector<Subscriber> subscribers);
+    };
+
+    // Pins the current snapshot for the lifetime of a hook call. Subscribers added or removed
+    // while a hook is running take effect on the next call.
+    class CallbackScope {
+    public:
+        CallbackScope() : m_Snapshot(CallbackRegistry::EnterRead()) {}
+
+        ~CallbackScope() {
+            // Whatever the present hook spent outside the original call and user callbacks is ours
+            if (m_Frame.timestamp) {
+                uint64_t now = Clock::Now();
+                FrameTracker::EndFrame(now - m_Frame.timestamp - m_Frame.presentDuration - m_CallbackNanoseconds - m_WaitNanoseconds);
+                TimelineRecorder::Complete("Present", m_Frame.timestamp, now, "frame", m_Frame.frameIndex);
+            }
+            CallbackRegistry::LeaveRead();
+        }
+
+        CallbackScope(const CallbackScope&) = delete;
+        CallbackScope& operator=(const CallbackScope&) = delete;
+
+        // Present hooks call this first thing, before any other work
+        void BeginFrame(API api, void* swapChain, uint32_t syncInterval = 0, uint32_t flags = 0, void* queue = nullptr) {
+            m_Frame.api = api;
+            m_Frame.syncInterval = syncInterval;
+            m_Frame.flags = flags;
+            m_Frame.swapChain = swapChain;
+            m_Frame.queue = queue;
+            FrameTracker::BeginFrame(m_Frame);
+        }
+
+        const FrameEvent& GetFrame() const { return m_Frame; }
+
+        void OnPresent() const {
+            ResizeEvent resize;
+            if (ResizeCoalescer::TakeSettled(m_Frame.timestamp, resize))
+                DispatchResize(resize);
+
+            for (const auto& entry : m_Snapshot->onPresent)
+                Invoke("OnPresent", entry, m_Frame);
+
+            for (AsyncChannel* channel : m_Snapshot->asyncPresent)
+                AsyncDispatcher::Post(channel, m_Frame);
+        }
+
+        // Resize hooks call this before the original resize
+        void OnResize(ResizeEvent resize) const {
+            resize.settled = !ResizeCoalescer::IsEnabled();
+            DispatchResize(resize);
+        }
+
+        // And this once it has succeeded, with the final size filled in
+        bool IsCoalescingResize() const { return ResizeCoalescer::IsEnabled(); }
+        void DeferResize(const ResizeEvent& resize) const { ResizeCoalescer::Defer(resize); }
+
+        void OnDeviceCreated(void* device) const {
+            for (const auto& entry : m_Snapshot->onDeviceCreated)
+                Deliver("OnDeviceCreated", entry, device);
+        }
+
+        bool HasRender() const { return !m_Snapshot->onRender.empty(); }
+
+        void OnRender(const RenderContext& ctx) const {
+            for (const auto& entry : m_Snapshot->onRender)
+                Invoke("OnRender", entry, ctx);
+        }
+
+        // Present hooks call this right before the original present, and OnPostPresent right after it.
+        // The frame limiter holds the present back here.
+        void BeginOriginalPresent() {
+            m_SubmitTime = Clock::Now();
+            if (FramePacer::IsEnabled()) {
+                uint64_t start = Clock::Now();
+                m_WaitNanoseconds += FramePacer::Wait();
+                TimelineRecorder::Complete("FrameLimit", start, Clock::Now());
+            }
+            m_PresentStart = Clock::Now();
+        }
+
+        void OnPostPresent() {
+            if (m_PresentStart) {
+                m_Frame.presentDuration = Clock::Now() - m_PresentStart;
+                FrameTracker::EndPresent(m_Frame);
+                TimelineRecorder::Complete("OriginalPresent", m_PresentStart, m_PresentStart + m_Frame.presentDuration,
+                    "frame", m_Frame.frameIndex);
+            }
+
+            for (const auto& entry : m_Snapshot->onPostPresent)
+                Invoke("OnPostPresent", entry, m_Frame);
+
+            if (m_PresentStart) {
+                if (const StutterEvent* stutter = StutterDetector::Update(m_Frame)) {
+                    TimelineRecorder::Instant("Stutter", "frame", m_Frame.frameIndex);
+                    for (const auto& entry : m_Snapshot->onStutter)
+                        Deliver("OnStutter", entry, *stutter);
+                }
+            }
+
+            for (SubscriberState* state : m_Snapshot->timedStates)
+                state->EndFrame();
+
+            // Last, so the game's next frame starts right when the hook returns
+            if (m_PresentStart && LatencyScheduler::IsEnabled()) {
+                uint64_t start = Clock::Now();
+                if (uint64_t delay = LatencyScheduler::Delay(m_Frame.swapChain, m_SubmitTime, m_PresentStart + m_Frame.presentDuration)) {
+                    m_WaitNanoseconds += delay;
+                    TimelineRecorder::Complete("LatencyDelay", start, start + delay);
+                }
+            }
+        }
+
+        // Time the present hook spent blocked for the game after OnPostPresent, not our overhead
+        void AddWait(uint64_t nanoseconds) { m_WaitNanoseconds += nanoseconds; }
+
+    private:
+        void DispatchResize(const ResizeEvent& resize) const {
+            StutterDetector::NoteResize();
+            LatencyScheduler::NoteResize();
+            TimelineRecorder::Instant(resize.settled ? "Resize (settled)" : "Resize", "width", resize.width, "height", resize.height);
+            for (const auto& entry : m_Snapshot->onResize)
+                Deliver("OnResize", entry, resize);
+        }
+
+        // Per-frame callbacks, skipped while the subscriber is throttled. name is the timeline event
+        // for the callback span, tagged with the subscriber.
+        template<typename Entry, typename... Args>
+        void Invoke(const char* name, const Entry& entry, const Args&... args) const {
+            if (entry.state->runThisFrame.load(std::memory_order_relaxed))
+                Deliver(name, entry, args...);
+        }
+
+        // Events (resize, stutter, device creation) always run, a throttled subscriber would miss
+        // them for good. Their cost still counts towards the subscriber's budget and is kept out of
+        // the hook overhead.
+        template<typename Entry, typename... Args>
+        void Deliver(const char* name, const Entry& entry, const Args&... args) const {
+            SubscriberState& state = *entry.state;
+            uint64_t start = Clock::Now();
+            entry.callback(args...);
+            uint64_t end = Clock::Now();
+            uint64_t elapsed = end - start;
+            TimelineRecorder::Complete(name, start, end, "subscriber", state.id);
+            state.frameNanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+            m_CallbackNanoseconds += elapsed;
+        }
+
+        const CallbackSnapshot* m_Snapshot;
+        FrameEvent m_Frame = {};
+        uint64_t m_SubmitTime = 0;
+        uint64_t m_PresentStart = 0;
+        uint64_t m_WaitNanoseconds = 0;     // Held back by the limiter or latency waits, not our overhead
+        mutable uint64_t m_CallbackNanoseconds = 0;
+    };
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace FrameJacker {
+
+    // Monotonic nanosecond clock behind every timestamp FrameJacker records. Backed by
+    // QueryPerformanceCounter on Windows and CLOCK_MONOTONIC elsewhere.
+    class Clock {
+    public:
+        static uint64_t Now() {
+#ifdef _WIN32
+            static const uint64_t frequency = QueryFrequency();
+            LARGE_INTEGER counter;
+            ::QueryPerformanceCounter(&counter);
+            uint64_t ticks = (uint64_t)counter.QuadPart;
+            return ticks / frequency * 1000000000ull + ticks % frequency * 1000000000ull / frequency;
+#else
+            timespec now;
+            ::clock_gettime(CLOCK_MONOTONIC, &now);
+            return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+        }
+
+    private:
+#ifdef _WIN32
+        static uint64_t QueryFrequency() {
+            LARGE_INTEGER frequency;
+            ::QueryPerformanceFrequency(&frequency);
+            return (uint64_t)frequency.QuadPart;
+        }
+#endif
+    };
+
+}
@@ -1,4 +1,5 @@
 #include "FrameJacker.h"
+#include "CallbackRegistry.h"
 #include <DetourMacros.hpp>
 #include <MemoryManager.h>
 #if FRAMEJACKER_INCLUDE_D3D10
@@ -130,16 +131,22 @@ namespace FrameJacker {
     }
 
     static HRESULT __stdcall DX10PresentHook(IDXGISwapChain* pSwapChain, UINT SyncInterval, UINT Flags) {
+        CallbackScope callbacks;
+        callbacks.BeginFrame(API::D3D10, pSwapChain, SyncInterval, Flags);
+
+        DXGI_SWAP_CHAIN_DESC desc;
+        if (!FrameTracker::HasSurfaceSize(pSwapChain) && SUCCEEDED(pSwapChain->GetDesc(&desc)))
+            FrameTracker::SetSurfaceSize(pSwapChain, desc.BufferDesc.Width, desc.BufferDesc.Height);
+
         g_SwapChain = pSwapChain;
 
         if (!g_Device && pSwapChain) {
             pSwapChain->GetDevice(__uuidof(ID3D10Device), (void**)&g_Device);
         }
 
-        if (Hook::s_Callbacks.OnPresent)
-            Hook::s_Callbacks.OnPresent();
+        callbacks.OnPresent();
 
-        if (Hook::s_Callbacks.OnRender && g_Device) {
+        if (callbacks.HasRender() && g_Device) {
             RenderContext ctx = {};
             ctx.api = API::D3D10;
             ctx.device = g_Device;
@@ -149,20 +156,39 @@ namespace FrameJacker {
             ctx.imageIndex = 0;
             ctx.extra = nullptr;
 
-            Hook::s_Callbacks.OnRender(ctx);
+            callbacks.OnRender(ctx);
         }
 
-        return DX10PresentOriginal(pSwapChain, SyncInterval, Flags);
+        callbacks.BeginOriginalPresent();
+        HRESULT result = DX10PresentOriginal(pSwapChain, SyncInterval, Flags);
+
+        callbacks.OnPostPresent();
+
+        return result;
     }
 
     static HRESULT __stdcall DX10ResizeBuffersHook(
         IDXGISwapChain* pSwapChain, UINT BufferCount, UINT Width, UINT Height,
         DXGI_FORMAT NewFormat, UINT SwapChainFlags) {
 
-        if (Hook::s_Callbacks.OnResize)
-            Hook::s_Callbacks.OnResize();
+        TimelineScope timeline("ResizeBuffers", "bufferCount", BufferCount);
+        CallbackScope callbacks;
+        ResizeEvent resize = { API::D3D10, Width, Height, (uint32_t)NewFormat, pSwapChain };
+        callbacks.OnResize(resize);
+
+        HRESULT result = DX10ResizeBuffersOriginal(pSwapChain, BufferCount, Width, Height, NewFormat, SwapChainFlags);
+
+        FrameTracker::InvalidateSurfaceSize();
+
+        DXGI_SWAP_CHAIN_DESC desc;
+        if (SUCCEEDED(result) && callbacks.IsCoalescingResize() && SUCCEEDED(pSwapChain->GetDesc(&desc))) {
+            resize.width = desc.BufferDesc.Width;
+            resize.height = desc.BufferDesc.Height;
+            resize.format = (uint32_t)desc.BufferDesc.Format;
+            callbacks.DeferResize(resize);
+        }
 
-        return DX10ResizeBuffersOriginal(pSwapChain, BufferCount, Width, Height, NewFormat, SwapChainFlags);
+        return result;
     }
 
     static DWORD WINAPI DX10InitThread(LPVOID lpParameter) {
@@ -1,8 +1,14 @@
 #include "FrameJacker.h"
+#include "CallbackRegistry.h"
+#include "DXGIFrameLatency.h"
+#include "DX11Overlay.h"
+#include "OverlayLayer.h"
+#include "WorkCounters.h"
 #include <DetourMacros.hpp>
 #include <MemoryManager.h>
 #if FRAMEJACKER_INCLUDE_D3D11
 #include <dxgi.h>
+#include <dxgi1_3.h>
 #include <d3d11.h>
 #endif
 
@@ -17,10 +23,52 @@ namespace FrameJacker {
         IDXGISwapChain* pSwapChain, UINT BufferCount, UINT Width, UINT Height,
         DXGI_FORMAT NewFormat, UINT SwapChainFlags);
 
+    DECLARE_HOOK(DX11GetFrameLatencyWaitableObject, HANDLE, __stdcall, __stdcall,
+        IDXGISwapChain2* pSwapChain);
+
+    // Immediate context draw statistics, installed on demand
+    DECLARE_HOOK(DX11DrawIndexed, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation);
+    DECLARE_HOOK(DX11Draw, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        UINT VertexCount, UINT StartVertexLocation);
+    DECLARE_HOOK(DX11Map, HRESULT, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        ID3D11Resource* pResource, UINT Subresource, D3D11_MAP MapType, UINT MapFlags, D3D11_MAPPED_SUBRESOURCE* pMappedResource);
+    DECLARE_HOOK(DX11Unmap, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        ID3D11Resource* pResource, UINT Subresource);
+    DECLARE_HOOK(DX11DrawIndexedInstanced, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation);
+    DECLARE_HOOK(DX11DrawInstanced, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation);
+    DECLARE_HOOK(DX11DrawAuto, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext);
+    DECLARE_HOOK(DX11DrawIndexedInstancedIndirect, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs);
+    DECLARE_HOOK(DX11DrawInstancedIndirect, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs);
+    DECLARE_HOOK(DX11Dispatch, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ);
+    DECLARE_HOOK(DX11DispatchIndirect, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs);
+    DECLARE_HOOK(DX11CopyResource, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        ID3D11Resource* pDstResource, ID3D11Resource* pSrcResource);
+    DECLARE_HOOK(DX11UpdateSubresource, void, __stdcall, __stdcall, ID3D11DeviceContext* pContext,
+        ID3D11Resource* pDstResource, UINT DstSubresource, const D3D11_BOX* pDstBox, const void* pSrcData,
+        UINT SrcRowPitch, UINT SrcDepthPitch);
+
+    // Context methods start after the swap chain (18) and device (43) entries
+    static constexpr uint32_t kContextMethods = 18 + 43;
+
     static uint150_t* g_MethodsTable = nullptr;
+    static uint150_t g_GetFrameLatencyWaitableObject = 0;     // IDXGISwapChain2, null before DXGI 1.3
     static IDXGISwapChain* g_SwapChain = nullptr;
     static ID3D11Device* g_Device = nullptr;
     static ID3D11DeviceContext* g_Context = nullptr;
+    static bool g_DrawHooksInstalled = false;
+
+    static const char* const g_DrawHookNames[] = {
+        "DX11DrawIndexed", "DX11Draw", "DX11Map", "DX11Unmap", "DX11DrawIndexedInstanced", "DX11DrawInstanced",
+        "DX11DrawAuto", "DX11DrawIndexedInstancedIndirect", "DX11DrawInstancedIndirect", "DX11Dispatch",
+        "DX11DispatchIndirect", "DX11CopyResource", "DX11UpdateSubresource"
+    };
 
     void DX11Hook::InitializeMethodTable() {
         DEBUG_LOG("DX11 InitMethodTable starting...");
@@ -94,6 +142,12 @@ namespace FrameJacker {
         ::memcpy(g_MethodsTable + 18, *(uint150_t**)device, 43 * sizeof(uint150_t));
         ::memcpy(g_MethodsTable + 18 + 43, *(uint150_t**)context, 144 * sizeof(uint150_t));
 
+        IDXGISwapChain2* swapChain2 = nullptr;
+        if (SUCCEEDED(swapChain->QueryInterface(__uuidof(IDXGISwapChain2), (void**)&swapChain2))) {
+            g_GetFrameLatencyWaitableObject = (*(uint150_t**)swapChain2)[33];
+            swapChain2->Release();
+        }
+
         swapChain->Release();
         device->Release();
         context->Release();
@@ -103,7 +157,113 @@ namespace FrameJacker {
         DEBUG_LOG("DX11 method table initialized");
     }
 
+    static void __stdcall DX11DrawIndexedHook(ID3D11DeviceContext* pContext,
+        UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        DX11DrawIndexedOriginal(pContext, IndexCount, StartIndexLocation, BaseVertexLocation);
+    }
+
+    static void __stdcall DX11DrawHook(ID3D11DeviceContext* pContext, UINT VertexCount, UINT StartVertexLocation) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        DX11DrawOriginal(pContext, VertexCount, StartVertexLocation);
+    }
+
+    static HRESULT __stdcall DX11MapHook(ID3D11DeviceContext* pContext,
+        ID3D11Resource* pResource, UINT Subresource, D3D11_MAP MapType, UINT MapFlags, D3D11_MAPPED_SUBRESOURCE* pMappedResource) {
+        WorkScope work(WorkCounter::Maps, WorkCounter::MapNanoseconds);
+        return DX11MapOriginal(pContext, pResource, Subresource, MapType, MapFlags, pMappedResource);
+    }
+
+    static void __stdcall DX11UnmapHook(ID3D11DeviceContext* pContext, ID3D11Resource* pResource, UINT Subresource) {
+        WorkScope work(WorkCounter::Unmaps, WorkCounter::MapNanoseconds);
+        DX11UnmapOriginal(pContext, pResource, Subresource);
+    }
+
+    static void __stdcall DX11DrawIndexedInstancedHook(ID3D11DeviceContext* pContext,
+        UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        DX11DrawIndexedInstancedOriginal(pContext, IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+    }
+
+    static void __stdcall DX11DrawInstancedHook(ID3D11DeviceContext* pContext,
+        UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        DX11DrawInstancedOriginal(pContext, VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
+    }
+
+    static void __stdcall DX11DrawAutoHook(ID3D11DeviceContext* pContext) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        DX11DrawAutoOriginal(pContext);
+    }
+
+    static void __stdcall DX11DrawIndexedInstancedIndirectHook(ID3D11DeviceContext* pContext,
+        ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        DX11DrawIndexedInstancedIndirectOriginal(pContext, pBufferForArgs, AlignedByteOffsetForArgs);
+    }
+
+    static void __stdcall DX11DrawInstancedIndirectHook(ID3D11DeviceContext* pContext,
+        ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        DX11DrawInstancedIndirectOriginal(pContext, pBufferForArgs, AlignedByteOffsetForArgs);
+    }
+
+    static void __stdcall DX11DispatchHook(ID3D11DeviceContext* pContext,
+        UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) {
+        WorkScope work(WorkCounter::Dispatches, WorkCounter::DispatchNanoseconds);
+        DX11DispatchOriginal(pContext, ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
+    }
+
+    static void __stdcall DX11DispatchIndirectHook(ID3D11DeviceContext* pContext,
+        ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs) {
+        WorkScope work(WorkCounter::Dispatches, WorkCounter::DispatchNanoseconds);
+        DX11DispatchIndirectOriginal(pContext, pBufferForArgs, AlignedByteOffsetForArgs);
+    }
+
+    static void __stdcall DX11CopyResourceHook(ID3D11DeviceContext* pContext,
+        ID3D11Resource* pDstResource, ID3D11Resource* pSrcResource) {
+        WorkScope work(WorkCounter::ResourceCopies, WorkCounter::TransferNanoseconds);
+        DX11CopyResourceOriginal(pContext, pDstResource, pSrcResource);
+    }
+
+    static void __stdcall DX11UpdateSubresourceHook(ID3D11DeviceContext* pContext,
+        ID3D11Resource* pDstResource, UINT DstSubresource, const D3D11_BOX* pDstBox, const void* pSrcData,
+        UINT SrcRowPitch, UINT SrcDepthPitch) {
+        WorkScope work(WorkCounter::ResourceUpdates, WorkCounter::TransferNanoseconds);
+        DX11UpdateSubresourceOriginal(pContext, pDstResource, DstSubresource, pDstBox, pSrcData, SrcRowPitch, SrcDepthPitch);
+    }
+
+    // Patched from the render thread right after a present, and left in place until Uninstall
+    static void InstallDrawHooks() {
+        DEBUG_LOG("Installing DX11 draw statistics hooks...");
+        INSTALL_HOOK_ADDRESS(DX11DrawIndexed, g_MethodsTable[kContextMethods + 12]);
+        INSTALL_HOOK_ADDRESS(DX11Draw, g_MethodsTable[kContextMethods + 13]);
+        INSTALL_HOOK_ADDRESS(DX11Map, g_MethodsTable[kContextMethods + 14]);
+        INSTALL_HOOK_ADDRESS(DX11Unmap, g_MethodsTable[kContextMethods + 15]);
+        INSTALL_HOOK_ADDRESS(DX11DrawIndexedInstanced, g_MethodsTable[kContextMethods + 20]);
+        INSTALL_HOOK_ADDRESS(DX11DrawInstanced, g_MethodsTable[kContextMethods + 21]);
+        INSTALL_HOOK_ADDRESS(DX11DrawAuto, g_MethodsTable[kContextMethods + 38]);
+        INSTALL_HOOK_ADDRESS(DX11DrawIndexedInstancedIndirect, g_MethodsTable[kContextMethods + 39]);
+        INSTALL_HOOK_ADDRESS(DX11DrawInstancedIndirect, g_MethodsTable[kContextMethods + 40]);
+        INSTALL_HOOK_ADDRESS(DX11Dispatch, g_MethodsTable[kContextMethods + 41]);
+        INSTALL_HOOK_ADDRESS(DX11DispatchIndirect, g_MethodsTable[kContextMethods + 42]);
+        INSTALL_HOOK_ADDRESS(DX11CopyResource, g_MethodsTable[kContextMethods + 47]);
+        INSTALL_HOOK_ADDRESS(DX11UpdateSubresource, g_MethodsTable[kContextMethods + 48]);
+
+        for (const char* name : g_DrawHookNames)
+            MemoryManager::ApplyMod(name);
+
+        g_DrawHooksInstalled = true;
+    }
+
     static HRESULT __stdcall DX11PresentHook(IDXGISwapChain* pSwapChain, UINT SyncInterval, UINT Flags) {
+        CallbackScope callbacks;
+        callbacks.BeginFrame(API::D3D11, pSwapChain, SyncInterval, Flags);
+
+        DXGI_SWAP_CHAIN_DESC desc;
+        if (!FrameTracker::HasSurfaceSize(pSwapChain) && SUCCEEDED(pSwapChain->GetDesc(&desc)))
+            FrameTracker::SetSurfaceSize(pSwapChain, desc.BufferDesc.Width, desc.BufferDesc.Height);
+
         g_SwapChain = pSwapChain;
 
         if (!g_Device && pSwapChain) {
@@ -113,10 +273,9 @@ namespace FrameJacker {
             }
         }
 
-        if (Hook::s_Callbacks.OnPresent)
-            Hook::s_Callbacks.OnPresent();
+        callbacks.OnPresent();
 
-        if (Hook::s_Callbacks.OnRender && g_Device && g_Context) {
+        if (callbacks.HasRender() && g_Device && g_Context) {
             RenderContext ctx = {};
             ctx.api = API::D3D11;
             ctx.device = g_Device;
@@ -126,20 +285,55 @@ namespace FrameJacker {
             ctx.imageIndex = 0;
             ctx.extra = nullptr;
 
-            Hook::s_Callbacks.OnRender(ctx);
+            InternalWorkScope internal;
+            if (!OverlayLayer::IsEnabled() || !DX11Overlay::Render(callbacks, ctx))
+                callbacks.OnRender(ctx);
         }
 
-        return DX11PresentOriginal(pSwapChain, SyncInterval, Flags);
+        callbacks.BeginOriginalPresent();
+        HRESULT result = DX11PresentOriginal(pSwapChain, SyncInterval, Flags);
+
+        callbacks.OnPostPresent();
+        callbacks.AddWait(DXGIFrameLatency::Wait(pSwapChain));
+
+        if (!g_DrawHooksInstalled && WorkCounters::IsDrawsEnabled() && g_MethodsTable)
+            InstallDrawHooks();
+
+        return result;
     }
 
     static HRESULT __stdcall DX11ResizeBuffersHook(
         IDXGISwapChain* pSwapChain, UINT BufferCount, UINT Width, UINT Height,
         DXGI_FORMAT NewFormat, UINT SwapChainFlags) {
 
-        if (Hook::s_Callbacks.OnResize)
-            Hook::s_Callbacks.OnResize();
+        TimelineScope timeline("ResizeBuffers", "bufferCount", BufferCount);
+        CallbackScope callbacks;
+        ResizeEvent resize = { API::D3D11, Width, Height, (uint32_t)NewFormat, pSwapChain };
+        callbacks.OnResize(resize);
+
+        // The layer is sized for the old buffers
+        DX11Overlay::ReleaseSwapChain(pSwapChain);
+
+        HRESULT result = DX11ResizeBuffersOriginal(pSwapChain, BufferCount, Width, Height, NewFormat, SwapChainFlags);
 
-        return DX11ResizeBuffersOriginal(pSwapChain, BufferCount, Width, Height, NewFormat, SwapChainFlags);
+        FrameTracker::InvalidateSurfaceSize();
+        DXGIFrameLatency::Invalidate(pSwapChain);
+
+        DXGI_SWAP_CHAIN_DESC desc;
+        if (SUCCEEDED(result) && callbacks.IsCoalescingResize() && SUCCEEDED(pSwapChain->GetDesc(&desc))) {
+            resize.width = desc.BufferDesc.Width;
+            resize.height = desc.BufferDesc.Height;
+            resize.format = (uint32_t)desc.BufferDesc.Format;
+            callbacks.DeferResize(resize);
+        }
+
+        return result;
+    }
+
+    // The game waits on the object itself from here on, so the present hook must not
+    static HANDLE __stdcall DX11GetFrameLatencyWaitableObjectHook(IDXGISwapChain2* pSwapChain) {
+        DXGIFrameLatency::NoteGameWaitable(pSwapChain);
+        return DX11GetFrameLatencyWaitableObjectOriginal(pSwapChain);
     }
 
     static DWORD WINAPI DX11InitThread(LPVOID lpParameter) {
@@ -162,6 +356,11 @@ namespace FrameJacker {
         MemoryManager::ApplyMod("DX11Present");
         MemoryManager::ApplyMod("DX11ResizeBuffers");
 
+        if (g_GetFrameLatencyWaitableObject) {
+            INSTALL_HOOK_ADDRESS(DX11GetFrameLatencyWaitableObject, g_GetFrameLatencyWaitableObject);
+            MemoryManager::ApplyMod("DX11GetFrameLatencyWaitableObject");
+        }
+
         DEBUG_LOG("DX11 installation complete");
         return 0;
     }
@@ -183,6 +382,20 @@ namespace FrameJacker {
     void DX11Hook::Uninstall() {
         MemoryManager::RestoreAndEraseMod("DX11Present");
         MemoryManager::RestoreAndEraseMod("DX11ResizeBuffers");
+        if (g_GetFrameLatencyWaitableObject) {
+            MemoryManager::RestoreAndEraseMod("DX11GetFrameLatencyWaitableObject");
+            g_GetFrameLatencyWaitableObject = 0;
+        }
+
+        DXGIFrameLatency::Shutdown();
+
+        if (g_DrawHooksInstalled) {
+            for (const char* name : g_DrawHookNames)
+                MemoryManager::RestoreAndEraseMod(name);
+            g_DrawHooksInstalled = false;
+        }
+
+        DX11Overlay::Shutdown();
 
         if (g_Context) {
             g_Context->Release();
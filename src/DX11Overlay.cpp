@@ -0,0 +1,404 @@
+#include "DX11Overlay.h"
+#include "OverlayLayer.h"
+#include <vector>
+
+namespace FrameJacker {
+
+    static const char g_CompositeShader[] = R"(
+        Texture2D overlay : register(t0);
+        SamplerState overlaySampler : register(s0);
+
+        struct VertexOutput {
+            float4 position : SV_Position;
+            float2 uv : TEXCOORD0;
+        };
+
+        VertexOutput VSMain(uint id : SV_VertexID) {
+            VertexOutput output;
+            output.uv = float2((id << 1) & 2, id & 2);
+            output.position = float4(output.uv * float2(2, -2) + float2(-1, 1), 0, 1);
+            return output;
+        }
+
+        float4 PSMain(VertexOutput input) : SV_Target {
+            return overlay.Sample(overlaySampler, input.uv);
+        }
+    )";
+
+    typedef HRESULT(WINAPI* PFN_D3DCompile_Custom)(LPCVOID pSrcData, SIZE_T SrcDataSize, LPCSTR pSourceName,
+        const D3D_SHADER_MACRO* pDefines, ID3DInclude* pInclude, LPCSTR pEntrypoint, LPCSTR pTarget,
+        UINT Flags1, UINT Flags2, ID3DBlob** ppCode, ID3DBlob** ppErrorMsgs);
+
+    // Keyed by swap chain pointer without a reference, so a layer never keeps a swap chain alive. The
+    // size is checked against the swap chain every frame and layers that stop presenting are dropped,
+    // which covers a new swap chain reusing the address of a released one.
+    struct DX11Layer {
+        IDXGISwapChain* swapChain = nullptr;
+        ID3D11Texture2D* texture = nullptr;
+        ID3D11RenderTargetView* layerView = nullptr;
+        ID3D11ShaderResourceView* layerResource = nullptr;
+        UINT width = 0;
+        UINT height = 0;
+        uint64_t lastComposite = 0;
+        OverlayLayerState state;
+    };
+
+    static constexpr uint64_t kLayerIdleNanoseconds = 2000000000;
+
+    // Everything the composite pass touches, so the game's pipeline is left as it was found
+    struct DX11StateBackup {
+        ID3D11RenderTargetView* renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+        ID3D11DepthStencilView* depthStencilView = nullptr;
+        UINT viewportCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+        D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = {};
+        ID3D11RasterizerState* rasterizerState = nullptr;
+        ID3D11BlendState* blendState = nullptr;
+        FLOAT blendFactor[4] = {};
+        UINT sampleMask = 0;
+        ID3D11DepthStencilState* depthStencilState = nullptr;
+        UINT stencilRef = 0;
+        ID3D11ShaderResourceView* shaderResource = nullptr;
+        ID3D11SamplerState* sampler = nullptr;
+        ID3D11VertexShader* vertexShader = nullptr;
+        ID3D11PixelShader* pixelShader = nullptr;
+        ID3D11GeometryShader* geometryShader = nullptr;
+        ID3D11HullShader* hullShader = nullptr;
+        ID3D11DomainShader* domainShader = nullptr;
+        ID3D11InputLayout* inputLayout = nullptr;
+        D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+        void Capture(ID3D11DeviceContext* context) {
+            context->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, &depthStencilView);
+            context->RSGetViewports(&viewportCount, viewports);
+            context->RSGetState(&rasterizerState);
+            context->OMGetBlendState(&blendState, blendFactor, &sampleMask);
+            context->OMGetDepthStencilState(&depthStencilState, &stencilRef);
+            context->PSGetShaderResources(0, 1, &shaderResource);
+            context->PSGetSamplers(0, 1, &sampler);
+            context->VSGetShader(&vertexShader, nullptr, nullptr);
+            context->PSGetShader(&pixelShader, nullptr, nullptr);
+            context->GSGetShader(&geometryShader, nullptr, nullptr);
+            context->HSGetShader(&hullShader, nullptr, nullptr);
+            context->DSGetShader(&domainShader, nullptr, nullptr);
+            context->IAGetInputLayout(&inputLayout);
+            context->IAGetPrimitiveTopology(&topology);
+        }
+
+        void Restore(ID3D11DeviceContext* context) {
+            context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, depthStencilView);
+            context->RSSetViewports(viewportCount, viewports);
+            context->RSSetState(rasterizerState);
+            context->OMSetBlendState(blendState, blendFactor, sampleMask);
+            context->OMSetDepthStencilState(depthStencilState, stencilRef);
+            context->PSSetShaderResources(0, 1, &shaderResource);
+            context->PSSetSamplers(0, 1, &sampler);
+            context->VSSetShader(vertexShader, nullptr, 0);
+            context->PSSetShader(pixelShader, nullptr, 0);
+            context->GSSetShader(geometryShader, nullptr, 0);
+            context->HSSetShader(hullShader, nullptr, 0);
+            context->DSSetShader(domainShader, nullptr, 0);
+            context->IASetInputLayout(inputLayout);
+            context->IASetPrimitiveTopology(topology);
+
+            for (auto* view : renderTargets)
+                SafeRelease(view);
+            SafeRelease(depthStencilView);
+            SafeRelease(rasterizerState);
+            SafeRelease(blendState);
+            SafeRelease(depthStencilState);
+            SafeRelease(shaderResource);
+            SafeRelease(sampler);
+            SafeRelease(vertexShader);
+            SafeRelease(pixelShader);
+            SafeRelease(geometryShader);
+            SafeRelease(hullShader);
+            SafeRelease(domainShader);
+            SafeRelease(inputLayout);
+        }
+
+        template<typename T>
+        static void SafeRelease(T*& object) {
+            if (object) {
+                object->Release();
+                object = nullptr;
+            }
+        }
+    };
+
+    static ID3D11Device* g_OverlayDevice = nullptr;
+    static ID3D11VertexShader* g_VertexShader = nullptr;
+    static ID3D11PixelShader* g_PixelShader = nullptr;
+    static ID3D11BlendState* g_BlendState = nullptr;
+    static ID3D11SamplerState* g_SamplerState = nullptr;
+    static ID3D11RasterizerState* g_RasterizerState = nullptr;
+    static ID3D11DepthStencilState* g_DepthStencilState = nullptr;
+    static bool g_PipelineFailed = false;
+    static std::vector<DX11Layer> g_Layers;
+
+    static void ReleaseLayer(DX11Layer& layer) {
+        DX11StateBackup::SafeRelease(layer.texture);
+        DX11StateBackup::SafeRelease(layer.layerView);
+        DX11StateBackup::SafeRelease(layer.layerResource);
+    }
+
+    static void ReleasePipeline() {
+        for (auto& layer : g_Layers)
+            ReleaseLayer(layer);
+        g_Layers.clear();
+
+        DX11StateBackup::SafeRelease(g_VertexShader);
+        DX11StateBackup::SafeRelease(g_PixelShader);
+        DX11StateBackup::SafeRelease(g_BlendState);
+        DX11StateBackup::SafeRelease(g_SamplerState);
+        DX11StateBackup::SafeRelease(g_RasterizerState);
+        DX11StateBackup::SafeRelease(g_DepthStencilState);
+        g_OverlayDevice = nullptr;
+        g_PipelineFailed = false;
+    }
+
+    static ID3DBlob* CompileShader(PFN_D3DCompile_Custom compile, const char* entryPoint, const char* target) {
+        ID3DBlob* code = nullptr;
+        ID3DBlob* errors = nullptr;
+        HRESULT result = compile(g_CompositeShader, sizeof(g_CompositeShader) - 1, "FrameJackerOverlay",
+            nullptr, nullptr, entryPoint, target, 0, 0, &code, &errors);
+
+        if (FAILED(result)) {
+            DEBUG_LOG("DX11 overlay %s failed to compile: %s", entryPoint,
+                errors ? (const char*)errors->GetBufferPointer() : "unknown error");
+        }
+
+        if (errors)
+            errors->Release();
+        return SUCCEEDED(result) ? code : nullptr;
+    }
+
+    static bool CreatePipeline(ID3D11Device* device) {
+        if (g_OverlayDevice == device)
+            return !g_PipelineFailed;
+
+        ReleasePipeline();
+        g_OverlayDevice = device;
+        g_PipelineFailed = true;
+
+        HMODULE compiler = ::LoadLibraryW(L"d3dcompiler_47.dll");
+        auto compile = compiler ? (PFN_D3DCompile_Custom)::GetProcAddress(compiler, "D3DCompile") : nullptr;
+        if (!compile) {
+            DEBUG_LOG("D3DCompile not available, DX11 overlay falls back to immediate rendering");
+            return false;
+        }
+
+        ID3DBlob* vertexCode = CompileShader(compile, "VSMain", "vs_4_0");
+        ID3DBlob* pixelCode = CompileShader(compile, "PSMain", "ps_4_0");
+
+        bool created = vertexCode && pixelCode
+            && SUCCEEDED(device->CreateVertexShader(vertexCode->GetBufferPointer(), vertexCode->GetBufferSize(), nullptr, &g_VertexShader))
+            && SUCCEEDED(device->CreatePixelShader(pixelCode->GetBufferPointer(), pixelCode->GetBufferSize(), nullptr, &g_PixelShader));
+
+        if (vertexCode)
+            vertexCode->Release();
+        if (pixelCode)
+            pixelCode->Release();
+
+        if (!created)
+            return false;
+
+        // The layer is cleared to transparent black and drawn with ordinary alpha blending, which
+        // leaves premultiplied colour behind
+        D3D11_BLEND_DESC blendDesc = {};
+        blendDesc.RenderTarget[0].BlendEnable = TRUE;
+        blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+        blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+        blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+        blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+        blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+        blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+        D3D11_SAMPLER_DESC samplerDesc = {};
+        samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+        samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+        samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+        samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+        samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+        samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+        D3D11_RASTERIZER_DESC rasterizerDesc = {};
+        rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+        rasterizerDesc.CullMode = D3D11_CULL_NONE;
+        rasterizerDesc.DepthClipEnable = TRUE;
+
+        D3D11_DEPTH_STENCIL_DESC depthStencilDesc = {};
+        depthStencilDesc.DepthEnable = FALSE;
+        depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+        depthStencilDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+        depthStencilDesc.StencilEnable = FALSE;
+
+        if (FAILED(device->CreateBlendState(&blendDesc, &g_BlendState))
+            || FAILED(device->CreateSamplerState(&samplerDesc, &g_SamplerState))
+            || FAILED(device->CreateRasterizerState(&rasterizerDesc, &g_RasterizerState))
+            || FAILED(device->CreateDepthStencilState(&depthStencilDesc, &g_DepthStencilState))) {
+            DEBUG_LOG("DX11 overlay pipeline state creation failed");
+            return false;
+        }
+
+        DEBUG_LOG("DX11 overlay pipeline created");
+        g_PipelineFailed = false;
+        return true;
+    }
+
+    static DX11Layer* AcquireLayer(ID3D11Device* device, IDXGISwapChain* swapChain, uint64_t now) {
+        DXGI_SWAP_CHAIN_DESC swapChainDesc;
+        if (FAILED(swapChain->GetDesc(&swapChainDesc)))
+            return nullptr;
+
+        DX11Layer* found = nullptr;
+        for (auto it = g_Layers.begin(); it != g_Layers.end();) {
+            bool current = it->swapChain == swapChain && it->width == swapChainDesc.BufferDesc.Width
+                && it->height == swapChainDesc.BufferDesc.Height;
+
+            if (!current && (it->swapChain == swapChain || now - it->lastComposite > kLayerIdleNanoseconds)) {
+                ReleaseLayer(*it);
+                it = g_Layers.erase(it);
+                continue;
+            }
+
+            if (current)
+                found = &*it;
+            ++it;
+        }
+
+        if (found)
+            return found;
+
+        DX11Layer created;
+        created.swapChain = swapChain;
+        created.width = swapChainDesc.BufferDesc.Width;
+        created.height = swapChainDesc.BufferDesc.Height;
+        created.lastComposite = now;
+
+        D3D11_TEXTURE2D_DESC textureDesc = {};
+        textureDesc.Width = created.width;
+        textureDesc.Height = created.height;
+        textureDesc.MipLevels = 1;
+        textureDesc.ArraySize = 1;
+        textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        textureDesc.SampleDesc.Count = 1;
+        textureDesc.Usage = D3D11_USAGE_DEFAULT;
+        textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+        bool succeeded = SUCCEEDED(device->CreateTexture2D(&textureDesc, nullptr, &created.texture))
+            && SUCCEEDED(device->CreateRenderTargetView(created.texture, nullptr, &created.layerView))
+            && SUCCEEDED(device->CreateShaderResourceView(created.texture, nullptr, &created.layerResource));
+
+        if (!succeeded) {
+            DEBUG_LOG("DX11 overlay layer creation failed (%ux%u)", created.width, created.height);
+            ReleaseLayer(created);
+            return nullptr;
+        }
+
+        DEBUG_LOG("DX11 overlay layer created (%ux%u)", created.width, created.height);
+        g_Layers.push_back(created);
+        return &g_Layers.back();
+    }
+
+    static void Redraw(const CallbackScope& callbacks, RenderContext& ctx, ID3D11DeviceContext* context, DX11Layer& layer) {
+        ID3D11RenderTargetView* renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+        ID3D11DepthStencilView* depthStencilView = nullptr;
+        UINT viewportCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+        D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+        context->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, &depthStencilView);
+        context->RSGetViewports(&viewportCount, viewports);
+
+        const FLOAT transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        D3D11_VIEWPORT viewport = { 0.0f, 0.0f, (FLOAT)layer.width, (FLOAT)layer.height, 0.0f, 1.0f };
+        context->ClearRenderTargetView(layer.layerView, transparent);
+        context->OMSetRenderTargets(1, &layer.layerView, nullptr);
+        context->RSSetViewports(1, &viewport);
+
+        ctx.renderTarget = layer.layerView;
+        callbacks.OnRender(ctx);
+
+        context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, depthStencilView);
+        context->RSSetViewports(viewportCount, viewports);
+
+        for (auto* view : renderTargets)
+            DX11StateBackup::SafeRelease(view);
+        DX11StateBackup::SafeRelease(depthStencilView);
+    }
+
+    // The back buffer view is created per composite: holding it across frames would keep a reference
+    // the game's ResizeBuffers has to see released, and bind to whatever buffer 0 was at the time
+    static void Composite(ID3D11Device* device, ID3D11DeviceContext* context, IDXGISwapChain* swapChain, DX11Layer& layer) {
+        ID3D11Texture2D* backBuffer = nullptr;
+        ID3D11RenderTargetView* backBufferView = nullptr;
+        bool created = SUCCEEDED(swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer))
+            && SUCCEEDED(device->CreateRenderTargetView(backBuffer, nullptr, &backBufferView));
+
+        DX11StateBackup::SafeRelease(backBuffer);
+        if (!created) {
+            DEBUG_LOG("DX11 overlay could not bind the back buffer");
+            return;
+        }
+
+        DX11StateBackup backup;
+        backup.Capture(context);
+
+        const FLOAT blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        D3D11_VIEWPORT viewport = { 0.0f, 0.0f, (FLOAT)layer.width, (FLOAT)layer.height, 0.0f, 1.0f };
+
+        context->OMSetRenderTargets(1, &backBufferView, nullptr);
+        context->RSSetViewports(1, &viewport);
+        context->RSSetState(g_RasterizerState);
+        context->OMSetBlendState(g_BlendState, blendFactor, 0xFFFFFFFF);
+        context->OMSetDepthStencilState(g_DepthStencilState, 0);
+        context->PSSetShaderResources(0, 1, &layer.layerResource);
+        context->PSSetSamplers(0, 1, &g_SamplerState);
+        context->VSSetShader(g_VertexShader, nullptr, 0);
+        context->PSSetShader(g_PixelShader, nullptr, 0);
+        context->GSSetShader(nullptr, nullptr, 0);
+        context->HSSetShader(nullptr, nullptr, 0);
+        context->DSSetShader(nullptr, nullptr, 0);
+        context->IASetInputLayout(nullptr);
+        context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        context->Draw(3, 0);
+
+        backup.Restore(context);
+        DX11StateBackup::SafeRelease(backBufferView);
+    }
+
+    bool DX11Overlay::Render(const CallbackScope& callbacks, RenderContext& ctx) {
+        auto* device = static_cast<ID3D11Device*>(ctx.device);
+        auto* context = static_cast<ID3D11DeviceContext*>(ctx.commandBuffer);
+        auto* swapChain = static_cast<IDXGISwapChain*>(ctx.swapChain);
+
+        if (!CreatePipeline(device))
+            return false;
+
+        uint64_t now = callbacks.GetFrame().timestamp;
+        DX11Layer* layer = AcquireLayer(device, swapChain, now);
+        if (!layer)
+            return false;
+
+        if (OverlayLayer::ShouldRedraw(layer->state, now))
+            Redraw(callbacks, ctx, context, *layer);
+
+        layer->lastComposite = now;
+        Composite(device, context, swapChain, *layer);
+        return true;
+    }
+
+    void DX11Overlay::ReleaseSwapChain(IDXGISwapChain* swapChain) {
+        for (auto it = g_Layers.begin(); it != g_Layers.end(); ++it) {
+            if (it->swapChain == swapChain) {
+                ReleaseLayer(*it);
+                g_Layers.erase(it);
+                return;
+            }
+        }
+    }
+
+    void DX11Overlay::Shutdown() {
+        ReleasePipeline();
+    }
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "FrameJacker.h"
+#include "CallbackRegistry.h"
+#if FRAMEJACKER_INCLUDE_D3D11
+#include <dxgi.h>
+#include <d3d11.h>
+#endif
+
+namespace FrameJacker {
+
+    // Retained overlay target for D3D11 swap chains. OnRender draws into an offscreen layer only when
+    // OverlayLayer asks for a redraw; the layer is blended over the back buffer on every present.
+    class DX11Overlay {
+    public:
+        // Returns false when the layer could not be set up, the caller then renders immediately
+        static bool Render(const CallbackScope& callbacks, RenderContext& ctx);
+
+        static void ReleaseSwapChain(IDXGISwapChain* swapChain);
+        static void Shutdown();
+    };
+
+}
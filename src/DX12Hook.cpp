@@ -1,4 +1,9 @@
 #include "FrameJacker.h"
+#include "CallbackRegistry.h"
+#include "DX12Overlay.h"
+#include "DXGIFrameLatency.h"
+#include "OverlayLayer.h"
+#include "WorkCounters.h"
 #include <DetourMacros.hpp>
 #include <MemoryManager.h>
 #if FRAMEJACKER_INCLUDE_D3D12
@@ -20,9 +25,13 @@ namespace FrameJacker {
         IDXGISwapChain* pSwapChain, UINT BufferCount, UINT Width, UINT Height,
         DXGI_FORMAT NewFormat, UINT SwapChainFlags);
 
+    DECLARE_HOOK(DX12GetFrameLatencyWaitableObject, HANDLE, __stdcall, __stdcall,
+        IDXGISwapChain2* pSwapChain);
+
     static ID3D12CommandQueue* g_CommandQueue = nullptr;
     static IDXGISwapChain3* g_SwapChain = nullptr;
     static uint150_t* g_MethodsTable = nullptr;
+    static uint150_t g_GetFrameLatencyWaitableObject = 0;     // IDXGISwapChain2
 
     static DWORD WINAPI InitThread(LPVOID lpParameter) {
         Sleep(100);
@@ -47,6 +56,11 @@ namespace FrameJacker {
         MemoryManager::ApplyMod("DX12ResizeBuffers");
         MemoryManager::ApplyMod("DX12Present");
 
+        if (g_GetFrameLatencyWaitableObject) {
+            INSTALL_HOOK_ADDRESS(DX12GetFrameLatencyWaitableObject, g_GetFrameLatencyWaitableObject);
+            MemoryManager::ApplyMod("DX12GetFrameLatencyWaitableObject");
+        }
+
         DEBUG_LOG("Installation complete");
         return 0;
     }
@@ -224,6 +238,12 @@ namespace FrameJacker {
         ::memcpy(g_MethodsTable + 44 + 19 + 9, *(uint150_t**)commandList, 60 * sizeof(uint150_t));
         ::memcpy(g_MethodsTable + 44 + 19 + 9 + 60, *(uint150_t**)swapChain, 18 * sizeof(uint150_t));
 
+        IDXGISwapChain2* swapChain2 = nullptr;
+        if (SUCCEEDED(swapChain->QueryInterface(__uuidof(IDXGISwapChain2), (void**)&swapChain2))) {
+            g_GetFrameLatencyWaitableObject = (*(uint150_t**)swapChain2)[33];
+            swapChain2->Release();
+        }
+
         device->Release();
         commandQueue->Release();
         commandAllocator->Release();
@@ -237,12 +257,18 @@ namespace FrameJacker {
     }
 
     static HRESULT __stdcall DX12PresentHook(IDXGISwapChain3* pSwapChain, UINT SyncInterval, UINT Flags) {
+        CallbackScope callbacks;
+        callbacks.BeginFrame(API::D3D12, pSwapChain, SyncInterval, Flags, g_CommandQueue);
+
+        DXGI_SWAP_CHAIN_DESC desc;
+        if (!FrameTracker::HasSurfaceSize(pSwapChain) && SUCCEEDED(pSwapChain->GetDesc(&desc)))
+            FrameTracker::SetSurfaceSize(pSwapChain, desc.BufferDesc.Width, desc.BufferDesc.Height);
+
         g_SwapChain = pSwapChain;
 
-        if (Hook::s_Callbacks.OnPresent)
-            Hook::s_Callbacks.OnPresent();
+        callbacks.OnPresent();
 
-        if (Hook::s_Callbacks.OnRender && g_CommandQueue) {
+        if (callbacks.HasRender() && g_CommandQueue) {
             RenderContext ctx = {};
             ctx.api = API::D3D12;
             ctx.device = nullptr;  // DX12 device accessible via command queue
@@ -252,32 +278,82 @@ namespace FrameJacker {
             ctx.imageIndex = 0;
             ctx.extra = g_CommandQueue;  // Pass command queue
 
-            Hook::s_Callbacks.OnRender(ctx);
+            InternalWorkScope internal;
+            if (!OverlayLayer::IsEnabled() || !DX12Overlay::Render(callbacks, ctx))
+                callbacks.OnRender(ctx);
         }
 
-        return DX12PresentOriginal(pSwapChain, SyncInterval, Flags);
+        callbacks.BeginOriginalPresent();
+        HRESULT result = DX12PresentOriginal(pSwapChain, SyncInterval, Flags);
+
+        callbacks.OnPostPresent();
+        callbacks.AddWait(DXGIFrameLatency::Wait(pSwapChain));
+
+        return result;
     }
 
     static HRESULT __stdcall DX12ResizeBuffersHook(
         IDXGISwapChain* pSwapChain, UINT BufferCount, UINT Width, UINT Height,
         DXGI_FORMAT NewFormat, UINT SwapChainFlags) {
 
-        if (Hook::s_Callbacks.OnResize)
-            Hook::s_Callbacks.OnResize();
+        TimelineScope timeline("ResizeBuffers", "bufferCount", BufferCount);
+        CallbackScope callbacks;
+        ResizeEvent resize = { API::D3D12, Width, Height, (uint32_t)NewFormat, pSwapChain };
+        callbacks.OnResize(resize);
+
+        // Resizing needs the overlay's work on the back buffers finished
+        DX12Overlay::ReleaseSwapChain(pSwapChain);
+
+        HRESULT result = DX12ResizeBuffersOriginal(pSwapChain, BufferCount, Width, Height, NewFormat, SwapChainFlags);
+
+        FrameTracker::InvalidateSurfaceSize();
+        DXGIFrameLatency::Invalidate(pSwapChain);
 
-        return DX12ResizeBuffersOriginal(pSwapChain, BufferCount, Width, Height, NewFormat, SwapChainFlags);
+        DXGI_SWAP_CHAIN_DESC desc;
+        if (SUCCEEDED(result) && callbacks.IsCoalescingResize() && SUCCEEDED(pSwapChain->GetDesc(&desc))) {
+            resize.width = desc.BufferDesc.Width;
+            resize.height = desc.BufferDesc.Height;
+            resize.format = (uint32_t)desc.BufferDesc.Format;
+            callbacks.DeferResize(resize);
+        }
+
+        return result;
+    }
+
+    // The game waits on the object itself from here on, so the present hook must not
+    static HANDLE __stdcall DX12GetFrameLatencyWaitableObjectHook(IDXGISwapChain2* pSwapChain) {
+        DXGIFrameLatency::NoteGameWaitable(pSwapChain);
+        return DX12GetFrameLatencyWaitableObjectOriginal(pSwapChain);
     }
 
     static void __stdcall DX12ExecuteCommandListsHook(ID3D12CommandQueue* queue,
         UINT NumCommandLists, ID3D12CommandList** ppCommandLists) {
 
+        TimelineScope timeline("ExecuteCommandLists", "commandLists", NumCommandLists);
+
         if (!g_CommandQueue) {
             g_CommandQueue = queue;
-            if (Hook::s_Callbacks.OnDeviceCreated)
-                Hook::s_Callbacks.OnDeviceCreated(queue);
+            CallbackScope callbacks;
+            callbacks.OnDeviceCreated(queue);
+        }
+
+        if (!WorkCounters::IsSubmissionsEnabled() || WorkCounters::IsInternalWork()) {
+            DX12ExecuteCommandListsOriginal(queue, NumCommandLists, ppCommandLists);
+            return;
+        }
+
+        uint32_t slot = WorkCounters::FindQueue(queue);
+        if (slot == WorkCounters::kMaxQueues) {
+            D3D12_COMMAND_LIST_TYPE type = queue->GetDesc().Type;
+            QueueGroup group = type == D3D12_COMMAND_LIST_TYPE_DIRECT ? QueueGroup::Direct
+                : type == D3D12_COMMAND_LIST_TYPE_COMPUTE ? QueueGroup::Compute
+                : type == D3D12_COMMAND_LIST_TYPE_COPY ? QueueGroup::Copy : QueueGroup::Other;
+            slot = WorkCounters::AddQueue(queue, (uint32_t)type, group);
         }
 
+        uint64_t start = Clock::Now();
         DX12ExecuteCommandListsOriginal(queue, NumCommandLists, ppCommandLists);
+        WorkCounters::RecordSubmission(slot, { 1, NumCommandLists, 0, 0, Clock::Now() - start });
     }
 
     bool DX12Hook::Install() {
@@ -298,6 +374,13 @@ namespace FrameJacker {
         MemoryManager::RestoreAndEraseMod("DX12Present");
         MemoryManager::RestoreAndEraseMod("DX12ExecuteCommandLists");
         MemoryManager::RestoreAndEraseMod("DX12ResizeBuffers");
+        if (g_GetFrameLatencyWaitableObject) {
+            MemoryManager::RestoreAndEraseMod("DX12GetFrameLatencyWaitableObject");
+            g_GetFrameLatencyWaitableObject = 0;
+        }
+
+        DXGIFrameLatency::Shutdown();
+        DX12Overlay::Shutdown();
 
         if (g_MethodsTable) {
             free(g_MethodsTable);
@@ -0,0 +1,483 @@
+#include "DX12Overlay.h"
+#include "OverlayLayer.h"
+#include <vector>
+
+namespace FrameJacker {
+
+    static const char g_CompositeShader[] = R"(
+        Texture2D overlay : register(t0);
+        SamplerState overlaySampler : register(s0);
+
+        struct VertexOutput {
+            float4 position : SV_Position;
+            float2 uv : TEXCOORD0;
+        };
+
+        VertexOutput VSMain(uint id : SV_VertexID) {
+            VertexOutput output;
+            output.uv = float2((id << 1) & 2, id & 2);
+            output.position = float4(output.uv * float2(2, -2) + float2(-1, 1), 0, 1);
+            return output;
+        }
+
+        float4 PSMain(VertexOutput input) : SV_Target {
+            return overlay.Sample(overlaySampler, input.uv);
+        }
+    )";
+
+    typedef HRESULT(WINAPI* PFN_D3DCompile_Custom)(LPCVOID pSrcData, SIZE_T SrcDataSize, LPCSTR pSourceName,
+        const D3D_SHADER_MACRO* pDefines, ID3DInclude* pInclude, LPCSTR pEntrypoint, LPCSTR pTarget,
+        UINT Flags1, UINT Flags2, ID3DBlob** ppCode, ID3DBlob** ppErrorMsgs);
+
+    static constexpr DWORD kFenceTimeoutMilliseconds = 1000;
+    static constexpr uint64_t kLayerIdleNanoseconds = 2000000000;
+
+    // One per back buffer, so recording the next frame never resets an allocator the GPU still reads
+    struct DX12Frame {
+        ID3D12CommandAllocator* allocator = nullptr;
+        uint64_t fenceValue = 0;
+    };
+
+    struct DX12Layer {
+        IDXGISwapChain3* swapChain = nullptr;       // Not referenced, see DX11Overlay
+        ID3D12CommandQueue* queue = nullptr;
+        ID3D12Resource* texture = nullptr;
+        ID3D12PipelineState* pipeline = nullptr;    // Built for the back buffer format
+        ID3D12DescriptorHeap* rtvHeap = nullptr;    // Layer, then the back buffer of the current composite
+        ID3D12DescriptorHeap* srvHeap = nullptr;
+        ID3D12GraphicsCommandList* commandList = nullptr;
+        ID3D12Fence* fence = nullptr;
+        HANDLE fenceEvent = nullptr;
+        uint64_t fenceValue = 0;
+        std::vector<DX12Frame> frames;
+        UINT rtvIncrement = 0;
+        UINT width = 0;
+        UINT height = 0;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        uint64_t lastComposite = 0;
+        OverlayLayerState state;
+    };
+
+    template<typename T>
+    static void SafeRelease(T*& object) {
+        if (object) {
+            object->Release();
+            object = nullptr;
+        }
+    }
+
+    static ID3D12Device* g_OverlayDevice = nullptr;
+    static ID3D12RootSignature* g_RootSignature = nullptr;
+    static ID3DBlob* g_VertexCode = nullptr;
+    static ID3DBlob* g_PixelCode = nullptr;
+    static bool g_PipelineFailed = false;
+    static std::vector<DX12Layer> g_Layers;
+
+    static bool WaitForFence(DX12Layer& layer, uint64_t value) {
+        if (!value || layer.fence->GetCompletedValue() >= value)
+            return true;
+
+        if (FAILED(layer.fence->SetEventOnCompletion(value, layer.fenceEvent))
+            || ::WaitForSingleObject(layer.fenceEvent, kFenceTimeoutMilliseconds) != WAIT_OBJECT_0) {
+            DEBUG_LOG("DX12 overlay timed out waiting for the GPU");
+            return false;
+        }
+
+        return true;
+    }
+
+    static void ReleaseLayer(DX12Layer& layer) {
+        if (layer.fence)
+            WaitForFence(layer, layer.fenceValue);
+
+        for (auto& frame : layer.frames)
+            SafeRelease(frame.allocator);
+        layer.frames.clear();
+
+        SafeRelease(layer.commandList);
+        SafeRelease(layer.srvHeap);
+        SafeRelease(layer.rtvHeap);
+        SafeRelease(layer.pipeline);
+        SafeRelease(layer.texture);
+        SafeRelease(layer.fence);
+        SafeRelease(layer.queue);
+
+        if (layer.fenceEvent) {
+            ::CloseHandle(layer.fenceEvent);
+            layer.fenceEvent = nullptr;
+        }
+    }
+
+    static void ReleasePipeline() {
+        for (auto& layer : g_Layers)
+            ReleaseLayer(layer);
+        g_Layers.clear();
+
+        SafeRelease(g_RootSignature);
+        SafeRelease(g_VertexCode);
+        SafeRelease(g_PixelCode);
+        g_OverlayDevice = nullptr;
+        g_PipelineFailed = false;
+    }
+
+    static ID3DBlob* CompileShader(PFN_D3DCompile_Custom compile, const char* entryPoint, const char* target) {
+        ID3DBlob* code = nullptr;
+        ID3DBlob* errors = nullptr;
+        HRESULT result = compile(g_CompositeShader, sizeof(g_CompositeShader) - 1, "FrameJackerOverlay",
+            nullptr, nullptr, entryPoint, target, 0, 0, &code, &errors);
+
+        if (FAILED(result)) {
+            DEBUG_LOG("DX12 overlay %s failed to compile: %s", entryPoint,
+                errors ? (const char*)errors->GetBufferPointer() : "unknown error");
+        }
+
+        if (errors)
+            errors->Release();
+        return SUCCEEDED(result) ? code : nullptr;
+    }
+
+    // Shaders and the root signature are shared by every layer on the device, pipeline states are
+    // per layer since they depend on the back buffer format
+    static bool CreatePipeline(ID3D12Device* device) {
+        if (g_OverlayDevice == device)
+            return !g_PipelineFailed;
+
+        ReleasePipeline();
+        g_OverlayDevice = device;
+        g_PipelineFailed = true;
+
+        HMODULE compiler = ::LoadLibraryW(L"d3dcompiler_47.dll");
+        auto compile = compiler ? (PFN_D3DCompile_Custom)::GetProcAddress(compiler, "D3DCompile") : nullptr;
+        HMODULE libD3D12 = ::GetModuleHandleW(L"d3d12.dll");
+        auto serialize = libD3D12 ? (PFN_D3D12_SERIALIZE_ROOT_SIGNATURE)::GetProcAddress(libD3D12, "D3D12SerializeRootSignature") : nullptr;
+        if (!compile || !serialize) {
+            DEBUG_LOG("D3DCompile not available, DX12 overlay falls back to immediate rendering");
+            return false;
+        }
+
+        g_VertexCode = CompileShader(compile, "VSMain", "vs_5_0");
+        g_PixelCode = CompileShader(compile, "PSMain", "ps_5_0");
+        if (!g_VertexCode || !g_PixelCode)
+            return false;
+
+        D3D12_DESCRIPTOR_RANGE range = {};
+        range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        range.NumDescriptors = 1;
+        range.BaseShaderRegister = 0;
+        range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+        D3D12_ROOT_PARAMETER parameter = {};
+        parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        parameter.DescriptorTable.NumDescriptorRanges = 1;
+        parameter.DescriptorTable.pDescriptorRanges = &range;
+        parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+        D3D12_STATIC_SAMPLER_DESC sampler = {};
+        sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
+        sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+        sampler.MaxLOD = D3D12_FLOAT32_MAX;
+        sampler.ShaderRegister = 0;
+        sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+        D3D12_ROOT_SIGNATURE_DESC rootDesc = {};
+        rootDesc.NumParameters = 1;
+        rootDesc.pParameters = &parameter;
+        rootDesc.NumStaticSamplers = 1;
+        rootDesc.pStaticSamplers = &sampler;
+
+        ID3DBlob* rootBlob = nullptr;
+        ID3DBlob* errors = nullptr;
+        HRESULT result = serialize(&rootDesc, D3D_ROOT_SIGNATURE_VERSION_1, &rootBlob, &errors);
+        if (SUCCEEDED(result)) {
+            result = device->CreateRootSignature(0, rootBlob->GetBufferPointer(), rootBlob->GetBufferSize(),
+                __uuidof(ID3D12RootSignature), (void**)&g_RootSignature);
+        }
+
+        SafeRelease(rootBlob);
+        SafeRelease(errors);
+        if (FAILED(result)) {
+            DEBUG_LOG("DX12 overlay root signature creation failed: 0x%08X", (unsigned)result);
+            return false;
+        }
+
+        DEBUG_LOG("DX12 overlay pipeline created");
+        g_PipelineFailed = false;
+        return true;
+    }
+
+    static ID3D12PipelineState* CreatePipelineState(ID3D12Device* device, DXGI_FORMAT format) {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+        desc.pRootSignature = g_RootSignature;
+        desc.VS = { g_VertexCode->GetBufferPointer(), g_VertexCode->GetBufferSize() };
+        desc.PS = { g_PixelCode->GetBufferPointer(), g_PixelCode->GetBufferSize() };
+
+        // Same premultiplied blend as the D3D11 layer
+        desc.BlendState.RenderTarget[0].BlendEnable = TRUE;
+        desc.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_ONE;
+        desc.BlendState.RenderTarget[0].DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+        desc.BlendState.RenderTarget[0].BlendOp = D3D12_BLEND_OP_ADD;
+        desc.BlendState.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ONE;
+        desc.BlendState.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+        desc.BlendState.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_ADD;
+        desc.BlendState.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_NOOP;
+        desc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+        desc.SampleMask = 0xFFFFFFFF;
+
+        desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+        desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+        desc.RasterizerState.DepthClipEnable = TRUE;
+
+        desc.DepthStencilState.DepthEnable = FALSE;
+        desc.DepthStencilState.StencilEnable = FALSE;
+
+        desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        desc.NumRenderTargets = 1;
+        desc.RTVFormats[0] = format;
+        desc.SampleDesc.Count = 1;
+
+        ID3D12PipelineState* pipeline = nullptr;
+        if (FAILED(device->CreateGraphicsPipelineState(&desc, __uuidof(ID3D12PipelineState), (void**)&pipeline)))
+            DEBUG_LOG("DX12 overlay pipeline state creation failed for format %u", (unsigned)format);
+        return pipeline;
+    }
+
+    static bool CreateLayer(ID3D12Device* device, DX12Layer& layer, UINT bufferCount) {
+        // D3D12 swap chains hand out the queue they present on through GetDevice. The composite has
+        // to be submitted there to be ordered before the present.
+        if (FAILED(layer.swapChain->GetDevice(__uuidof(ID3D12CommandQueue), (void**)&layer.queue))
+            || layer.queue->GetDesc().Type != D3D12_COMMAND_LIST_TYPE_DIRECT) {
+            DEBUG_LOG("DX12 overlay could not find the swap chain's direct queue");
+            return false;
+        }
+
+        layer.pipeline = CreatePipelineState(device, layer.format);
+        if (!layer.pipeline)
+            return false;
+
+        D3D12_HEAP_PROPERTIES heapProperties = {};
+        heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+        D3D12_RESOURCE_DESC textureDesc = {};
+        textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        textureDesc.Width = layer.width;
+        textureDesc.Height = layer.height;
+        textureDesc.DepthOrArraySize = 1;
+        textureDesc.MipLevels = 1;
+        textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        textureDesc.SampleDesc.Count = 1;
+        textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        textureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+        D3D12_CLEAR_VALUE clearValue = {};
+        clearValue.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+        D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
+        rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+        rtvHeapDesc.NumDescriptors = 2;
+
+        D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
+        srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        srvHeapDesc.NumDescriptors = 1;
+        srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+        if (FAILED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &textureDesc,
+                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, &clearValue, __uuidof(ID3D12Resource), (void**)&layer.texture))
+            || FAILED(device->CreateDescriptorHeap(&rtvHeapDesc, __uuidof(ID3D12DescriptorHeap), (void**)&layer.rtvHeap))
+            || FAILED(device->CreateDescriptorHeap(&srvHeapDesc, __uuidof(ID3D12DescriptorHeap), (void**)&layer.srvHeap))
+            || FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, __uuidof(ID3D12Fence), (void**)&layer.fence)))
+            return false;
+
+        layer.fenceEvent = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!layer.fenceEvent)
+            return false;
+
+        layer.frames.resize(bufferCount);
+        for (auto& frame : layer.frames) {
+            if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                    __uuidof(ID3D12CommandAllocator), (void**)&frame.allocator)))
+                return false;
+        }
+
+        if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, layer.frames[0].allocator, nullptr,
+                __uuidof(ID3D12GraphicsCommandList), (void**)&layer.commandList)))
+            return false;
+        layer.commandList->Close();
+
+        layer.rtvIncrement = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+        device->CreateRenderTargetView(layer.texture, nullptr, layer.rtvHeap->GetCPUDescriptorHandleForHeapStart());
+        device->CreateShaderResourceView(layer.texture, nullptr, layer.srvHeap->GetCPUDescriptorHandleForHeapStart());
+        return true;
+    }
+
+    static DX12Layer* AcquireLayer(ID3D12Device* device, IDXGISwapChain3* swapChain, uint64_t now) {
+        DXGI_SWAP_CHAIN_DESC swapChainDesc;
+        if (FAILED(swapChain->GetDesc(&swapChainDesc)))
+            return nullptr;
+
+        DX12Layer* found = nullptr;
+        for (auto it = g_Layers.begin(); it != g_Layers.end();) {
+            bool current = it->swapChain == swapChain && it->width == swapChainDesc.BufferDesc.Width
+                && it->height == swapChainDesc.BufferDesc.Height && it->format == swapChainDesc.BufferDesc.Format
+                && it->frames.size() == swapChainDesc.BufferCount;
+
+            if (!current && (it->swapChain == swapChain || now - it->lastComposite > kLayerIdleNanoseconds)) {
+                ReleaseLayer(*it);
+                it = g_Layers.erase(it);
+                continue;
+            }
+
+            if (current)
+                found = &*it;
+            ++it;
+        }
+
+        if (found)
+            return found;
+
+        DX12Layer created;
+        created.swapChain = swapChain;
+        created.width = swapChainDesc.BufferDesc.Width;
+        created.height = swapChainDesc.BufferDesc.Height;
+        created.format = swapChainDesc.BufferDesc.Format;
+        created.lastComposite = now;
+
+        if (!CreateLayer(device, created, swapChainDesc.BufferCount)) {
+            DEBUG_LOG("DX12 overlay layer creation failed (%ux%u)", created.width, created.height);
+            ReleaseLayer(created);
+            return nullptr;
+        }
+
+        DEBUG_LOG("DX12 overlay layer created (%ux%u, %u buffers)", created.width, created.height, swapChainDesc.BufferCount);
+        g_Layers.push_back(created);
+        return &g_Layers.back();
+    }
+
+    static void Transition(ID3D12GraphicsCommandList* commandList, ID3D12Resource* resource,
+        D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) {
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Transition.pResource = resource;
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        barrier.Transition.StateBefore = before;
+        barrier.Transition.StateAfter = after;
+        commandList->ResourceBarrier(1, &barrier);
+    }
+
+    static void Redraw(const CallbackScope& callbacks, RenderContext& ctx, DX12Layer& layer) {
+        ID3D12GraphicsCommandList* commandList = layer.commandList;
+        D3D12_CPU_DESCRIPTOR_HANDLE layerView = layer.rtvHeap->GetCPUDescriptorHandleForHeapStart();
+        D3D12_VIEWPORT viewport = { 0.0f, 0.0f, (FLOAT)layer.width, (FLOAT)layer.height, 0.0f, 1.0f };
+        D3D12_RECT scissor = { 0, 0, (LONG)layer.width, (LONG)layer.height };
+        const FLOAT transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+        Transition(commandList, layer.texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        commandList->ClearRenderTargetView(layerView, transparent, 0, nullptr);
+        commandList->OMSetRenderTargets(1, &layerView, FALSE, nullptr);
+        commandList->RSSetViewports(1, &viewport);
+        commandList->RSSetScissorRects(1, &scissor);
+
+        ctx.commandBuffer = commandList;
+        ctx.renderTarget = layer.texture;
+        callbacks.OnRender(ctx);
+
+        Transition(commandList, layer.texture, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+
+    static void Composite(ID3D12Device* device, DX12Layer& layer, ID3D12Resource* backBuffer) {
+        ID3D12GraphicsCommandList* commandList = layer.commandList;
+        D3D12_CPU_DESCRIPTOR_HANDLE backBufferView = layer.rtvHeap->GetCPUDescriptorHandleForHeapStart();
+        backBufferView.ptr += layer.rtvIncrement;
+        D3D12_VIEWPORT viewport = { 0.0f, 0.0f, (FLOAT)layer.width, (FLOAT)layer.height, 0.0f, 1.0f };
+        D3D12_RECT scissor = { 0, 0, (LONG)layer.width, (LONG)layer.height };
+
+        // Render target views are read when recorded, so one slot serves every back buffer
+        device->CreateRenderTargetView(backBuffer, nullptr, backBufferView);
+
+        Transition(commandList, backBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        commandList->OMSetRenderTargets(1, &backBufferView, FALSE, nullptr);
+        commandList->RSSetViewports(1, &viewport);
+        commandList->RSSetScissorRects(1, &scissor);
+        commandList->SetDescriptorHeaps(1, &layer.srvHeap);
+        commandList->SetGraphicsRootSignature(g_RootSignature);
+        commandList->SetGraphicsRootDescriptorTable(0, layer.srvHeap->GetGPUDescriptorHandleForHeapStart());
+        commandList->SetPipelineState(layer.pipeline);
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        commandList->DrawInstanced(3, 1, 0, 0);
+        Transition(commandList, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+    }
+
+    bool DX12Overlay::Render(const CallbackScope& callbacks, RenderContext& ctx) {
+        auto* swapChain = static_cast<IDXGISwapChain3*>(ctx.swapChain);
+
+        ID3D12CommandQueue* queue = nullptr;
+        ID3D12Device* device = nullptr;
+        if (FAILED(swapChain->GetDevice(__uuidof(ID3D12CommandQueue), (void**)&queue)))
+            return false;
+        HRESULT result = queue->GetDevice(__uuidof(ID3D12Device), (void**)&device);
+        queue->Release();
+        if (FAILED(result))
+            return false;
+        // Compared by address only, like the D3D11 overlay
+        device->Release();
+
+        if (!CreatePipeline(device))
+            return false;
+
+        uint64_t now = callbacks.GetFrame().timestamp;
+        DX12Layer* layer = AcquireLayer(device, swapChain, now);
+        if (!layer)
+            return false;
+
+        UINT bufferIndex = swapChain->GetCurrentBackBufferIndex();
+        ID3D12Resource* backBuffer = nullptr;
+        if (bufferIndex >= layer->frames.size()
+            || FAILED(swapChain->GetBuffer(bufferIndex, __uuidof(ID3D12Resource), (void**)&backBuffer)))
+            return false;
+
+        DX12Frame& frame = layer->frames[bufferIndex];
+        if (!WaitForFence(*layer, frame.fenceValue)
+            || FAILED(frame.allocator->Reset())
+            || FAILED(layer->commandList->Reset(frame.allocator, nullptr))) {
+            backBuffer->Release();
+            return false;
+        }
+
+        ctx.device = device;
+        ctx.imageIndex = bufferIndex;
+        if (OverlayLayer::ShouldRedraw(layer->state, now))
+            Redraw(callbacks, ctx, *layer);
+
+        Composite(device, *layer, backBuffer);
+
+        if (SUCCEEDED(layer->commandList->Close())) {
+            ID3D12CommandList* commandLists[] = { layer->commandList };
+            layer->queue->ExecuteCommandLists(1, commandLists);
+            if (SUCCEEDED(layer->queue->Signal(layer->fence, layer->fenceValue + 1)))
+                frame.fenceValue = ++layer->fenceValue;
+        }
+
+        // The swap chain keeps its buffers alive, the reference is not needed past submission
+        backBuffer->Release();
+        layer->lastComposite = now;
+        return true;
+    }
+
+    void DX12Overlay::ReleaseSwapChain(IDXGISwapChain* swapChain) {
+        for (auto it = g_Layers.begin(); it != g_Layers.end(); ++it) {
+            if (it->swapChain == swapChain) {
+                ReleaseLayer(*it);
+                g_Layers.erase(it);
+                return;
+            }
+        }
+    }
+
+    void DX12Overlay::Shutdown() {
+        ReleasePipeline();
+    }
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "FrameJacker.h"
+#include "CallbackRegistry.h"
+#if FRAMEJACKER_INCLUDE_D3D12
+#include <d3d12.h>
+#include <dxgi1_4.h>
+#endif
+
+namespace FrameJacker {
+
+    // Retained overlay target for D3D12 swap chains. The layer, its command list and a fence live per
+    // swap chain; OnRender records into that command list with the layer bound only when OverlayLayer
+    // asks for a redraw, and the layer is blended over the current back buffer on every present.
+    class DX12Overlay {
+    public:
+        // Returns false when the layer could not be set up, the caller then renders immediately
+        static bool Render(const CallbackScope& callbacks, RenderContext& ctx);
+
+        // Waits for the layer's work on the GPU, so the caller can resize or release the swap chain
+        static void ReleaseSwapChain(IDXGISwapChain* swapChain);
+        static void Shutdown();
+    };
+
+}
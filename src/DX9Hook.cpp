@@ -1,4 +1,6 @@
 #include "FrameJacker.h"
+#include "CallbackRegistry.h"
+#include "WorkCounters.h"
 #include <DetourMacros.hpp>
 #include <MemoryManager.h>
 #if FRAMEJACKER_INCLUDE_D3D9
@@ -9,11 +11,38 @@ using namespace ByteWeaver;
 
 namespace FrameJacker {
 
-    DECLARE_HOOK(DX9EndScene, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice);
+    DECLARE_HOOK(DX9Present, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice,
+        const RECT* pSourceRect, const RECT* pDestRect, HWND hDestWindowOverride, const RGNDATA* pDirtyRegion);
+    DECLARE_HOOK(DX9SwapChainPresent, HRESULT, __stdcall, __stdcall, IDirect3DSwapChain9* pSwapChain,
+        const RECT* pSourceRect, const RECT* pDestRect, HWND hDestWindowOverride, const RGNDATA* pDirtyRegion, DWORD dwFlags);
     DECLARE_HOOK(DX9Reset, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice, D3DPRESENT_PARAMETERS* pPresentationParameters);
 
+    // D3D9Ex devices (Direct3DCreate9Ex) present and reset through these instead
+    DECLARE_HOOK(DX9PresentEx, HRESULT, __stdcall, __stdcall, IDirect3DDevice9Ex* pDevice,
+        const RECT* pSourceRect, const RECT* pDestRect, HWND hDestWindowOverride, const RGNDATA* pDirtyRegion, DWORD dwFlags);
+    DECLARE_HOOK(DX9ResetEx, HRESULT, __stdcall, __stdcall, IDirect3DDevice9Ex* pDevice,
+        D3DPRESENT_PARAMETERS* pPresentationParameters, D3DDISPLAYMODEEX* pFullscreenDisplayMode);
+
+    // Draw statistics, installed on demand
+    DECLARE_HOOK(DX9SetRenderState, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice, D3DRENDERSTATETYPE State, DWORD Value);
+    DECLARE_HOOK(DX9SetTexture, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice, DWORD Stage, IDirect3DBaseTexture9* pTexture);
+    DECLARE_HOOK(DX9DrawPrimitive, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice,
+        D3DPRIMITIVETYPE PrimitiveType, UINT StartVertex, UINT PrimitiveCount);
+    DECLARE_HOOK(DX9DrawIndexedPrimitive, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice,
+        D3DPRIMITIVETYPE PrimitiveType, INT BaseVertexIndex, UINT MinVertexIndex, UINT NumVertices, UINT StartIndex, UINT PrimitiveCount);
+    DECLARE_HOOK(DX9DrawPrimitiveUP, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice,
+        D3DPRIMITIVETYPE PrimitiveType, UINT PrimitiveCount, const void* pVertexStreamZeroData, UINT VertexStreamZeroStride);
+    DECLARE_HOOK(DX9DrawIndexedPrimitiveUP, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice,
+        D3DPRIMITIVETYPE PrimitiveType, UINT MinVertexIndex, UINT NumVertices, UINT PrimitiveCount, const void* pIndexData,
+        D3DFORMAT IndexDataFormat, const void* pVertexStreamZeroData, UINT VertexStreamZeroStride);
+    DECLARE_HOOK(DX9SetVertexShader, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice, IDirect3DVertexShader9* pShader);
+    DECLARE_HOOK(DX9SetPixelShader, HRESULT, __stdcall, __stdcall, LPDIRECT3DDEVICE9 pDevice, IDirect3DPixelShader9* pShader);
+
+    // IDirect3DDevice9, then IDirect3DSwapChain9 from 119, then the IDirect3DDevice9Ex additions from 129
     static uint150_t* g_MethodsTable = nullptr;
     static LPDIRECT3DDEVICE9 g_Device = nullptr;
+    static bool g_DrawHooksInstalled = false;
+    static thread_local bool t_InPresent = false;
 
     void DX9Hook::InitializeMethodTable() {
         DEBUG_LOG("DX9 InitMethodTable starting...");
@@ -79,46 +108,257 @@ namespace FrameJacker {
             return;
         }
 
+        IDirect3DSwapChain9* swapChain = nullptr;
+        if (device->GetSwapChain(0, &swapChain) < 0) {
+            DEBUG_LOG("GetSwapChain failed");
+            device->Release();
+            direct3D9->Release();
+            ::DestroyWindow(window);
+            ::UnregisterClassA(windowClass.lpszClassName, windowClass.hInstance);
+            return;
+        }
+
         DEBUG_LOG("DX9 device created, copying vtable");
 
-        g_MethodsTable = (uint150_t*)::calloc(119, sizeof(uint150_t));
+        g_MethodsTable = (uint150_t*)::calloc(119 + 10 + 15, sizeof(uint150_t));
         ::memcpy(g_MethodsTable, *(uint150_t**)device, 119 * sizeof(uint150_t));
+        ::memcpy(g_MethodsTable + 119, *(uint150_t**)swapChain, 10 * sizeof(uint150_t));
 
+        swapChain->Release();
         device->Release();
         direct3D9->Release();
+
+        // PresentEx and ResetEx only exist on D3D9Ex devices, which need a real adapter
+        void* Direct3DCreate9Ex = ::GetProcAddress(libD3D9, "Direct3DCreate9Ex");
+        IDirect3D9Ex* direct3D9Ex = nullptr;
+        IDirect3DDevice9Ex* deviceEx = nullptr;
+        if (Direct3DCreate9Ex
+            && SUCCEEDED(((HRESULT(__stdcall*)(UINT, IDirect3D9Ex**))(Direct3DCreate9Ex))(D3D_SDK_VERSION, &direct3D9Ex))
+            && SUCCEEDED(direct3D9Ex->CreateDeviceEx(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, window,
+                D3DCREATE_SOFTWARE_VERTEXPROCESSING | D3DCREATE_DISABLE_DRIVER_MANAGEMENT, &params, nullptr, &deviceEx))) {
+            ::memcpy(g_MethodsTable + 129, *(uint150_t**)deviceEx + 119, 15 * sizeof(uint150_t));
+            deviceEx->Release();
+        } else {
+            DEBUG_LOG("D3D9Ex device not available, PresentEx will not be hooked");
+        }
+        if (direct3D9Ex)
+            direct3D9Ex->Release();
+
         ::DestroyWindow(window);
         ::UnregisterClassA(windowClass.lpszClassName, windowClass.hInstance);
 
         DEBUG_LOG("DX9 method table initialized");
     }
 
-    static HRESULT __stdcall DX9EndSceneHook(LPDIRECT3DDEVICE9 pDevice) {
-        g_Device = pDevice;
+    static HRESULT __stdcall DX9SetRenderStateHook(LPDIRECT3DDEVICE9 pDevice, D3DRENDERSTATETYPE State, DWORD Value) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::RenderStateChanges);
+        return DX9SetRenderStateOriginal(pDevice, State, Value);
+    }
+
+    static HRESULT __stdcall DX9SetTextureHook(LPDIRECT3DDEVICE9 pDevice, DWORD Stage, IDirect3DBaseTexture9* pTexture) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::TextureBinds);
+        return DX9SetTextureOriginal(pDevice, Stage, pTexture);
+    }
+
+    static HRESULT __stdcall DX9DrawPrimitiveHook(LPDIRECT3DDEVICE9 pDevice,
+        D3DPRIMITIVETYPE PrimitiveType, UINT StartVertex, UINT PrimitiveCount) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::DrawCalls);
+        return DX9DrawPrimitiveOriginal(pDevice, PrimitiveType, StartVertex, PrimitiveCount);
+    }
+
+    static HRESULT __stdcall DX9DrawIndexedPrimitiveHook(LPDIRECT3DDEVICE9 pDevice,
+        D3DPRIMITIVETYPE PrimitiveType, INT BaseVertexIndex, UINT MinVertexIndex, UINT NumVertices, UINT StartIndex, UINT PrimitiveCount) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::DrawCalls);
+        return DX9DrawIndexedPrimitiveOriginal(pDevice, PrimitiveType, BaseVertexIndex, MinVertexIndex, NumVertices, StartIndex, PrimitiveCount);
+    }
+
+    static HRESULT __stdcall DX9DrawPrimitiveUPHook(LPDIRECT3DDEVICE9 pDevice,
+        D3DPRIMITIVETYPE PrimitiveType, UINT PrimitiveCount, const void* pVertexStreamZeroData, UINT VertexStreamZeroStride) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::DrawCalls);
+        return DX9DrawPrimitiveUPOriginal(pDevice, PrimitiveType, PrimitiveCount, pVertexStreamZeroData, VertexStreamZeroStride);
+    }
+
+    static HRESULT __stdcall DX9DrawIndexedPrimitiveUPHook(LPDIRECT3DDEVICE9 pDevice,
+        D3DPRIMITIVETYPE PrimitiveType, UINT MinVertexIndex, UINT NumVertices, UINT PrimitiveCount, const void* pIndexData,
+        D3DFORMAT IndexDataFormat, const void* pVertexStreamZeroData, UINT VertexStreamZeroStride) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::DrawCalls);
+        return DX9DrawIndexedPrimitiveUPOriginal(pDevice, PrimitiveType, MinVertexIndex, NumVertices, PrimitiveCount, pIndexData,
+            IndexDataFormat, pVertexStreamZeroData, VertexStreamZeroStride);
+    }
+
+    static HRESULT __stdcall DX9SetVertexShaderHook(LPDIRECT3DDEVICE9 pDevice, IDirect3DVertexShader9* pShader) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::ShaderChanges);
+        return DX9SetVertexShaderOriginal(pDevice, pShader);
+    }
+
+    static HRESULT __stdcall DX9SetPixelShaderHook(LPDIRECT3DDEVICE9 pDevice, IDirect3DPixelShader9* pShader) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::ShaderChanges);
+        return DX9SetPixelShaderOriginal(pDevice, pShader);
+    }
+
+    // Patched from the render thread at the end of a frame, so none of these is mid-call there.
+    // Once installed they stay until Uninstall and only check the flag.
+    static void InstallDrawHooks() {
+        DEBUG_LOG("Installing DX9 draw statistics hooks...");
+        INSTALL_HOOK_ADDRESS(DX9SetRenderState, g_MethodsTable[57]);
+        INSTALL_HOOK_ADDRESS(DX9SetTexture, g_MethodsTable[65]);
+        INSTALL_HOOK_ADDRESS(DX9DrawPrimitive, g_MethodsTable[81]);
+        INSTALL_HOOK_ADDRESS(DX9DrawIndexedPrimitive, g_MethodsTable[82]);
+        INSTALL_HOOK_ADDRESS(DX9DrawPrimitiveUP, g_MethodsTable[83]);
+        INSTALL_HOOK_ADDRESS(DX9DrawIndexedPrimitiveUP, g_MethodsTable[84]);
+        INSTALL_HOOK_ADDRESS(DX9SetVertexShader, g_MethodsTable[92]);
+        INSTALL_HOOK_ADDRESS(DX9SetPixelShader, g_MethodsTable[107]);
+
+        MemoryManager::ApplyMod("DX9SetRenderState");
+        MemoryManager::ApplyMod("DX9SetTexture");
+        MemoryManager::ApplyMod("DX9DrawPrimitive");
+        MemoryManager::ApplyMod("DX9DrawIndexedPrimitive");
+        MemoryManager::ApplyMod("DX9DrawPrimitiveUP");
+        MemoryManager::ApplyMod("DX9DrawIndexedPrimitiveUP");
+        MemoryManager::ApplyMod("DX9SetVertexShader");
+        MemoryManager::ApplyMod("DX9SetPixelShader");
+
+        g_DrawHooksInstalled = true;
+    }
+
+    // Shared by IDirect3DDevice9::Present, IDirect3DDevice9Ex::PresentEx and IDirect3DSwapChain9::Present.
+    // One runtime call may go through another, so a present nested on the same thread is passed
+    // straight through.
+    template<typename Present>
+    static HRESULT PresentFrame(LPDIRECT3DDEVICE9 pDevice, Present&& present) {
+        if (t_InPresent)
+            return present();
+
+        t_InPresent = true;
+        HRESULT result = D3D_OK;
+        {
+            CallbackScope callbacks;
+            callbacks.BeginFrame(API::D3D9, pDevice);
+
+            if (!FrameTracker::HasSurfaceSize(pDevice)) {
+                IDirect3DSwapChain9* swapChain = nullptr;
+                D3DPRESENT_PARAMETERS parameters = {};
+                if (SUCCEEDED(pDevice->GetSwapChain(0, &swapChain)))
+                    swapChain->GetPresentParameters(&parameters);
+                if (swapChain)
+                    swapChain->Release();
+                FrameTracker::SetSurfaceSize(pDevice, parameters.BackBufferWidth, parameters.BackBufferHeight);
+            }
+
+            g_Device = pDevice;
+
+            callbacks.OnPresent();
+
+            // The frame's scenes are over by the time it presents, so the overlay gets its own
+            if (callbacks.HasRender() && SUCCEEDED(pDevice->BeginScene())) {
+                RenderContext ctx = {};
+                ctx.api = API::D3D9;
+                ctx.device = pDevice;
+                ctx.commandBuffer = nullptr;
+                ctx.swapChain = nullptr;
+                ctx.renderTarget = nullptr;
+                ctx.imageIndex = 0;
+                ctx.extra = nullptr;
+
+                InternalWorkScope internal;
+                callbacks.OnRender(ctx);
+                pDevice->EndScene();
+            }
+
+            callbacks.BeginOriginalPresent();
+            result = present();
+
+            callbacks.OnPostPresent();
+        }
+        t_InPresent = false;
+
+        if (!g_DrawHooksInstalled && WorkCounters::IsDrawsEnabled() && g_MethodsTable)
+            InstallDrawHooks();
+
+        return result;
+    }
+
+    static HRESULT __stdcall DX9PresentHook(LPDIRECT3DDEVICE9 pDevice,
+        const RECT* pSourceRect, const RECT* pDestRect, HWND hDestWindowOverride, const RGNDATA* pDirtyRegion) {
+
+        return PresentFrame(pDevice, [&] {
+            return DX9PresentOriginal(pDevice, pSourceRect, pDestRect, hDestWindowOverride, pDirtyRegion);
+        });
+    }
+
+    static HRESULT __stdcall DX9PresentExHook(IDirect3DDevice9Ex* pDevice,
+        const RECT* pSourceRect, const RECT* pDestRect, HWND hDestWindowOverride, const RGNDATA* pDirtyRegion, DWORD dwFlags) {
+
+        return PresentFrame(pDevice, [&] {
+            return DX9PresentExOriginal(pDevice, pSourceRect, pDestRect, hDestWindowOverride, pDirtyRegion, dwFlags);
+        });
+    }
+
+    // Additional swap chains (CreateAdditionalSwapChain) present through here
+    static HRESULT __stdcall DX9SwapChainPresentHook(IDirect3DSwapChain9* pSwapChain,
+        const RECT* pSourceRect, const RECT* pDestRect, HWND hDestWindowOverride, const RGNDATA* pDirtyRegion, DWORD dwFlags) {
+
+        auto present = [&] {
+            return DX9SwapChainPresentOriginal(pSwapChain, pSourceRect, pDestRect, hDestWindowOverride, pDirtyRegion, dwFlags);
+        };
+
+        LPDIRECT3DDEVICE9 device = nullptr;
+        if (FAILED(pSwapChain->GetDevice(&device)))
+            return present();
+
+        // The swap chain keeps its device alive
+        device->Release();
+        return PresentFrame(device, present);
+    }
+
+    // Shared by Reset and ResetEx
+    template<typename Reset>
+    static HRESULT ResetDevice(LPDIRECT3DDEVICE9 pDevice, D3DPRESENT_PARAMETERS* pPresentationParameters, Reset&& reset) {
+        TimelineScope timeline("Reset");
+        CallbackScope callbacks;
+        ResizeEvent resize = { API::D3D9, 0, 0, 0, pDevice };
+        if (pPresentationParameters) {
+            resize.width = pPresentationParameters->BackBufferWidth;
+            resize.height = pPresentationParameters->BackBufferHeight;
+            resize.format = (uint32_t)pPresentationParameters->BackBufferFormat;
+        }
+        callbacks.OnResize(resize);
 
-        if (Hook::s_Callbacks.OnPresent)
-            Hook::s_Callbacks.OnPresent();
+        HRESULT result = reset();
 
-        if (Hook::s_Callbacks.OnRender) {
-            RenderContext ctx = {};
-            ctx.api = API::D3D9;
-            ctx.device = pDevice;
-            ctx.commandBuffer = nullptr;
-            ctx.swapChain = nullptr;
-            ctx.renderTarget = nullptr;
-            ctx.imageIndex = 0;
-            ctx.extra = nullptr;
+        FrameTracker::InvalidateSurfaceSize();
 
-            Hook::s_Callbacks.OnRender(ctx);
+        // Reset replaces zero width/height/format with the values it actually used
+        if (SUCCEEDED(result) && callbacks.IsCoalescingResize()) {
+            resize.width = pPresentationParameters->BackBufferWidth;
+            resize.height = pPresentationParameters->BackBufferHeight;
+            resize.format = (uint32_t)pPresentationParameters->BackBufferFormat;
+            callbacks.DeferResize(resize);
         }
 
-        return DX9EndSceneOriginal(pDevice);
+        return result;
     }
 
     static HRESULT __stdcall DX9ResetHook(LPDIRECT3DDEVICE9 pDevice, D3DPRESENT_PARAMETERS* pPresentationParameters) {
-        if (Hook::s_Callbacks.OnResize)
-            Hook::s_Callbacks.OnResize();
+        return ResetDevice(pDevice, pPresentationParameters, [&] {
+            return DX9ResetOriginal(pDevice, pPresentationParameters);
+        });
+    }
 
-        return DX9ResetOriginal(pDevice, pPresentationParameters);
+    static HRESULT __stdcall DX9ResetExHook(IDirect3DDevice9Ex* pDevice,
+        D3DPRESENT_PARAMETERS* pPresentationParameters, D3DDISPLAYMODEEX* pFullscreenDisplayMode) {
+
+        return ResetDevice(pDevice, pPresentationParameters, [&] {
+            return DX9ResetExOriginal(pDevice, pPresentationParameters, pFullscreenDisplayMode);
+        });
     }
 
     static DWORD WINAPI DX9InitThread(LPVOID lpParameter) {
@@ -135,12 +375,21 @@ namespace FrameJacker {
         }
 
         DEBUG_LOG("Installing DX9 hooks...");
-        INSTALL_HOOK_ADDRESS(DX9EndScene, g_MethodsTable[42]);
+        INSTALL_HOOK_ADDRESS(DX9Present, g_MethodsTable[17]);
+        INSTALL_HOOK_ADDRESS(DX9SwapChainPresent, g_MethodsTable[119 + 3]);
         INSTALL_HOOK_ADDRESS(DX9Reset, g_MethodsTable[16]);
 
-        MemoryManager::ApplyMod("DX9EndScene");
+        MemoryManager::ApplyMod("DX9Present");
+        MemoryManager::ApplyMod("DX9SwapChainPresent");
         MemoryManager::ApplyMod("DX9Reset");
 
+        if (g_MethodsTable[129 + 2]) {
+            INSTALL_HOOK_ADDRESS(DX9PresentEx, g_MethodsTable[129 + 2]);
+            INSTALL_HOOK_ADDRESS(DX9ResetEx, g_MethodsTable[129 + 13]);
+            MemoryManager::ApplyMod("DX9PresentEx");
+            MemoryManager::ApplyMod("DX9ResetEx");
+        }
+
         DEBUG_LOG("DX9 installation complete");
         return 0;
     }
@@ -160,8 +409,25 @@ namespace FrameJacker {
     }
 
     void DX9Hook::Uninstall() {
-        MemoryManager::RestoreAndEraseMod("DX9EndScene");
+        MemoryManager::RestoreAndEraseMod("DX9Present");
+        MemoryManager::RestoreAndEraseMod("DX9SwapChainPresent");
         MemoryManager::RestoreAndEraseMod("DX9Reset");
+        if (g_MethodsTable && g_MethodsTable[129 + 2]) {
+            MemoryManager::RestoreAndEraseMod("DX9PresentEx");
+            MemoryManager::RestoreAndEraseMod("DX9ResetEx");
+        }
+
+        if (g_DrawHooksInstalled) {
+            MemoryManager::RestoreAndEraseMod("DX9SetRenderState");
+            MemoryManager::RestoreAndEraseMod("DX9SetTexture");
+            MemoryManager::RestoreAndEraseMod("DX9DrawPrimitive");
+            MemoryManager::RestoreAndEraseMod("DX9DrawIndexedPrimitive");
+            MemoryManager::RestoreAndEraseMod("DX9DrawPrimitiveUP");
+            MemoryManager::RestoreAndEraseMod("DX9DrawIndexedPrimitiveUP");
+            MemoryManager::RestoreAndEraseMod("DX9SetVertexShader");
+            MemoryManager::RestoreAndEraseMod("DX9SetPixelShader");
+            g_DrawHooksInstalled = false;
+        }
 
         if (g_MethodsTable) {
             free(g_MethodsTable);
@@ -0,0 +1,270 @@
+#include "DXGIFrameLatency.h"
+#include "Clock.h"
+#include "TimelineRecorder.h"
+#include <dxgi.h>
+#include <dxgi1_3.h>
+#include <mutex>
+
+namespace FrameJacker {
+
+    static constexpr uint32_t kMaxSwapChains = 8;
+    static constexpr DWORD kWaitTimeoutMilliseconds = 100;
+    static constexpr uint64_t kStaleNanoseconds = 2000000000;      // Entries not presented for 2 s are reused
+
+    enum class LatencyMode : uint8_t {
+        Unchecked,
+        Waitable,       // We wait on the swap chain's object
+        Device,         // Set through IDXGIDevice1, DXGI blocks in Present
+        GameManaged,    // The game waits on the object itself, leave it alone
+        Unsupported
+    };
+
+    struct SwapChainLatency {
+        IDXGISwapChain* swapChain = nullptr;
+        HANDLE waitable = nullptr;
+        LatencyMode mode = LatencyMode::Unchecked;
+        uint32_t generation = 0;
+        uint32_t originalLatency = 0;       // 0 until captured
+        uint32_t timeouts = 0;
+        uint64_t lastSeen = 0;
+        bool recheck = false;               // Resized, look at the flags again on the next present
+    };
+
+    // Touched by present and resize hooks under g_Mutex, which is never held while waiting
+    static std::mutex g_Mutex;
+    static SwapChainLatency g_SwapChains[kMaxSwapChains];
+    static std::atomic<uint32_t> g_Tracked = 0;
+
+    // Swap chains whose waitable object the game asked for, kept across generations since the game
+    // only asks once
+    static IDXGISwapChain* g_GameWaited[kMaxSwapChains] = {};
+    static uint32_t g_GameWaitedNext = 0;
+
+    // Set while Setup fetches the object itself, so the hook doesn't take it for the game's
+    static thread_local bool t_OwnQuery = false;
+
+    static bool IsGameWaited(IDXGISwapChain* swapChain) {
+        for (IDXGISwapChain* waited : g_GameWaited) {
+            if (waited == swapChain)
+                return true;
+        }
+        return false;
+    }
+
+    static SwapChainLatency* Find(IDXGISwapChain* swapChain) {
+        for (auto& entry : g_SwapChains) {
+            if (entry.swapChain == swapChain)
+                return &entry;
+        }
+        return nullptr;
+    }
+
+    static void CloseWaitable(SwapChainLatency& entry) {
+        if (entry.waitable) {
+            ::CloseHandle(entry.waitable);
+            entry.waitable = nullptr;
+        }
+    }
+
+    static void SetLatency(SwapChainLatency& entry, uint32_t frames) {
+        IDXGISwapChain2* swapChain2 = nullptr;
+        if ((entry.mode == LatencyMode::Waitable || entry.mode == LatencyMode::GameManaged) &&
+            SUCCEEDED(entry.swapChain->QueryInterface(__uuidof(IDXGISwapChain2), (void**)&swapChain2))) {
+            if (!entry.originalLatency)
+                swapChain2->GetMaximumFrameLatency(&entry.originalLatency);
+            swapChain2->SetMaximumFrameLatency(frames);
+            swapChain2->Release();
+            return;
+        }
+
+        IDXGIDevice1* device = nullptr;
+        if (entry.mode == LatencyMode::Device &&
+            SUCCEEDED(entry.swapChain->GetDevice(__uuidof(IDXGIDevice1), (void**)&device))) {
+            if (!entry.originalLatency)
+                device->GetMaximumFrameLatency(&entry.originalLatency);
+            device->SetMaximumFrameLatency(frames);
+            device->Release();
+        }
+    }
+
+    static void Setup(SwapChainLatency& entry, uint32_t frames) {
+        CloseWaitable(entry);
+        entry.timeouts = 0;
+        entry.recheck = false;
+        entry.mode = LatencyMode::Unsupported;
+
+        DXGI_SWAP_CHAIN_DESC desc;
+        if (FAILED(entry.swapChain->GetDesc(&desc)))
+            return;
+
+        if (desc.Flags & DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT) {
+            // Each present signals the object once, waiting on it next to the game would take its signals
+            if (IsGameWaited(entry.swapChain)) {
+                entry.mode = LatencyMode::GameManaged;
+            }
+            else {
+                IDXGISwapChain2* swapChain2 = nullptr;
+                if (SUCCEEDED(entry.swapChain->QueryInterface(__uuidof(IDXGISwapChain2), (void**)&swapChain2))) {
+                    t_OwnQuery = true;
+                    entry.waitable = swapChain2->GetFrameLatencyWaitableObject();
+                    t_OwnQuery = false;
+                    swapChain2->Release();
+                }
+                if (entry.waitable)
+                    entry.mode = LatencyMode::Waitable;
+            }
+        }
+        else {
+            // D3D12 swap chains hand out their command queue here, which has no IDXGIDevice1
+            IDXGIDevice1* device = nullptr;
+            if (SUCCEEDED(entry.swapChain->GetDevice(__uuidof(IDXGIDevice1), (void**)&device))) {
+                device->Release();
+                entry.mode = LatencyMode::Device;
+            }
+        }
+
+        SetLatency(entry, frames);
+        DEBUG_LOG("Frame latency %u for swap chain %p (mode %u)", frames, entry.swapChain, (uint32_t)entry.mode);
+    }
+
+    // Gives the swap chain back its own latency and forgets it. It must still be alive.
+    static void Release(SwapChainLatency& entry) {
+        if (entry.originalLatency)
+            SetLatency(entry, entry.originalLatency);
+        CloseWaitable(entry);
+        entry = {};
+        g_Tracked.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    static SwapChainLatency* Add(IDXGISwapChain* swapChain, uint64_t now) {
+        SwapChainLatency* slot = nullptr;
+        for (auto& entry : g_SwapChains) {
+            if (!entry.swapChain) {
+                slot = &entry;
+                break;
+            }
+            if (now - entry.lastSeen > kStaleNanoseconds && (!slot || entry.lastSeen < slot->lastSeen))
+                slot = &entry;
+        }
+        if (!slot)
+            return nullptr;
+
+        // A stale swap chain may be gone already, so only drop our handle
+        if (slot->swapChain) {
+            CloseWaitable(*slot);
+            *slot = {};
+        }
+        else {
+            g_Tracked.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        slot->swapChain = swapChain;
+        return slot;
+    }
+
+    uint64_t DXGIFrameLatency::Wait(IDXGISwapChain* swapChain) {
+        uint32_t frames = s_Frames.load(std::memory_order_relaxed);
+        if (!frames && !g_Tracked.load(std::memory_order_relaxed))
+            return 0;
+
+        uint64_t now = Clock::Now();
+        SwapChainLatency* entry;
+        HANDLE waitable;
+        {
+            std::lock_guard<std::mutex> lock(g_Mutex);
+            uint32_t generation = s_Generation.load(std::memory_order_acquire);
+
+            entry = Find(swapChain);
+            if (entry && entry->generation != generation) {
+                Release(*entry);
+                entry = nullptr;
+            }
+            if (!frames)
+                return 0;
+
+            if (!entry) {
+                entry = Add(swapChain, now);
+                if (!entry)
+                    return 0;
+                entry->generation = generation;
+            }
+
+            entry->lastSeen = now;
+            if (entry->mode == LatencyMode::Unchecked || entry->recheck)
+                Setup(*entry, frames);
+            if (entry->mode != LatencyMode::Waitable) {
+                CloseWaitable(*entry);
+                return 0;
+            }
+            waitable = entry->waitable;
+        }
+
+        DWORD result = ::WaitForSingleObjectEx(waitable, kWaitTimeoutMilliseconds, TRUE);
+        uint64_t end = Clock::Now();
+        TimelineRecorder::Complete("FrameLatencyWait", now, end);
+
+        // Every present signals the object once. If it never comes, the game got the object before
+        // the hooks went in and is taking our signals; keep out of its way.
+        {
+            std::lock_guard<std::mutex> lock(g_Mutex);
+            if (entry->swapChain != swapChain) {
+                // Released or reused while we waited
+            }
+            else if (entry->mode != LatencyMode::Waitable) {
+                CloseWaitable(*entry);
+            }
+            else if (result != WAIT_TIMEOUT) {
+                entry->timeouts = 0;
+            }
+            else if (++entry->timeouts >= 2) {
+                DEBUG_LOG("Swap chain %p waits on its own latency object, not waiting on it", swapChain);
+                entry->mode = LatencyMode::GameManaged;
+                CloseWaitable(*entry);
+            }
+        }
+
+        return end - now;
+    }
+
+    void DXGIFrameLatency::NoteGameWaitable(IDXGISwapChain* swapChain) {
+        if (t_OwnQuery)
+            return;
+
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        if (!IsGameWaited(swapChain)) {
+            g_GameWaited[g_GameWaitedNext] = swapChain;
+            g_GameWaitedNext = (g_GameWaitedNext + 1) % kMaxSwapChains;
+        }
+
+        // The present hook may be waiting on our handle, so it closes it
+        SwapChainLatency* entry = Find(swapChain);
+        if (entry && entry->mode == LatencyMode::Waitable) {
+            DEBUG_LOG("Swap chain %p waits on its own latency object, not waiting on it", swapChain);
+            entry->mode = LatencyMode::GameManaged;
+        }
+    }
+
+    void DXGIFrameLatency::Invalidate(IDXGISwapChain* swapChain) {
+        if (!g_Tracked.load(std::memory_order_relaxed))
+            return;
+
+        // ResizeBuffers may change the swap chain flags, so look at it again on the next present.
+        // The latency captured before we changed it stays.
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        if (SwapChainLatency* entry = Find(swapChain))
+            entry->recheck = true;
+    }
+
+    void DXGIFrameLatency::Shutdown() {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        for (auto& entry : g_SwapChains) {
+            CloseWaitable(entry);
+            entry = {};
+        }
+        for (IDXGISwapChain*& waited : g_GameWaited)
+            waited = nullptr;
+        g_GameWaitedNext = 0;
+        g_Tracked.store(0, std::memory_order_relaxed);
+    }
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "FrameJacker.h"
+#include <atomic>
+
+struct IDXGISwapChain;
+
+namespace FrameJacker {
+
+    // Caps how many frames D3D11/D3D12 swap chains may queue. Swap chains created with
+    // DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT get the limit through their waitable
+    // object, which the present hooks then wait on before handing control back to the game, so the
+    // next frame starts when the queue has room rather than running up to three frames ahead. Other
+    // D3D11 swap chains get it through IDXGIDevice1. Tracked per swap chain; resize hooks invalidate.
+    // Swap chains whose game fetches the waitable object itself only get the limit, the game does the
+    // waiting.
+    class DXGIFrameLatency {
+    public:
+        static bool IsEnabled() { return s_Frames.load(std::memory_order_relaxed) != 0; }
+
+        // 0 gives every swap chain back the latency it had before
+        static void SetMaximumFrameLatency(uint32_t frames) {
+            s_Frames.store(frames, std::memory_order_relaxed);
+            s_Generation.fetch_add(1, std::memory_order_release);
+        }
+
+        // Present hooks call this once OnPostPresent is done and hand the result to the callback
+        // scope. Returns the nanoseconds spent waiting for a free slot in the queue.
+        static uint64_t Wait(IDXGISwapChain* swapChain);
+
+        // GetFrameLatencyWaitableObject hooks call this before the original
+        static void NoteGameWaitable(IDXGISwapChain* swapChain);
+
+        static void Invalidate(IDXGISwapChain* swapChain);
+        static void Shutdown();
+
+    private:
+        inline static std::atomic<uint32_t> s_Frames = 0;
+        inline static std::atomic<uint32_t> s_Generation = 0;
+    };
+
+}
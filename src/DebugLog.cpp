@@ -0,0 +1,14 @@
+#include "FrameJacker.h"
+
+namespace FrameJacker {
+    bool g_EnableDebugLogging = false;
+    LogFunction g_CustomLogHandler = nullptr;
+
+    void SetDebugLogging(bool enabled) {
+        g_EnableDebugLogging = enabled;
+    }
+
+    void SetLogHandler(LogFunction handler) {
+        g_CustomLogHandler = handler;
+    }
+}
@@ -1,20 +1,22 @@
 ﻿#include "FrameJacker.h"
+#include "CallbackRegistry.h"
+#include "FrameTelemetry.h"
+#include "SharedTelemetry.h"
+#include "TraceRecorder.h"
+#include "TimelineRecorder.h"
+#include "WorkCounters.h"
+#include "StutterDetector.h"
+#include "FramePacer.h"
+#include "LatencyScheduler.h"
+#include "DXGIFrameLatency.h"
+#include "VulkanSwapchainOverride.h"
+#include "OverlayLayer.h"
+#include "ResizeCoalescer.h"
 #include <Windows.h>
 
 namespace FrameJacker {
     std::unique_ptr<IGraphicsHook> Hook::s_ActiveHook = nullptr;
-    Callbacks Hook::s_Callbacks = {};
-    bool FrameJacker::g_EnableDebugLogging = false;
-    FrameJacker::LogFunction FrameJacker::g_CustomLogHandler = nullptr;
-
-    void FrameJacker::SetDebugLogging(bool enabled) {
-        g_EnableDebugLogging = enabled;
-    }
-
-    void FrameJacker::SetLogHandler(LogFunction handler) {
-        g_CustomLogHandler = handler;
-    }
-
+    SubscriptionId Hook::s_DefaultSubscription = 0;
 
     const char* APIToString(API api) {
         switch (api) {
@@ -83,6 +85,7 @@ namespace FrameJacker {
             return false;
         }
 
+        AsyncDispatcher::Start();
         return s_ActiveHook->Install();
     }
 
@@ -91,16 +94,183 @@ namespace FrameJacker {
             s_ActiveHook->Uninstall();
             s_ActiveHook.reset();
         }
+
+        AsyncDispatcher::Stop();
+        TraceRecorder::Stop();
+        Timeline::StopStreaming();
     }
 
     void Hook::SetCallbacks(const Callbacks& callbacks) {
-        s_Callbacks = callbacks;
+        if (!s_DefaultSubscription || !CallbackRegistry::Replace(s_DefaultSubscription, callbacks))
+            s_DefaultSubscription = CallbackRegistry::Subscribe(callbacks);
+    }
+
+    SubscriptionId Hook::Subscribe(const Callbacks& callbacks) {
+        return CallbackRegistry::Subscribe(callbacks);
+    }
+
+    bool Hook::Unsubscribe(SubscriptionId id) {
+        return CallbackRegistry::Unsubscribe(id);
+    }
+
+    uint64_t Hook::GetDroppedEvents(SubscriptionId id) {
+        return CallbackRegistry::GetDroppedEvents(id);
+    }
+
+    bool Hook::GetCallbackStats(SubscriptionId id, CallbackStats& stats) {
+        return CallbackRegistry::GetCallbackStats(id, stats);
+    }
+
+    std::vector<CallbackStats> Hook::GetCallbackStats() {
+        return CallbackRegistry::GetCallbackStats();
+    }
+
+    void Hook::SetResizeCoalescing(uint32_t settleMilliseconds) {
+        ResizeCoalescer::SetSettleTime(settleMilliseconds);
+    }
+
+    void Hook::SetRetainedOverlay(bool enabled, double maxRedrawsPerSecond) {
+        OverlayLayer::Configure(enabled, maxRedrawsPerSecond);
+    }
+
+    void Hook::InvalidateOverlay() {
+        OverlayLayer::Invalidate();
+    }
+
+    void Hook::SetFrameLimit(double fps) {
+        FramePacer::SetLimit(fps);
+    }
+
+    void Hook::SetLowLatencyMode(bool enabled) {
+        LatencyScheduler::SetEnabled(enabled);
+    }
+
+    void Hook::SetMaximumFrameLatency(uint32_t frames) {
+        DXGIFrameLatency::SetMaximumFrameLatency(frames > 16 ? 16 : frames);
+    }
+
+    void Hook::SetVulkanSwapchainPolicy(const VulkanSwapchainPolicy& policy) {
+        VulkanSwapchainOverride::SetPolicy(policy);
     }
 
     API Hook::GetActiveAPI() {
         return s_ActiveHook ? s_ActiveHook->GetAPI() : API::Auto;
     }
 
+    FrameStats Stats::Get() {
+        return FrameTelemetry::Snapshot();
+    }
+
+    OverheadStats Stats::GetOverhead() {
+        return FrameTelemetry::GetOverhead();
+    }
+
+    void Stats::Reset() {
+        FrameTelemetry::Reset();
+    }
+
+    void Stats::SetHistogramEnabled(bool enabled, uint32_t precisionBits) {
+        FrameTelemetry::SetHistogramEnabled(enabled, precisionBits);
+    }
+
+    Histogram Stats::GetHistogram() {
+        return FrameTelemetry::GetHistogram();
+    }
+
+    void Stats::SetSubmissionStatsEnabled(bool enabled) {
+        WorkCounters::SetSubmissionsEnabled(enabled);
+    }
+
+    SubmissionStats Stats::GetSubmissions() {
+        return WorkCounters::GetSubmissions();
+    }
+
+    void Stats::SetDrawStatsEnabled(bool enabled, bool measureCpuTime) {
+        WorkCounters::SetDrawsEnabled(enabled, measureCpuTime);
+    }
+
+    DrawStats Stats::GetDraws() {
+        return WorkCounters::GetDraws();
+    }
+
+    void Stats::SetStutterDetection(const StutterSettings& settings) {
+        StutterDetector::Configure(settings);
+    }
+
+    uint64_t Stats::GetStutterCount() {
+        return StutterDetector::GetStutterCount();
+    }
+
+    FrameLimitStats Stats::GetFrameLimit() {
+        return FramePacer::GetStats();
+    }
+
+    LatencyStats Stats::GetLatency() {
+        return LatencyScheduler::GetStats();
+    }
+
+    bool Trace::Start(const char* path) {
+        return TraceRecorder::Start(path);
+    }
+
+    void Trace::Stop() {
+        TraceRecorder::Stop();
+    }
+
+    bool Trace::IsRecording() {
+        return TraceRecorder::IsRecording();
+    }
+
+    uint64_t Trace::GetDroppedRecords() {
+        return TraceRecorder::GetDroppedRecords();
+    }
+
+    void Timeline::SetEnabled(bool enabled) {
+        TimelineRecorder::SetEnabled(enabled);
+    }
+
+    bool Timeline::IsEnabled() {
+        return TimelineRecorder::IsEnabled();
+    }
+
+    bool Timeline::Export(const char* path) {
+        return TimelineRecorder::Export(path);
+    }
+
+    bool Timeline::StartStreaming(const char* path) {
+        if (!TimelineRecorder::StartStreaming(path))
+            return false;
+
+        TimelineRecorder::SetEnabled(true);
+        return true;
+    }
+
+    void Timeline::StopStreaming() {
+        TimelineRecorder::SetEnabled(false);
+        TimelineRecorder::StopStreaming();
+    }
+
+    uint64_t Timeline::BeginZone() {
+        return TimelineRecorder::IsEnabled() ? Clock::Now() : 0;
+    }
+
+    void Timeline::EndZone(const char* name, uint64_t begin) {
+        if (begin)
+            TimelineRecorder::Complete(name, begin, Clock::Now());
+    }
+
+    uint64_t Timeline::GetDroppedEvents() {
+        return TimelineRecorder::GetDroppedEvents();
+    }
+
+    bool Stats::SetSharedTelemetryEnabled(bool enabled, uint32_t capacity) {
+        if (!enabled) {
+            SharedTelemetry::Close();
+            return true;
+        }
+        return SharedTelemetry::Open(capacity);
+    }
+
 
 
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "FramePacer.h"
+#include "Clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace FrameJacker {
+
+    static constexpr uint64_t kMinSpinNanoseconds = 50000;         // 50 us
+    static constexpr uint64_t kMaxSpinNanoseconds = 2000000;       // 2 ms
+
+    static std::atomic<bool> g_Busy = false;
+
+    // Pacing state, only touched with g_Busy held
+    static uint64_t g_Deadline = 0;
+
+    static std::atomic<uint64_t> g_SpinNanoseconds = 1000000;       // Starts at 1 ms and adapts
+
+    static std::atomic<uint64_t> g_Frames = 0;
+    static std::atomic<uint64_t> g_WaitTotal = 0;
+    static std::atomic<uint64_t> g_JitterTotal = 0;
+    static std::atomic<uint64_t> g_JitterMax = 0;
+    static std::atomic<uint64_t> g_Oversleep = 0;
+
+    static void CpuRelax() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+#ifdef _WIN32
+    // One timer per waiting thread. High resolution timers (Windows 10 1803+) wake within a few
+    // hundred microseconds; older systems fall back to a regular timer and a longer spin.
+    static HANDLE GetThreadTimer() {
+        static thread_local HANDLE timer = nullptr;
+        if (!timer) {
+            timer = ::CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+            if (!timer)
+                timer = ::CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        }
+        return timer;
+    }
+#endif
+
+    void FramePacer::SleepUntil(uint64_t deadline) {
+        uint64_t now = Clock::Now();
+        if (now >= deadline)
+            return;
+
+#ifdef _WIN32
+        HANDLE timer = GetThreadTimer();
+        LARGE_INTEGER due;
+        due.QuadPart = -(LONGLONG)((deadline - now) / 100);         // Relative, in 100 ns units
+        if (timer && due.QuadPart < 0 && ::SetWaitableTimerEx(timer, &due, 0, nullptr, nullptr, nullptr, 0))
+            ::WaitForSingleObject(timer, INFINITE);
+        else
+            ::Sleep((DWORD)((deadline - now) / 1000000));
+#else
+        timespec until;
+        until.tv_sec = (time_t)(deadline / 1000000000ull);
+        until.tv_nsec = (long)(deadline % 1000000000ull);
+        while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR) {}
+#endif
+    }
+
+    uint64_t FramePacer::WaitUntil(uint64_t deadline) {
+        // Sleep until the spin margin before the deadline and learn how late the timer woke
+        uint64_t spin = g_SpinNanoseconds.load(std::memory_order_relaxed);
+        if (deadline > spin) {
+            uint64_t wake = deadline - spin;
+            SleepUntil(wake);
+
+            uint64_t now = Clock::Now();
+            uint64_t oversleep = now > wake ? now - wake : 0;
+            uint64_t average = g_Oversleep.load(std::memory_order_relaxed);
+            average = average - average / 8 + oversleep / 8;
+            g_Oversleep.store(average, std::memory_order_relaxed);
+
+            // Cover the worst recent oversleep with some headroom, but don't burn a core on it
+            uint64_t target = std::max<uint64_t>(average * 2, oversleep) + kMinSpinNanoseconds;
+            spin = oversleep > spin ? oversleep + kMinSpinNanoseconds : spin - spin / 8 + target / 8;
+            g_SpinNanoseconds.store(std::clamp(spin, kMinSpinNanoseconds, kMaxSpinNanoseconds), std::memory_order_relaxed);
+        }
+
+        uint64_t now = Clock::Now();
+        while (now < deadline) {
+            CpuRelax();
+            now = Clock::Now();
+        }
+
+        return now - deadline;
+    }
+
+    void FramePacer::SetLimit(double fps) {
+        uint64_t interval = fps > 0.0 ? (uint64_t)(1000000000.0 / fps) : 0;
+        s_Interval.store(interval, std::memory_order_relaxed);
+
+        g_Frames.store(0, std::memory_order_relaxed);
+        g_WaitTotal.store(0, std::memory_order_relaxed);
+        g_JitterTotal.store(0, std::memory_order_relaxed);
+        g_JitterMax.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t FramePacer::Wait() {
+        uint64_t interval = s_Interval.load(std::memory_order_relaxed);
+        if (!interval || g_Busy.exchange(true, std::memory_order_acquire))
+            return 0;
+
+        uint64_t start = Clock::Now();
+        uint64_t deadline = g_Deadline + interval;
+
+        // Running late (or starting): restart the grid from now instead of rushing to catch up
+        if (!g_Deadline || deadline < start || deadline > start + interval) {
+            g_Deadline = start;
+            g_Busy.store(false, std::memory_order_release);
+            return 0;
+        }
+
+        uint64_t jitter = WaitUntil(deadline);
+        g_Deadline = deadline;
+        g_Busy.store(false, std::memory_order_release);
+
+        uint64_t waited = Clock::Now() - start;
+        g_Frames.fetch_add(1, std::memory_order_relaxed);
+        g_WaitTotal.fetch_add(waited, std::memory_order_relaxed);
+        g_JitterTotal.fetch_add(jitter, std::memory_order_relaxed);
+        if (jitter > g_JitterMax.load(std::memory_order_relaxed))
+            g_JitterMax.store(jitter, std::memory_order_relaxed);
+
+        return waited;
+    }
+
+    FrameLimitStats FramePacer::GetStats() {
+        FrameLimitStats stats = {};
+        uint64_t interval = s_Interval.load(std::memory_order_relaxed);
+        stats.targetFps = interval ? 1000000000.0 / interval : 0.0;
+        stats.frames = g_Frames.load(std::memory_order_relaxed);
+        if (stats.frames) {
+            stats.averageWaitMilliseconds = g_WaitTotal.load(std::memory_order_relaxed) / 1000000.0 / stats.frames;
+            stats.averageJitterMicroseconds = g_JitterTotal.load(std::memory_order_relaxed) / 1000.0 / stats.frames;
+        }
+        stats.maxJitterMicroseconds = g_JitterMax.load(std::memory_order_relaxed) / 1000.0;
+        stats.spinMicroseconds = g_SpinNanoseconds.load(std::memory_order_relaxed) / 1000.0;
+        return stats;
+    }
+
+}
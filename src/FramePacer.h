@@ -0,0 +1,31 @@
+#pragma once
+#include "FrameJacker.h"
+#include <atomic>
+
+namespace FrameJacker {
+
+    // Frame rate cap applied right before the original present. Sleeps on a high-resolution timer
+    // until shortly before the deadline and spins the rest; the spin margin follows the measured
+    // timer oversleep. Deadlines stay on a fixed grid so the average rate does not drift.
+    class FramePacer {
+    public:
+        static bool IsEnabled() { return s_Interval.load(std::memory_order_relaxed) != 0; }
+        static void SetLimit(double fps);
+
+        // Waits for the next deadline and returns the nanoseconds spent waiting
+        static uint64_t Wait();
+
+        static FrameLimitStats GetStats();
+
+        // Sleeps until about the given Clock time, never past it by more than the timer's slack.
+        // Returns immediately if it has already passed.
+        static void SleepUntil(uint64_t deadline);
+
+        // Sleep then spin, returns how far past the deadline it woke (0 if on time)
+        static uint64_t WaitUntil(uint64_t deadline);
+
+    private:
+        inline static std::atomic<uint64_t> s_Interval = 0;
+    };
+
+}
@@ -0,0 +1,251 @@
+#include "FrameTelemetry.h"
+#include "CallbackRegistry.h"
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <thread>
+
+namespace FrameJacker {
+
+    // Rolling window over the last kWindowFrames samples of one measurement. The counts per bucket
+    // are kept incrementally, adding the new sample and removing the one that leaves the window, so
+    // neither side ever sorts. Writers never wait for each other: each claims a slot, counts its
+    // sample and swaps it in, then uncounts whatever it swapped out. A sample is counted before it
+    // becomes visible and uncounted only by whoever takes it out, so with no writer in flight the
+    // buckets and sum describe exactly the samples in the slots.
+    struct RollingWindow {
+        std::atomic<uint64_t> samples[FrameTelemetry::kWindowFrames];     // Duration + 1, 0 = empty
+        std::atomic<uint16_t> buckets[FrameTelemetry::kBucketCount];
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> recorded;     // Since startup or the last Reset
+        std::atomic<uint64_t> next;         // Slot claims, never reset
+    };
+
+    struct WindowCopy {
+        uint16_t buckets[FrameTelemetry::kBucketCount];
+        uint64_t sum;
+        uint64_t recorded;
+        uint32_t count;
+    };
+
+    // Writes begun and finished. Readers only keep a copy taken while the two were equal and begun
+    // did not move.
+    static std::atomic<uint64_t> g_WritesBegun = 0;
+    static std::atomic<uint64_t> g_WritesFinished = 0;
+    static RollingWindow g_FrameTimes;         // Present to present
+    static RollingWindow g_PresentTimes;       // Blocked inside the original present
+
+    // Hook overhead is summed rather than windowed, plain relaxed counters are enough
+    static std::atomic<uint64_t> g_OverheadFrames = 0;
+    static std::atomic<uint64_t> g_OverheadTotal = 0;
+    static std::atomic<uint64_t> g_OverheadLast = 0;
+    static std::atomic<uint64_t> g_OverheadMax = 0;
+
+    // g_Histogram is what the present path records into, null while disabled. The session's
+    // histogram outlives a disable; one replaced by a different precision is retired to the
+    // callback registry, which frees it once no present hook can still be recording into it.
+    static std::atomic<Histogram*> g_Histogram = nullptr;
+    static std::mutex g_HistogramMutex;
+    static Histogram* g_SessionHistogram = nullptr;     // g_HistogramMutex held
+
+    static uint32_t BucketOf(uint64_t duration) {
+        uint64_t bucket = duration / FrameTelemetry::kBucketNanoseconds;
+        return bucket < FrameTelemetry::kBucketCount ? (uint32_t)bucket : FrameTelemetry::kBucketCount - 1;
+    }
+
+    static double BucketMilliseconds(uint32_t bucket) {
+        return ((double)bucket + 0.5) * FrameTelemetry::kBucketNanoseconds / 1e6;
+    }
+
+    static void BeginWrite() {
+        g_WritesBegun.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    static void EndWrite() {
+        g_WritesFinished.fetch_add(1, std::memory_order_release);
+    }
+
+    static void Uncount(RollingWindow& window, uint64_t stored) {
+        if (!stored)
+            return;
+
+        window.buckets[BucketOf(stored - 1)].fetch_sub(1, std::memory_order_relaxed);
+        window.sum.fetch_sub(stored - 1, std::memory_order_relaxed);
+    }
+
+    static void Add(RollingWindow& window, uint64_t duration) {
+        uint64_t index = window.next.fetch_add(1, std::memory_order_relaxed);
+
+        window.buckets[BucketOf(duration)].fetch_add(1, std::memory_order_relaxed);
+        window.sum.fetch_add(duration, std::memory_order_relaxed);
+        uint64_t evicted = window.samples[index % FrameTelemetry::kWindowFrames].exchange(duration + 1, std::memory_order_acq_rel);
+        Uncount(window, evicted);
+
+        window.recorded.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void Clear(RollingWindow& window) {
+        for (auto& sample : window.samples)
+            Uncount(window, sample.exchange(0, std::memory_order_acq_rel));
+        window.recorded.store(0, std::memory_order_relaxed);
+    }
+
+    static void CopyWindow(const RollingWindow& window, WindowCopy& copy) {
+        copy.count = 0;
+        for (uint32_t i = 0; i < FrameTelemetry::kBucketCount; i++) {
+            copy.buckets[i] = window.buckets[i].load(std::memory_order_relaxed);
+            copy.count += copy.buckets[i];
+        }
+        copy.sum = window.sum.load(std::memory_order_relaxed);
+        copy.recorded = window.recorded.load(std::memory_order_relaxed);
+    }
+
+    static void Copy(WindowCopy& frameTimes, WindowCopy& presentTimes) {
+        for (uint32_t attempt = 0;; attempt++) {
+            // Finished never passes begun, so equal values mean no write was in flight at either load
+            uint64_t finished = g_WritesFinished.load(std::memory_order_acquire);
+            uint64_t begun = g_WritesBegun.load(std::memory_order_relaxed);
+            if (finished == begun) {
+                CopyWindow(g_FrameTimes, frameTimes);
+                CopyWindow(g_PresentTimes, presentTimes);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (g_WritesBegun.load(std::memory_order_relaxed) == begun)
+                    return;
+            }
+
+            if (attempt >= 16)
+                std::this_thread::yield();
+        }
+    }
+
+    static double AverageMilliseconds(const WindowCopy& copy) {
+        return copy.count ? (double)copy.sum / copy.count / 1e6 : 0.0;
+    }
+
+    // Nearest rank, walking up from the fastest bucket
+    static double PercentileMilliseconds(const WindowCopy& copy, double percentile) {
+        uint32_t rank = (uint32_t)std::ceil(percentile * copy.count);
+        uint32_t seen = 0;
+        for (uint32_t bucket = 0; bucket < FrameTelemetry::kBucketCount; bucket++) {
+            seen += copy.buckets[bucket];
+            if (seen && seen >= rank)
+                return BucketMilliseconds(bucket);
+        }
+        return 0.0;
+    }
+
+    void FrameTelemetry::Record(uint64_t frameDuration) {
+        BeginWrite();
+        Add(g_FrameTimes, frameDuration);
+        EndWrite();
+
+        // The present hooks are already reading, this only nests
+        CallbackRegistry::EnterRead();
+        if (Histogram* histogram = g_Histogram.load(std::memory_order_acquire))
+            histogram->Record(frameDuration);
+        CallbackRegistry::LeaveRead();
+    }
+
+    void FrameTelemetry::RecordPresent(uint64_t presentDuration) {
+        BeginWrite();
+        Add(g_PresentTimes, presentDuration);
+        EndWrite();
+    }
+
+    void FrameTelemetry::RecordOverhead(uint64_t overheadDuration) {
+        g_OverheadFrames.fetch_add(1, std::memory_order_relaxed);
+        g_OverheadTotal.fetch_add(overheadDuration, std::memory_order_relaxed);
+        g_OverheadLast.store(overheadDuration, std::memory_order_relaxed);
+        if (overheadDuration > g_OverheadMax.load(std::memory_order_relaxed))
+            g_OverheadMax.store(overheadDuration, std::memory_order_relaxed);
+    }
+
+    FrameStats FrameTelemetry::Snapshot() {
+        WindowCopy frameTimes;
+        WindowCopy presentTimes;
+        Copy(frameTimes, presentTimes);
+
+        FrameStats stats = {};
+        stats.frames = frameTimes.recorded;
+        stats.windowFrames = frameTimes.count;
+
+        if (frameTimes.count) {
+            stats.averageMilliseconds = AverageMilliseconds(frameTimes);
+            stats.averageFps = stats.averageMilliseconds > 0.0 ? 1000.0 / stats.averageMilliseconds : 0.0;
+            stats.p50Milliseconds = PercentileMilliseconds(frameTimes, 0.50);
+            stats.p99Milliseconds = PercentileMilliseconds(frameTimes, 0.99);
+            stats.p999Milliseconds = PercentileMilliseconds(frameTimes, 0.999);
+
+            // 1% low: average frame time of the slowest 1% of the window, as FPS
+            uint32_t slowest = frameTimes.count / 100 ? frameTimes.count / 100 : 1;
+            uint32_t taken = 0;
+            double slowSum = 0.0;
+            for (uint32_t bucket = kBucketCount; bucket-- > 0 && taken < slowest;) {
+                uint32_t count = frameTimes.buckets[bucket] < slowest - taken ? frameTimes.buckets[bucket] : slowest - taken;
+                slowSum += count * BucketMilliseconds(bucket);
+                taken += count;
+            }
+            stats.onePercentLowFps = slowSum > 0.0 ? 1000.0 * taken / slowSum : 0.0;
+        }
+
+        if (presentTimes.count) {
+            stats.averagePresentMilliseconds = AverageMilliseconds(presentTimes);
+            stats.p99PresentMilliseconds = PercentileMilliseconds(presentTimes, 0.99);
+            stats.averageCpuMilliseconds = stats.averageMilliseconds > stats.averagePresentMilliseconds
+                ? stats.averageMilliseconds - stats.averagePresentMilliseconds : 0.0;
+        }
+
+        return stats;
+    }
+
+    void FrameTelemetry::Reset() {
+        BeginWrite();
+        Clear(g_FrameTimes);
+        Clear(g_PresentTimes);
+        EndWrite();
+
+        g_OverheadFrames.store(0, std::memory_order_relaxed);
+        g_OverheadTotal.store(0, std::memory_order_relaxed);
+        g_OverheadLast.store(0, std::memory_order_relaxed);
+        g_OverheadMax.store(0, std::memory_order_relaxed);
+    }
+
+    OverheadStats FrameTelemetry::GetOverhead() {
+        OverheadStats stats = {};
+        stats.frames = g_OverheadFrames.load(std::memory_order_relaxed);
+        stats.lastMicroseconds = g_OverheadLast.load(std::memory_order_relaxed) / 1000.0;
+        stats.averageMicroseconds = stats.frames ? g_OverheadTotal.load(std::memory_order_relaxed) / 1000.0 / stats.frames : 0.0;
+        stats.maxMicroseconds = g_OverheadMax.load(std::memory_order_relaxed) / 1000.0;
+        return stats;
+    }
+
+    void FrameTelemetry::SetHistogramEnabled(bool enabled, uint32_t precisionBits) {
+        std::lock_guard<std::mutex> lock(g_HistogramMutex);
+
+        if (!enabled) {
+            g_Histogram.store(nullptr, std::memory_order_release);
+            return;
+        }
+
+        // Same precision: carry on with the session's data
+        if (g_SessionHistogram && g_SessionHistogram->GetPrecisionBits() == precisionBits) {
+            g_Histogram.store(g_SessionHistogram, std::memory_order_release);
+            return;
+        }
+
+        Histogram* previous = g_SessionHistogram;
+        g_SessionHistogram = new Histogram(Histogram::kDefaultHighestValue, precisionBits);
+        g_Histogram.store(g_SessionHistogram, std::memory_order_release);
+        if (previous)
+            CallbackRegistry::Retire(previous, [](void* histogram) { delete static_cast<Histogram*>(histogram); });
+        DEBUG_LOG("Frame-time histogram enabled (%u precision bits, %zu bytes)", precisionBits, g_SessionHistogram->GetMemorySize());
+    }
+
+    Histogram FrameTelemetry::GetHistogram() {
+        std::lock_guard<std::mutex> lock(g_HistogramMutex);
+        return g_SessionHistogram ? *g_SessionHistogram : Histogram();
+    }
+
+}
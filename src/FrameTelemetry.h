@@ -0,0 +1,26 @@
+#pragma once
+#include "FrameJacker.h"
+
+namespace FrameJacker {
+
+    // Rolling frame-time and time-in-present statistics over the last kWindowFrames presents. The
+    // Record functions are called from the present hooks and never wait, for readers or for each
+    // other; Snapshot copies the windows and retries if a frame was recorded meanwhile.
+    class FrameTelemetry {
+    public:
+        static constexpr uint32_t kWindowFrames = 1024;
+        static constexpr uint64_t kBucketNanoseconds = 50000;      // 50 us
+        static constexpr uint32_t kBucketCount = 4000;              // Up to 200 ms, slower frames share the last bucket
+
+        static void Record(uint64_t frameDuration);
+        static void RecordPresent(uint64_t presentDuration);
+        static void RecordOverhead(uint64_t overheadDuration);
+        static FrameStats Snapshot();
+        static void Reset();
+        static OverheadStats GetOverhead();
+
+        static void SetHistogramEnabled(bool enabled, uint32_t precisionBits);
+        static Histogram GetHistogram();
+    };
+
+}
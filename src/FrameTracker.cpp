@@ -0,0 +1,64 @@
+#include "FrameTracker.h"
+#include "Clock.h"
+#include "FrameTelemetry.h"
+#include "SharedTelemetry.h"
+#include "TraceRecorder.h"
+#include "WorkCounters.h"
+#include <atomic>
+
+namespace FrameJacker {
+
+    static std::atomic<uint64_t> g_FrameIndex = 0;
+    static std::atomic<uint64_t> g_LastPresentTimestamp = 0;
+    static std::atomic<void*> g_SurfaceOwner = nullptr;
+    static std::atomic<uint64_t> g_SurfaceSize = 0;     // width << 32 | height
+
+    void FrameTracker::BeginFrame(FrameEvent& frame) {
+        frame.timestamp = Clock::Now();
+        frame.frameIndex = g_FrameIndex.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t previous = g_LastPresentTimestamp.exchange(frame.timestamp, std::memory_order_relaxed);
+        frame.previousFrameDuration = previous && frame.timestamp > previous ? frame.timestamp - previous : 0;
+
+        if (frame.previousFrameDuration)
+            FrameTelemetry::Record(frame.previousFrameDuration);
+
+        WorkCounters::EndFrame();
+    }
+
+    bool FrameTracker::HasSurfaceSize(void* swapChain) {
+        return g_SurfaceOwner.load(std::memory_order_relaxed) == swapChain;
+    }
+
+    void FrameTracker::SetSurfaceSize(void* swapChain, uint32_t width, uint32_t height) {
+        g_SurfaceSize.store((uint64_t)width << 32 | height, std::memory_order_relaxed);
+        g_SurfaceOwner.store(swapChain, std::memory_order_relaxed);
+    }
+
+    bool FrameTracker::GetSurfaceSize(void* swapChain, uint32_t& width, uint32_t& height) {
+        if (!HasSurfaceSize(swapChain))
+            return false;
+
+        uint64_t size = g_SurfaceSize.load(std::memory_order_relaxed);
+        width = (uint32_t)(size >> 32);
+        height = (uint32_t)size;
+        return true;
+    }
+
+    void FrameTracker::InvalidateSurfaceSize() {
+        g_SurfaceOwner.store(nullptr, std::memory_order_relaxed);
+    }
+
+    void FrameTracker::EndPresent(const FrameEvent& frame) {
+        FrameTelemetry::RecordPresent(frame.presentDuration);
+
+        uint64_t size = HasSurfaceSize(frame.swapChain) ? g_SurfaceSize.load(std::memory_order_relaxed) : 0;
+        SharedTelemetry::Publish(frame, (uint32_t)(size >> 32), (uint32_t)size);
+        TraceRecorder::Record(frame, (uint32_t)(size >> 32), (uint32_t)size);
+    }
+
+    void FrameTracker::EndFrame(uint64_t overheadNanoseconds) {
+        FrameTelemetry::RecordOverhead(overheadNanoseconds);
+    }
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "FrameJacker.h"
+
+namespace FrameJacker {
+
+    // Process-wide frame bookkeeping shared by every present hook, so subscribers don't each keep
+    // their own counters and timestamps.
+    class FrameTracker {
+    public:
+        // Fills frameIndex, timestamp and previousFrameDuration for a frame entering present
+        static void BeginFrame(FrameEvent& frame);
+
+        // Back buffer size of the swap chain (or device/HDC) presenting, as reported by the hooks.
+        // Present hooks query it when HasSurfaceSize is false, resize hooks invalidate it.
+        static bool HasSurfaceSize(void* swapChain);
+        static void SetSurfaceSize(void* swapChain, uint32_t width, uint32_t height);
+        static bool GetSurfaceSize(void* swapChain, uint32_t& width, uint32_t& height);
+        static void InvalidateSurfaceSize();
+
+        // Called once the original present has returned, with presentDuration filled in
+        static void EndPresent(const FrameEvent& frame);
+
+        // Called as the present hook returns, with the time spent in FrameJacker's own code
+        static void EndFrame(uint64_t overheadNanoseconds);
+    };
+
+}
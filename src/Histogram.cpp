@@ -0,0 +1,171 @@
+#include "FrameJacker/Histogram.h"
+#include <bit>
+
+namespace FrameJacker {
+
+    // A single bit scan instruction, Record runs on every present
+    static uint32_t HighestBit(uint64_t value) {
+        return (uint32_t)std::bit_width(value) - 1;
+    }
+
+    Histogram::Histogram(uint64_t highestValue, uint32_t precisionBits) {
+        m_PrecisionBits = precisionBits < 2 ? 2 : precisionBits > 20 ? 20 : precisionBits;
+        m_SubBucketCount = 1ull << m_PrecisionBits;
+        m_SubBucketHalfCount = m_SubBucketCount / 2;
+        m_HighestValue = highestValue < m_SubBucketCount ? m_SubBucketCount : highestValue;
+        m_BucketCount = IndexOf(m_HighestValue) + 1;
+        m_Counts.reset(new std::atomic<uint64_t>[m_BucketCount]);
+        Reset();
+    }
+
+    Histogram::Histogram(const Histogram& other)
+        : m_HighestValue(other.m_HighestValue), m_PrecisionBits(other.m_PrecisionBits),
+          m_SubBucketCount(other.m_SubBucketCount), m_SubBucketHalfCount(other.m_SubBucketHalfCount),
+          m_BucketCount(other.m_BucketCount), m_Counts(new std::atomic<uint64_t>[other.m_BucketCount]) {
+        for (size_t i = 0; i < m_BucketCount; i++)
+            m_Counts[i].store(other.m_Counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    Histogram& Histogram::operator=(const Histogram& other) {
+        if (this == &other)
+            return *this;
+
+        if (!IsCompatible(other)) {
+            m_HighestValue = other.m_HighestValue;
+            m_PrecisionBits = other.m_PrecisionBits;
+            m_SubBucketCount = other.m_SubBucketCount;
+            m_SubBucketHalfCount = other.m_SubBucketHalfCount;
+            m_BucketCount = other.m_BucketCount;
+            m_Counts.reset(new std::atomic<uint64_t>[m_BucketCount]);
+        }
+
+        for (size_t i = 0; i < m_BucketCount; i++)
+            m_Counts[i].store(other.m_Counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    // Values below m_SubBucketCount map to themselves. Above that, each power of two [2^k, 2^(k+1))
+    // is split into m_SubBucketHalfCount buckets of width 2^(k - precisionBits + 1).
+    size_t Histogram::IndexOf(uint64_t value) const {
+        if (value > m_HighestValue)
+            value = m_HighestValue;
+        if (value < m_SubBucketCount)
+            return (size_t)value;
+
+        uint32_t shift = HighestBit(value) - m_PrecisionBits + 1;
+        return (size_t)(shift * m_SubBucketHalfCount + (value >> shift));
+    }
+
+    uint64_t Histogram::LowestOf(size_t index) const {
+        if (index < m_SubBucketCount)
+            return index;
+
+        uint64_t shift = index / m_SubBucketHalfCount - 1;
+        return (index - shift * m_SubBucketHalfCount) << shift;
+    }
+
+    uint64_t Histogram::HighestOf(size_t index) const {
+        if (index < m_SubBucketCount)
+            return index;
+
+        uint64_t shift = index / m_SubBucketHalfCount - 1;
+        return ((index - shift * m_SubBucketHalfCount + 1) << shift) - 1;
+    }
+
+    void Histogram::Record(uint64_t value, uint64_t count) {
+        m_Counts[IndexOf(value)].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Histogram::Reset() {
+        for (size_t i = 0; i < m_BucketCount; i++)
+            m_Counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    bool Histogram::IsCompatible(const Histogram& other) const {
+        return m_HighestValue == other.m_HighestValue && m_PrecisionBits == other.m_PrecisionBits;
+    }
+
+    bool Histogram::Merge(const Histogram& other) {
+        if (!IsCompatible(other))
+            return false;
+
+        for (size_t i = 0; i < m_BucketCount; i++)
+            m_Counts[i].fetch_add(other.m_Counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return true;
+    }
+
+    bool Histogram::Subtract(const Histogram& other) {
+        if (!IsCompatible(other))
+            return false;
+
+        for (size_t i = 0; i < m_BucketCount; i++) {
+            uint64_t count = m_Counts[i].load(std::memory_order_relaxed);
+            uint64_t removed = other.m_Counts[i].load(std::memory_order_relaxed);
+            m_Counts[i].store(count > removed ? count - removed : 0, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    uint64_t Histogram::GetTotalCount() const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < m_BucketCount; i++)
+            total += m_Counts[i].load(std::memory_order_relaxed);
+        return total;
+    }
+
+    uint64_t Histogram::GetMin() const {
+        for (size_t i = 0; i < m_BucketCount; i++) {
+            if (m_Counts[i].load(std::memory_order_relaxed))
+                return LowestOf(i);
+        }
+        return 0;
+    }
+
+    uint64_t Histogram::GetMax() const {
+        for (size_t i = m_BucketCount; i-- > 0;) {
+            if (m_Counts[i].load(std::memory_order_relaxed))
+                return HighestOf(i);
+        }
+        return 0;
+    }
+
+    double Histogram::GetMean() const {
+        uint64_t total = 0;
+        double sum = 0.0;
+        for (size_t i = 0; i < m_BucketCount; i++) {
+            uint64_t count = m_Counts[i].load(std::memory_order_relaxed);
+            if (count) {
+                total += count;
+                sum += count * ((double)LowestOf(i) + (double)HighestOf(i)) / 2.0;
+            }
+        }
+        return total ? sum / total : 0.0;
+    }
+
+    uint64_t Histogram::GetValueAtPercentile(double percentile) const {
+        uint64_t total = GetTotalCount();
+        if (!total)
+            return 0;
+
+        percentile = percentile < 0.0 ? 0.0 : percentile > 100.0 ? 100.0 : percentile;
+        uint64_t rank = (uint64_t)(percentile / 100.0 * total + 0.5);
+        rank = rank ? rank : 1;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_BucketCount; i++) {
+            seen += m_Counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return HighestOf(i);
+        }
+        return GetMax();
+    }
+
+    uint64_t Histogram::GetLowestEquivalent(uint64_t value) const {
+        return LowestOf(IndexOf(value));
+    }
+
+    uint64_t Histogram::GetHighestEquivalent(uint64_t value) const {
+        return HighestOf(IndexOf(value));
+    }
+
+}
@@ -0,0 +1,142 @@
+#include "LatencyScheduler.h"
+#include "Clock.h"
+#include "FramePacer.h"
+#include <algorithm>
+
+namespace FrameJacker {
+
+    static constexpr uint64_t kMinBlockedNanoseconds = 250000;     // Below this the present did not really wait
+    static constexpr uint64_t kSafetyNanoseconds = 500000;         // Slack kept between the frame and its slot
+    static constexpr uint64_t kMaxDelayNanoseconds = 50000000;
+    static constexpr uint64_t kSwitchNanoseconds = 500000000;      // Follow another swap chain once this one goes quiet
+
+    static std::atomic<bool> g_Busy = false;
+    static std::atomic<bool> g_ResetPending = false;
+
+    // Presenting-thread state, only touched with g_Busy held
+    static void* g_SwapChain = nullptr;
+    static uint64_t g_LastSeen = 0;
+    static uint64_t g_FrameStart = 0;       // When the hook last returned to the game
+    static uint64_t g_LastPresentEnd = 0;
+    static uint64_t g_Delay = 0;
+    static uint64_t g_WorkAverage = 0;
+    static uint64_t g_WorkDeviation = 0;
+    static uint64_t g_Cycle = 0;            // Present-to-present pace while presents are blocking
+
+    static std::atomic<uint64_t> g_Frames = 0;
+    static std::atomic<uint64_t> g_DelayTotal = 0;
+    static std::atomic<uint64_t> g_LastDelay = 0;
+    static std::atomic<uint64_t> g_LastWork = 0;
+    static std::atomic<uint64_t> g_LastBlocked = 0;
+
+    static uint64_t Smooth(uint64_t average, uint64_t sample) {
+        return average ? average - average / 8 + sample / 8 : sample;
+    }
+
+    static void ResetState() {
+        g_FrameStart = 0;
+        g_LastPresentEnd = 0;
+        g_Delay = 0;
+        g_WorkAverage = 0;
+        g_WorkDeviation = 0;
+        g_Cycle = 0;
+    }
+
+    void LatencyScheduler::SetEnabled(bool enabled) {
+        g_ResetPending.store(true, std::memory_order_relaxed);
+        if (enabled) {
+            g_Frames.store(0, std::memory_order_relaxed);
+            g_DelayTotal.store(0, std::memory_order_relaxed);
+        }
+        s_Enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void LatencyScheduler::NoteResize() {
+        if (IsEnabled())
+            g_ResetPending.store(true, std::memory_order_relaxed);
+    }
+
+    uint64_t LatencyScheduler::Schedule(void* swapChain, uint64_t now, uint64_t submit, uint64_t presentEnd) {
+        if (swapChain != g_SwapChain) {
+            if (g_SwapChain && now - g_LastSeen < kSwitchNanoseconds)
+                return kSkipped;
+            g_SwapChain = swapChain;
+            ResetState();
+        }
+        g_LastSeen = now;
+
+        if (g_ResetPending.exchange(false, std::memory_order_relaxed))
+            ResetState();
+
+        // Warming up, or the game presented from somewhere we did not see start
+        if (!g_FrameStart || submit < g_FrameStart || presentEnd < submit) {
+            g_FrameStart = now;
+            g_LastPresentEnd = presentEnd;
+            return kSkipped;
+        }
+
+        uint64_t work = submit - g_FrameStart;
+        uint64_t blocked = presentEnd - submit;
+        uint64_t deviation = work > g_WorkAverage ? work - g_WorkAverage : g_WorkAverage - work;
+        g_WorkDeviation = Smooth(g_WorkDeviation, deviation);
+        g_WorkAverage = Smooth(g_WorkAverage, work);
+
+        if (blocked > kMinBlockedNanoseconds) {
+            // The present had to wait for its slot, so the gap between present returns is the pace
+            // the GPU or display sets, and the next slot opens about one gap after this one
+            g_Cycle = Smooth(g_Cycle, presentEnd - g_LastPresentEnd);
+
+            uint64_t budget = g_WorkAverage + g_WorkDeviation * 2 + kSafetyNanoseconds + (now - presentEnd);
+            uint64_t target = g_Cycle > budget ? std::min<uint64_t>(g_Cycle - budget, kMaxDelayNanoseconds) : 0;
+
+            // Creep up on a longer delay, but give time back at once
+            g_Delay = target > g_Delay ? g_Delay + (target - g_Delay) / 4 : target;
+        }
+        else {
+            // Nothing left to absorb: the frame was either just in time or CPU bound, so back off
+            g_Delay /= 2;
+        }
+        g_LastPresentEnd = presentEnd;
+        g_FrameStart = now + g_Delay;
+
+        g_LastWork.store(work, std::memory_order_relaxed);
+        g_LastBlocked.store(blocked, std::memory_order_relaxed);
+        return g_Delay;
+    }
+
+    uint64_t LatencyScheduler::Delay(void* swapChain, uint64_t submit, uint64_t presentEnd) {
+        if (g_Busy.exchange(true, std::memory_order_acquire))
+            return 0;
+
+        uint64_t now = Clock::Now();
+        uint64_t delay = Schedule(swapChain, now, submit, presentEnd);
+        if (delay == kSkipped) {
+            g_Busy.store(false, std::memory_order_release);
+            return 0;
+        }
+
+        if (delay)
+            FramePacer::WaitUntil(now + delay);
+        g_FrameStart = Clock::Now();
+        g_Busy.store(false, std::memory_order_release);
+
+        uint64_t slept = g_FrameStart - now;
+        g_Frames.fetch_add(1, std::memory_order_relaxed);
+        g_DelayTotal.fetch_add(slept, std::memory_order_relaxed);
+        g_LastDelay.store(slept, std::memory_order_relaxed);
+        return delay ? slept : 0;
+    }
+
+    LatencyStats LatencyScheduler::GetStats() {
+        LatencyStats stats = {};
+        stats.enabled = IsEnabled();
+        stats.frames = g_Frames.load(std::memory_order_relaxed);
+        if (stats.frames)
+            stats.averageDelayMilliseconds = g_DelayTotal.load(std::memory_order_relaxed) / 1000000.0 / stats.frames;
+        stats.delayMilliseconds = g_LastDelay.load(std::memory_order_relaxed) / 1000000.0;
+        stats.renderMilliseconds = g_LastWork.load(std::memory_order_relaxed) / 1000000.0;
+        stats.blockedMilliseconds = g_LastBlocked.load(std::memory_order_relaxed) / 1000000.0;
+        return stats;
+    }
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "FrameJacker.h"
+#include <atomic>
+
+namespace FrameJacker {
+
+    // Just-in-time frame start for the low latency mode. Learns how long the render thread takes to
+    // build a frame and when the next present will be able to go through, then holds the present
+    // hook back after the original present so the game starts (and samples input for) its next
+    // frame as late as it can without missing that slot. Follows one swap chain at a time.
+    class LatencyScheduler {
+    public:
+        static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+        static void SetEnabled(bool enabled);
+
+        // Called last in the post-present phase. submit is when the game called present, presentEnd
+        // when the original present returned; anything in between (frame limiter, a full queue,
+        // vsync) is time the frame could have started later. Returns the nanoseconds slept.
+        static uint64_t Delay(void* swapChain, uint64_t submit, uint64_t presentEnd);
+
+        // Delay's decision for a present seen at now, without the wait: how long to hold the frame
+        // back, or kSkipped while warming up or following another swap chain. The frame is taken to
+        // start once the delay has passed. Delay serializes it; tests call it with their own clock.
+        static constexpr uint64_t kSkipped = ~0ull;
+        static uint64_t Schedule(void* swapChain, uint64_t now, uint64_t submit, uint64_t presentEnd);
+
+        static void NoteResize();
+        static LatencyStats GetStats();
+
+    private:
+        inline static std::atomic<bool> s_Enabled = false;
+    };
+
+}
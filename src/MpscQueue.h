@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace FrameJacker {
+
+    // Bounded lock-free queue for any number of producers and exactly one consumer. TryPush fails
+    // instead of blocking when the consumer has fallen Capacity entries behind.
+    template<typename T, size_t Capacity>
+    class MpscQueue {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>, "MpscQueue elements must be trivially copyable");
+
+    public:
+        MpscQueue() {
+            for (size_t i = 0; i < Capacity; i++)
+                m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        bool TryPush(const T& value) {
+            size_t position = m_EnqueuePosition.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = m_Cells[position & (Capacity - 1)];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+                if (difference == 0) {
+                    if (m_EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        cell.value = value;
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0) {
+                    return false;
+                }
+                else {
+                    position = m_EnqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Consumer thread only
+        bool TryPop(T& value) {
+            Cell& cell = m_Cells[m_DequeuePosition & (Capacity - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if ((intptr_t)sequence - (intptr_t)(m_DequeuePosition + 1) < 0)
+                return false;
+
+            value = cell.value;
+            cell.sequence.store(m_DequeuePosition + Capacity, std::memory_order_release);
+            m_DequeuePosition++;
+            return true;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        Cell m_Cells[Capacity];
+        alignas(64) std::atomic<size_t> m_EnqueuePosition = 0;
+        alignas(64) size_t m_DequeuePosition = 0;
+    };
+
+}
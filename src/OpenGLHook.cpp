@@ -1,6 +1,11 @@
 #include "FrameJacker.h"
+#include "CallbackRegistry.h"
+#include "OpenGLOverlay.h"
+#include "OverlayLayer.h"
+#include "WorkCounters.h"
 #include <DetourMacros.hpp>
 #include <MemoryManager.h>
+#include <vector>
 #if FRAMEJACKER_INCLUDE_OPENGL
 #include <Windows.h>
 #include <gl/GL.h>
@@ -12,8 +17,30 @@ namespace FrameJacker {
 
     DECLARE_HOOK(wglSwapBuffers, BOOL, __stdcall, __stdcall, HDC hdc);
 
+    // Draw statistics, installed on demand. The first three are opengl32 exports, the rest come from
+    // the driver through wglGetProcAddress.
+    DECLARE_HOOK(GLDrawArrays, void, __stdcall, __stdcall, GLenum mode, GLint first, GLsizei count);
+    DECLARE_HOOK(GLDrawElements, void, __stdcall, __stdcall, GLenum mode, GLsizei count, GLenum type, const void* indices);
+    DECLARE_HOOK(GLBindTexture, void, __stdcall, __stdcall, GLenum target, GLuint texture);
+    DECLARE_HOOK(GLUseProgram, void, __stdcall, __stdcall, GLuint program);
+    DECLARE_HOOK(GLDrawRangeElements, void, __stdcall, __stdcall,
+        GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void* indices);
+    DECLARE_HOOK(GLDrawArraysInstanced, void, __stdcall, __stdcall, GLenum mode, GLint first, GLsizei count, GLsizei instanceCount);
+    DECLARE_HOOK(GLDrawElementsInstanced, void, __stdcall, __stdcall,
+        GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount);
+    DECLARE_HOOK(GLDrawElementsBaseVertex, void, __stdcall, __stdcall,
+        GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex);
+    DECLARE_HOOK(GLMultiDrawArrays, void, __stdcall, __stdcall,
+        GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawCount);
+    DECLARE_HOOK(GLMultiDrawElements, void, __stdcall, __stdcall,
+        GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawCount);
+    DECLARE_HOOK(GLDrawArraysIndirect, void, __stdcall, __stdcall, GLenum mode, const void* indirect);
+    DECLARE_HOOK(GLDrawElementsIndirect, void, __stdcall, __stdcall, GLenum mode, GLenum type, const void* indirect);
+
     static uint150_t* g_MethodsTable = nullptr;
     static HDC g_HDC = nullptr;
+    static bool g_DrawHooksInstalled = false;
+    static std::vector<const char*> g_DrawHookNames;
 
     void OpenGLHook::InitializeMethodTable() {
         DEBUG_LOG("OpenGL InitMethodTable starting...");
@@ -24,7 +51,7 @@ namespace FrameJacker {
             return;
         }
 
-        g_MethodsTable = (uint150_t*)::calloc(1, sizeof(uint150_t));
+        g_MethodsTable = (uint150_t*)::calloc(4, sizeof(uint150_t));
 
         void* wglSwapBuffersAddr = ::GetProcAddress(libOpenGL32, "wglSwapBuffers");
         if (!wglSwapBuffersAddr) {
@@ -35,17 +62,126 @@ namespace FrameJacker {
         }
 
         g_MethodsTable[0] = (uint150_t)wglSwapBuffersAddr;
+        g_MethodsTable[1] = (uint150_t)::GetProcAddress(libOpenGL32, "glDrawArrays");
+        g_MethodsTable[2] = (uint150_t)::GetProcAddress(libOpenGL32, "glDrawElements");
+        g_MethodsTable[3] = (uint150_t)::GetProcAddress(libOpenGL32, "glBindTexture");
 
         DEBUG_LOG("OpenGL method table initialized");
     }
 
+    static void __stdcall GLDrawArraysHook(GLenum mode, GLint first, GLsizei count) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLDrawArraysOriginal(mode, first, count);
+    }
+
+    static void __stdcall GLDrawElementsHook(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLDrawElementsOriginal(mode, count, type, indices);
+    }
+
+    static void __stdcall GLBindTextureHook(GLenum target, GLuint texture) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::TextureBinds);
+        GLBindTextureOriginal(target, texture);
+    }
+
+    static void __stdcall GLUseProgramHook(GLuint program) {
+        if (WorkCounters::IsDrawsEnabled())
+            WorkCounters::Count(WorkCounter::ShaderChanges);
+        GLUseProgramOriginal(program);
+    }
+
+    static void __stdcall GLDrawRangeElementsHook(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void* indices) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLDrawRangeElementsOriginal(mode, start, end, count, type, indices);
+    }
+
+    static void __stdcall GLDrawArraysInstancedHook(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLDrawArraysInstancedOriginal(mode, first, count, instanceCount);
+    }
+
+    static void __stdcall GLDrawElementsInstancedHook(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLDrawElementsInstancedOriginal(mode, count, type, indices, instanceCount);
+    }
+
+    static void __stdcall GLDrawElementsBaseVertexHook(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLDrawElementsBaseVertexOriginal(mode, count, type, indices, baseVertex);
+    }
+
+    static void __stdcall GLMultiDrawArraysHook(GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawCount) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLMultiDrawArraysOriginal(mode, first, count, drawCount);
+    }
+
+    static void __stdcall GLMultiDrawElementsHook(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawCount) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLMultiDrawElementsOriginal(mode, count, type, indices, drawCount);
+    }
+
+    static void __stdcall GLDrawArraysIndirectHook(GLenum mode, const void* indirect) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLDrawArraysIndirectOriginal(mode, indirect);
+    }
+
+    static void __stdcall GLDrawElementsIndirectHook(GLenum mode, GLenum type, const void* indirect) {
+        WorkScope work(WorkCounter::DrawCalls, WorkCounter::DrawNanoseconds);
+        GLDrawElementsIndirectOriginal(mode, type, indirect);
+    }
+
+    // wglGetProcAddress needs a current context and may return small integers instead of null
+    static uint150_t GetExtensionAddress(const char* name) {
+        uint150_t address = (uint150_t)::wglGetProcAddress(name);
+        return address > 3 && address != (uint150_t)-1 ? address : 0;
+    }
+
+#define FRAMEJACKER_INSTALL_GL_HOOK(name, address) \
+    if (address) { \
+        INSTALL_HOOK_ADDRESS(name, address); \
+        MemoryManager::ApplyMod(#name); \
+        g_DrawHookNames.push_back(#name); \
+    }
+
+    // Called from wglSwapBuffers, where the game's context is current, so the extension entry points
+    // can be resolved. They belong to the driver of that context.
+    static void InstallDrawHooks() {
+        DEBUG_LOG("Installing OpenGL draw statistics hooks...");
+        FRAMEJACKER_INSTALL_GL_HOOK(GLDrawArrays, g_MethodsTable[1]);
+        FRAMEJACKER_INSTALL_GL_HOOK(GLDrawElements, g_MethodsTable[2]);
+        FRAMEJACKER_INSTALL_GL_HOOK(GLBindTexture, g_MethodsTable[3]);
+        FRAMEJACKER_INSTALL_GL_HOOK(GLUseProgram, GetExtensionAddress("glUseProgram"));
+        FRAMEJACKER_INSTALL_GL_HOOK(GLDrawRangeElements, GetExtensionAddress("glDrawRangeElements"));
+        FRAMEJACKER_INSTALL_GL_HOOK(GLDrawArraysInstanced, GetExtensionAddress("glDrawArraysInstanced"));
+        FRAMEJACKER_INSTALL_GL_HOOK(GLDrawElementsInstanced, GetExtensionAddress("glDrawElementsInstanced"));
+        FRAMEJACKER_INSTALL_GL_HOOK(GLDrawElementsBaseVertex, GetExtensionAddress("glDrawElementsBaseVertex"));
+        FRAMEJACKER_INSTALL_GL_HOOK(GLMultiDrawArrays, GetExtensionAddress("glMultiDrawArrays"));
+        FRAMEJACKER_INSTALL_GL_HOOK(GLMultiDrawElements, GetExtensionAddress("glMultiDrawElements"));
+        FRAMEJACKER_INSTALL_GL_HOOK(GLDrawArraysIndirect, GetExtensionAddress("glDrawArraysIndirect"));
+        FRAMEJACKER_INSTALL_GL_HOOK(GLDrawElementsIndirect, GetExtensionAddress("glDrawElementsIndirect"));
+
+        DEBUG_LOG("%zu OpenGL draw statistics hooks installed", g_DrawHookNames.size());
+        g_DrawHooksInstalled = true;
+    }
+
+#undef FRAMEJACKER_INSTALL_GL_HOOK
+
     static BOOL __stdcall wglSwapBuffersHook(HDC hdc) {
+        CallbackScope callbacks;
+        callbacks.BeginFrame(API::OpenGL, hdc);
+
+        // There is no resize hook on OpenGL, so the window size is refreshed now and then
+        RECT client;
+        if ((!FrameTracker::HasSurfaceSize(hdc) || callbacks.GetFrame().frameIndex % 64 == 0)
+            && ::GetClientRect(::WindowFromDC(hdc), &client))
+            FrameTracker::SetSurfaceSize(hdc, (uint32_t)client.right, (uint32_t)client.bottom);
+
         g_HDC = hdc;
 
-        if (Hook::s_Callbacks.OnPresent)
-            Hook::s_Callbacks.OnPresent();
+        callbacks.OnPresent();
 
-        if (Hook::s_Callbacks.OnRender) {
+        if (callbacks.HasRender()) {
             RenderContext ctx = {};
             ctx.api = API::OpenGL;
             ctx.device = nullptr;
@@ -55,10 +191,20 @@ namespace FrameJacker {
             ctx.imageIndex = 0;
             ctx.extra = hdc;  // Pass HDC in extra
 
-            Hook::s_Callbacks.OnRender(ctx);
+            InternalWorkScope internal;
+            if (!OverlayLayer::IsEnabled() || !OpenGLOverlay::Render(callbacks, ctx))
+                callbacks.OnRender(ctx);
         }
 
-        return wglSwapBuffersOriginal(hdc);
+        callbacks.BeginOriginalPresent();
+        BOOL result = wglSwapBuffersOriginal(hdc);
+
+        callbacks.OnPostPresent();
+
+        if (!g_DrawHooksInstalled && WorkCounters::IsDrawsEnabled() && g_MethodsTable && ::wglGetCurrentContext())
+            InstallDrawHooks();
+
+        return result;
     }
 
     static DWORD WINAPI OpenGLInitThread(LPVOID lpParameter) {
@@ -100,6 +246,13 @@ namespace FrameJacker {
     void OpenGLHook::Uninstall() {
         MemoryManager::RestoreAndEraseMod("wglSwapBuffers");
 
+        for (const char* name : g_DrawHookNames)
+            MemoryManager::RestoreAndEraseMod(name);
+        g_DrawHookNames.clear();
+        g_DrawHooksInstalled = false;
+
+        OpenGLOverlay::Shutdown();
+
         if (g_MethodsTable) {
             free(g_MethodsTable);
             g_MethodsTable = nullptr;
@@ -0,0 +1,249 @@
+#include "OpenGLOverlay.h"
+#include "OverlayLayer.h"
+#if FRAMEJACKER_INCLUDE_OPENGL
+#include <Windows.h>
+#include <gl/GL.h>
+#endif
+#include <cstdint>
+#include <cstdio>
+
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_FRAMEBUFFER_BINDING 0x8CA6
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_CURRENT_PROGRAM 0x8B8D
+#define GL_CONTEXT_PROFILE_MASK 0x9126
+#define GL_CONTEXT_CORE_PROFILE_BIT 0x00000001
+
+namespace FrameJacker {
+
+    typedef void (APIENTRY* PFN_glGenFramebuffers_Custom)(GLsizei n, GLuint* framebuffers);
+    typedef void (APIENTRY* PFN_glDeleteFramebuffers_Custom)(GLsizei n, const GLuint* framebuffers);
+    typedef void (APIENTRY* PFN_glBindFramebuffer_Custom)(GLenum target, GLuint framebuffer);
+    typedef void (APIENTRY* PFN_glFramebufferTexture2D_Custom)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+    typedef GLenum (APIENTRY* PFN_glCheckFramebufferStatus_Custom)(GLenum target);
+    typedef void (APIENTRY* PFN_glUseProgram_Custom)(GLuint program);
+
+    struct OpenGLLayer {
+        HGLRC context = nullptr;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        GLuint texture = 0;
+        GLuint framebuffer = 0;
+        OverlayLayerState state;
+    };
+
+    static PFN_glGenFramebuffers_Custom g_glGenFramebuffers = nullptr;
+    static PFN_glDeleteFramebuffers_Custom g_glDeleteFramebuffers = nullptr;
+    static PFN_glBindFramebuffer_Custom g_glBindFramebuffer = nullptr;
+    static PFN_glFramebufferTexture2D_Custom g_glFramebufferTexture2D = nullptr;
+    static PFN_glCheckFramebufferStatus_Custom g_glCheckFramebufferStatus = nullptr;
+    static PFN_glUseProgram_Custom g_glUseProgram = nullptr;
+
+    static OpenGLLayer g_Layer;
+    static HGLRC g_UnsupportedContext = nullptr;
+    static bool g_FunctionsMissing = false;
+
+    static bool LoadFunctions() {
+        if (g_glGenFramebuffers)
+            return true;
+        if (g_FunctionsMissing)
+            return false;
+
+        g_glGenFramebuffers = (PFN_glGenFramebuffers_Custom)::wglGetProcAddress("glGenFramebuffers");
+        g_glDeleteFramebuffers = (PFN_glDeleteFramebuffers_Custom)::wglGetProcAddress("glDeleteFramebuffers");
+        g_glBindFramebuffer = (PFN_glBindFramebuffer_Custom)::wglGetProcAddress("glBindFramebuffer");
+        g_glFramebufferTexture2D = (PFN_glFramebufferTexture2D_Custom)::wglGetProcAddress("glFramebufferTexture2D");
+        g_glCheckFramebufferStatus = (PFN_glCheckFramebufferStatus_Custom)::wglGetProcAddress("glCheckFramebufferStatus");
+        g_glUseProgram = (PFN_glUseProgram_Custom)::wglGetProcAddress("glUseProgram");
+
+        if (!g_glGenFramebuffers || !g_glDeleteFramebuffers || !g_glBindFramebuffer || !g_glFramebufferTexture2D
+            || !g_glCheckFramebufferStatus) {
+            DEBUG_LOG("OpenGL framebuffer objects not available, overlay falls back to immediate rendering");
+            g_glGenFramebuffers = nullptr;
+            g_FunctionsMissing = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Profiles only exist from 3.2 on, asking an older context would raise GL_INVALID_ENUM
+    static bool IsCoreProfile() {
+        const char* version = (const char*)::glGetString(GL_VERSION);
+        int major = 0;
+        int minor = 0;
+        if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 || major * 10 + minor < 32)
+            return false;
+
+        GLint profileMask = 0;
+        ::glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &profileMask);
+        return (profileMask & GL_CONTEXT_CORE_PROFILE_BIT) != 0;
+    }
+
+    static void ReleaseLayer(OpenGLLayer& layer) {
+        // GL names belong to their context, so only delete them while it is current
+        if (layer.context && layer.context == ::wglGetCurrentContext()) {
+            if (layer.framebuffer)
+                g_glDeleteFramebuffers(1, &layer.framebuffer);
+            if (layer.texture)
+                ::glDeleteTextures(1, &layer.texture);
+        }
+
+        layer = OpenGLLayer();
+    }
+
+    static bool AcquireLayer(OpenGLLayer& layer, HGLRC context, GLsizei width, GLsizei height) {
+        if (layer.context == context && layer.width == width && layer.height == height && layer.framebuffer)
+            return true;
+
+        ReleaseLayer(layer);
+        layer.context = context;
+        layer.width = width;
+        layer.height = height;
+
+        GLint previousTexture = 0;
+        GLint previousFramebuffer = 0;
+        ::glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+        ::glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+        ::glGenTextures(1, &layer.texture);
+        ::glBindTexture(GL_TEXTURE_2D, layer.texture);
+        ::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        ::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        ::glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        g_glGenFramebuffers(1, &layer.framebuffer);
+        g_glBindFramebuffer(GL_FRAMEBUFFER, layer.framebuffer);
+        g_glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer.texture, 0);
+        bool complete = g_glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+        ::glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+        g_glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+
+        if (!complete) {
+            DEBUG_LOG("OpenGL overlay framebuffer incomplete (%dx%d)", width, height);
+            ReleaseLayer(layer);
+            return false;
+        }
+
+        DEBUG_LOG("OpenGL overlay layer created (%dx%d)", width, height);
+        return true;
+    }
+
+    static void Redraw(const CallbackScope& callbacks, RenderContext& ctx, OpenGLLayer& layer) {
+        GLint previousFramebuffer = 0;
+        GLint viewport[4];
+        ::glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        ::glGetIntegerv(GL_VIEWPORT, viewport);
+
+        g_glBindFramebuffer(GL_FRAMEBUFFER, layer.framebuffer);
+        ::glViewport(0, 0, layer.width, layer.height);
+
+        ::glPushAttrib(GL_COLOR_BUFFER_BIT | GL_SCISSOR_BIT);
+        ::glDisable(GL_SCISSOR_TEST);
+        ::glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        ::glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        ::glClear(GL_COLOR_BUFFER_BIT);
+        ::glPopAttrib();
+
+        ctx.renderTarget = (void*)(uintptr_t)layer.framebuffer;
+        callbacks.OnRender(ctx);
+
+        g_glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+        ::glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    static void Composite(OpenGLLayer& layer) {
+        GLint previousFramebuffer = 0;
+        GLint previousProgram = 0;
+        ::glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        if (g_glUseProgram)
+            ::glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+        ::glPushAttrib(GL_ALL_ATTRIB_BITS);
+        ::glPushClientAttrib(GL_CLIENT_ALL_ATTRIB_BITS);
+        ::glMatrixMode(GL_TEXTURE);
+        ::glPushMatrix();
+        ::glLoadIdentity();
+        ::glMatrixMode(GL_PROJECTION);
+        ::glPushMatrix();
+        ::glLoadIdentity();
+        ::glMatrixMode(GL_MODELVIEW);
+        ::glPushMatrix();
+        ::glLoadIdentity();
+
+        if (previousProgram)
+            g_glUseProgram(0);
+        g_glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        ::glViewport(0, 0, layer.width, layer.height);
+        ::glDisable(GL_DEPTH_TEST);
+        ::glDisable(GL_STENCIL_TEST);
+        ::glDisable(GL_SCISSOR_TEST);
+        ::glDisable(GL_CULL_FACE);
+        ::glDisable(GL_LIGHTING);
+        ::glDisable(GL_ALPHA_TEST);
+        ::glDisable(GL_FOG);
+        ::glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        ::glEnable(GL_BLEND);
+        ::glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        ::glEnable(GL_TEXTURE_2D);
+        ::glBindTexture(GL_TEXTURE_2D, layer.texture);
+        ::glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+        ::glBegin(GL_QUADS);
+        ::glTexCoord2f(0.0f, 0.0f); ::glVertex2f(-1.0f, -1.0f);
+        ::glTexCoord2f(1.0f, 0.0f); ::glVertex2f(1.0f, -1.0f);
+        ::glTexCoord2f(1.0f, 1.0f); ::glVertex2f(1.0f, 1.0f);
+        ::glTexCoord2f(0.0f, 1.0f); ::glVertex2f(-1.0f, 1.0f);
+        ::glEnd();
+
+        ::glMatrixMode(GL_MODELVIEW);
+        ::glPopMatrix();
+        ::glMatrixMode(GL_PROJECTION);
+        ::glPopMatrix();
+        ::glMatrixMode(GL_TEXTURE);
+        ::glPopMatrix();
+        ::glPopClientAttrib();
+        ::glPopAttrib();
+
+        g_glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+        if (previousProgram)
+            g_glUseProgram((GLuint)previousProgram);
+    }
+
+    bool OpenGLOverlay::Render(const CallbackScope& callbacks, RenderContext& ctx) {
+        HGLRC context = ::wglGetCurrentContext();
+        if (!context || context == g_UnsupportedContext || !LoadFunctions())
+            return false;
+
+        if (context != g_Layer.context && IsCoreProfile()) {
+            DEBUG_LOG("OpenGL core profile context, overlay falls back to immediate rendering");
+            g_UnsupportedContext = context;
+            return false;
+        }
+
+        // The present hook keeps the window size current
+        uint32_t width = 0;
+        uint32_t height = 0;
+        if (!FrameTracker::GetSurfaceSize(ctx.extra, width, height) || !width || !height)
+            return false;
+
+        if (!AcquireLayer(g_Layer, context, (GLsizei)width, (GLsizei)height))
+            return false;
+
+        if (OverlayLayer::ShouldRedraw(g_Layer.state, callbacks.GetFrame().timestamp))
+            Redraw(callbacks, ctx, g_Layer);
+
+        Composite(g_Layer);
+        return true;
+    }
+
+    void OpenGLOverlay::Shutdown() {
+        ReleaseLayer(g_Layer);
+        g_UnsupportedContext = nullptr;
+        g_FunctionsMissing = false;
+    }
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "FrameJacker.h"
+#include "CallbackRegistry.h"
+
+namespace FrameJacker {
+
+    // Retained overlay target for OpenGL. The layer is a framebuffer object per rendering context,
+    // composited with the fixed-function pipeline, so core profile contexts fall back to rendering
+    // every frame.
+    class OpenGLOverlay {
+    public:
+        // Returns false when the layer could not be set up, the caller then renders immediately
+        static bool Render(const CallbackScope& callbacks, RenderContext& ctx);
+
+        static void Shutdown();
+    };
+
+}
@@ -0,0 +1,38 @@
+#include "OverlayLayer.h"
+#include <atomic>
+
+namespace FrameJacker {
+
+    static std::atomic<bool> g_Enabled = false;
+    static std::atomic<uint64_t> g_RedrawInterval = 0;
+    static std::atomic<uint32_t> g_Generation = 0;
+
+    void OverlayLayer::Configure(bool enabled, double maxRedrawsPerSecond) {
+        g_RedrawInterval.store(maxRedrawsPerSecond > 0.0 ? (uint64_t)(1e9 / maxRedrawsPerSecond) : 0, std::memory_order_relaxed);
+        g_Enabled.store(enabled, std::memory_order_relaxed);
+        Invalidate();
+    }
+
+    bool OverlayLayer::IsEnabled() {
+        return g_Enabled.load(std::memory_order_relaxed);
+    }
+
+    void OverlayLayer::Invalidate() {
+        uint32_t generation = g_Generation.load(std::memory_order_relaxed) + 1;
+        // ~0 is reserved for layers that have never been drawn
+        g_Generation.store(generation == ~0u ? 0 : generation, std::memory_order_relaxed);
+    }
+
+    bool OverlayLayer::ShouldRedraw(OverlayLayerState& state, uint64_t now) {
+        uint32_t generation = g_Generation.load(std::memory_order_relaxed);
+        uint64_t interval = g_RedrawInterval.load(std::memory_order_relaxed);
+
+        if (state.generation == generation && (!interval || now - state.lastRedraw < interval))
+            return false;
+
+        state.generation = generation;
+        state.lastRedraw = now;
+        return true;
+    }
+
+}
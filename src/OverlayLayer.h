@@ -0,0 +1,23 @@
+#pragma once
+#include "FrameJacker.h"
+
+namespace FrameJacker {
+
+    struct OverlayLayerState {
+        uint32_t generation = ~0u;     // Invalidation generation last drawn, ~0 = never drawn
+        uint64_t lastRedraw = 0;
+    };
+
+    // Redraw policy for the retained overlay. Backends own the offscreen target per swap chain and
+    // ask here whether the user's OnRender has to run this frame or the previous content can be
+    // composited again.
+    class OverlayLayer {
+    public:
+        static void Configure(bool enabled, double maxRedrawsPerSecond);
+        static bool IsEnabled();
+        static void Invalidate();
+
+        static bool ShouldRedraw(OverlayLayerState& state, uint64_t now);
+    };
+
+}
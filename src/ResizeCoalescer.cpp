@@ -0,0 +1,46 @@
+#include "ResizeCoalescer.h"
+#include "Clock.h"
+#include <atomic>
+#include <mutex>
+
+namespace FrameJacker {
+
+    static std::atomic<uint64_t> g_SettleNanoseconds = 0;
+    static std::atomic<bool> g_Pending = false;
+
+    static std::mutex g_PendingMutex;
+    static ResizeEvent g_PendingResize = {};
+    static uint64_t g_LastResizeTimestamp = 0;
+
+    void ResizeCoalescer::SetSettleTime(uint32_t milliseconds) {
+        g_SettleNanoseconds.store((uint64_t)milliseconds * 1000000ull, std::memory_order_relaxed);
+    }
+
+    bool ResizeCoalescer::IsEnabled() {
+        return g_SettleNanoseconds.load(std::memory_order_relaxed) != 0;
+    }
+
+    void ResizeCoalescer::Defer(const ResizeEvent& resize) {
+        std::lock_guard<std::mutex> lock(g_PendingMutex);
+        g_PendingResize = resize;
+        g_PendingResize.settled = true;
+        g_LastResizeTimestamp = Clock::Now();
+        g_Pending.store(true, std::memory_order_release);
+    }
+
+    bool ResizeCoalescer::TakeSettled(uint64_t now, ResizeEvent& resize) {
+        if (!g_Pending.load(std::memory_order_acquire))
+            return false;
+
+        std::lock_guard<std::mutex> lock(g_PendingMutex);
+        if (!g_Pending.load(std::memory_order_relaxed))
+            return false;
+        if (now < g_LastResizeTimestamp + g_SettleNanoseconds.load(std::memory_order_relaxed))
+            return false;
+
+        resize = g_PendingResize;
+        g_Pending.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "FrameJacker.h"
+
+namespace FrameJacker {
+
+    // Holds back resize notifications until the swap chain size has stopped changing, then hands
+    // the last one to the next present.
+    class ResizeCoalescer {
+    public:
+        static void SetSettleTime(uint32_t milliseconds);
+        static bool IsEnabled();
+
+        static void Defer(const ResizeEvent& resize);
+        static bool TakeSettled(uint64_t now, ResizeEvent& resize);
+    };
+
+}
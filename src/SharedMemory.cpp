@@ -0,0 +1,141 @@
+#include "SharedMemory.h"
+#include <cstdint>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace FrameJacker {
+
+#ifdef _WIN32
+    bool SharedMemory::Create(const char* name, size_t size) {
+        Close();
+
+        HANDLE mapping = ::CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            (DWORD)((uint64_t)size >> 32), (DWORD)size, name);
+        if (!mapping)
+            return false;
+
+        void* view = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (!view) {
+            ::CloseHandle(mapping);
+            return false;
+        }
+
+        m_Mapping = mapping;
+        m_View = view;
+        m_Size = size;
+        return true;
+    }
+
+    bool SharedMemory::Open(const char* name) {
+        Close();
+
+        HANDLE mapping = ::OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+        if (!mapping)
+            return false;
+
+        void* view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        MEMORY_BASIC_INFORMATION info;
+        if (!view || !::VirtualQuery(view, &info, sizeof(info))) {
+            if (view)
+                ::UnmapViewOfFile(view);
+            ::CloseHandle(mapping);
+            return false;
+        }
+
+        m_Mapping = mapping;
+        m_View = view;
+        m_Size = info.RegionSize;
+        return true;
+    }
+
+    // The view keeps the section alive, the name goes with the last handle
+    void SharedMemory::Unlink() {
+        if (m_Mapping)
+            ::CloseHandle(m_Mapping);
+        m_Mapping = nullptr;
+    }
+
+    void SharedMemory::Close() {
+        if (m_View)
+            ::UnmapViewOfFile(m_View);
+        if (m_Mapping)
+            ::CloseHandle(m_Mapping);
+
+        m_View = nullptr;
+        m_Mapping = nullptr;
+        m_Size = 0;
+    }
+#else
+    bool SharedMemory::Create(const char* name, size_t size) {
+        Close();
+
+        // A previous process with the same id may have died without unlinking its ring
+        ::shm_unlink(name);
+        int descriptor = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (descriptor < 0)
+            return false;
+
+        void* view = MAP_FAILED;
+        if (::ftruncate(descriptor, (off_t)size) == 0)
+            view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        ::close(descriptor);
+
+        if (view == MAP_FAILED) {
+            ::shm_unlink(name);
+            return false;
+        }
+
+        strncpy(m_Name, name, sizeof(m_Name) - 1);
+        m_Owner = true;
+        m_View = view;
+        m_Size = size;
+        return true;
+    }
+
+    bool SharedMemory::Open(const char* name) {
+        Close();
+
+        int descriptor = ::shm_open(name, O_RDONLY, 0);
+        if (descriptor < 0)
+            return false;
+
+        struct stat info;
+        void* view = MAP_FAILED;
+        if (::fstat(descriptor, &info) == 0 && info.st_size > 0)
+            view = ::mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+        ::close(descriptor);
+
+        if (view == MAP_FAILED)
+            return false;
+
+        m_View = view;
+        m_Size = (size_t)info.st_size;
+        return true;
+    }
+
+    void SharedMemory::Unlink() {
+        if (m_Owner)
+            ::shm_unlink(m_Name);
+        m_Owner = false;
+    }
+
+    void SharedMemory::Close() {
+        if (m_View)
+            ::munmap(m_View, m_Size);
+        if (m_Owner)
+            ::shm_unlink(m_Name);
+
+        m_View = nullptr;
+        m_Size = 0;
+        m_Owner = false;
+    }
+#endif
+
+}
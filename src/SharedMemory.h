@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+
+namespace FrameJacker {
+
+    // Named shared memory: a pagefile-backed file mapping on Windows, POSIX shm elsewhere
+    class SharedMemory {
+    public:
+        SharedMemory() = default;
+        ~SharedMemory() { Close(); }
+
+        SharedMemory(const SharedMemory&) = delete;
+        SharedMemory& operator=(const SharedMemory&) = delete;
+
+        // Creates (or replaces a stale) read-write mapping, zero filled
+        bool Create(const char* name, size_t size);
+        // Maps an existing object read-only
+        bool Open(const char* name);
+        // Removes the name so nobody else can open it; the view stays mapped until Close
+        void Unlink();
+        void Close();
+
+        void* GetView() const { return m_View; }
+        size_t GetSize() const { return m_Size; }
+
+    private:
+        void* m_View = nullptr;
+        size_t m_Size = 0;
+#ifdef _WIN32
+        void* m_Mapping = nullptr;
+#else
+        char m_Name[64] = {};
+        bool m_Owner = false;
+#endif
+    };
+
+}
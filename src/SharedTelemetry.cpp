@@ -0,0 +1,117 @@
+#include "SharedTelemetry.h"
+#include "SharedMemory.h"
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace FrameJacker {
+
+    // Rings taken down while a present may still be writing into them stay mapped, unnamed, until
+    // an Open or Close finds no present in Publish. g_Mutex held for both.
+    static std::unique_ptr<SharedMemory> g_Memory;
+    static std::vector<std::unique_ptr<SharedMemory>> g_StaleMemory;
+    static std::mutex g_Mutex;
+    static std::atomic<SharedTelemetryHeader*> g_Header = nullptr;
+    static std::atomic<uint32_t> g_ActivePublishers = 0;
+
+    static uint32_t CurrentProcessId() {
+#ifdef _WIN32
+        return (uint32_t)::GetCurrentProcessId();
+#else
+        return (uint32_t)::getpid();
+#endif
+    }
+
+    static void Unpublish() {
+        if (g_Header.exchange(nullptr)) {
+            // Readers opening from now on must not find it, a present that already picked up the
+            // header may still be writing into it
+            g_Memory->Unlink();
+            g_StaleMemory.push_back(std::move(g_Memory));
+        }
+
+        // Sequentially consistent, pairs with Publish: once no present is in there, none can still
+        // hold a header loaded before the exchange
+        if (!g_ActivePublishers.load())
+            g_StaleMemory.clear();
+    }
+
+    bool SharedTelemetry::Open(uint32_t capacity) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        Unpublish();
+
+        uint32_t rounded = 2;
+        while (rounded < capacity && rounded < (1u << 20))
+            rounded <<= 1;
+
+        char name[64];
+        uint32_t processId = CurrentProcessId();
+        FormatSharedTelemetryName(processId, name, sizeof(name));
+
+        size_t size = sizeof(SharedTelemetryHeader) + (size_t)rounded * sizeof(SharedFrameRecord);
+        auto memory = std::make_unique<SharedMemory>();
+        if (!memory->Create(name, size)) {
+            DEBUG_LOG("Failed to create shared telemetry ring %s", name);
+            return false;
+        }
+        g_Memory = std::move(memory);
+
+        auto* header = ::new (g_Memory->GetView()) SharedTelemetryHeader();
+        header->version = kSharedTelemetryVersion;
+        header->capacity = rounded;
+        header->recordSize = sizeof(SharedFrameRecord);
+        header->headerSize = sizeof(SharedTelemetryHeader);
+        header->processId = processId;
+        header->published.store(0, std::memory_order_relaxed);
+
+        auto* records = reinterpret_cast<SharedFrameRecord*>(header + 1);
+        for (uint32_t i = 0; i < rounded; i++)
+            ::new (&records[i]) SharedFrameRecord();
+
+        header->magic.store(kSharedTelemetryMagic, std::memory_order_release);
+        g_Header.store(header, std::memory_order_release);
+
+        DEBUG_LOG("Shared telemetry ring %s created (%u records)", name, rounded);
+        return true;
+    }
+
+    void SharedTelemetry::Close() {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        Unpublish();
+    }
+
+    void SharedTelemetry::Publish(const FrameEvent& frame, uint32_t width, uint32_t height) {
+        if (!g_Header.load(std::memory_order_relaxed))
+            return;
+
+        // Sequentially consistent, pairs with the exchange in Unpublish
+        g_ActivePublishers.fetch_add(1);
+        SharedTelemetryHeader* header = g_Header.load();
+        if (header) {
+            // Claiming the slot first keeps presents from two threads from writing the same record
+            uint64_t index = header->published.fetch_add(1, std::memory_order_relaxed);
+            auto& slot = reinterpret_cast<SharedFrameRecord*>(header + 1)[index & (header->capacity - 1)];
+
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            slot.frameIndex.store(frame.frameIndex, std::memory_order_relaxed);
+            slot.timestamp.store(frame.timestamp, std::memory_order_relaxed);
+            slot.frameDuration.store(frame.previousFrameDuration, std::memory_order_relaxed);
+            slot.presentDuration.store(frame.presentDuration, std::memory_order_relaxed);
+            slot.api.store((uint32_t)frame.api, std::memory_order_relaxed);
+            slot.width.store(width, std::memory_order_relaxed);
+            slot.height.store(height, std::memory_order_relaxed);
+
+            slot.sequence.store(2 * index + 2, std::memory_order_release);
+        }
+        g_ActivePublishers.fetch_sub(1, std::memory_order_release);
+    }
+
+}
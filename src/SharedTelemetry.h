@@ -0,0 +1,17 @@
+#pragma once
+#include "FrameJacker.h"
+#include "FrameJacker/SharedTelemetry.h"
+
+namespace FrameJacker {
+
+    // Writer side of the shared telemetry ring. Publish only touches the mapped memory, so the
+    // render thread never makes a system call for it.
+    class SharedTelemetry {
+    public:
+        static bool Open(uint32_t capacity);
+        static void Close();
+
+        static void Publish(const FrameEvent& frame, uint32_t width, uint32_t height);
+    };
+
+}
@@ -0,0 +1,91 @@
+#include "FrameJacker/SharedTelemetry.h"
+#include "SharedMemory.h"
+
+namespace FrameJacker {
+
+    SharedTelemetryReader::~SharedTelemetryReader() {
+        Close();
+    }
+
+    bool SharedTelemetryReader::Open(uint32_t processId) {
+        Close();
+
+        char name[64];
+        FormatSharedTelemetryName(processId, name, sizeof(name));
+
+        auto* mapping = new SharedMemory();
+        if (!mapping->Open(name) || mapping->GetSize() < sizeof(SharedTelemetryHeader)) {
+            delete mapping;
+            return false;
+        }
+
+        auto* header = static_cast<const SharedTelemetryHeader*>(mapping->GetView());
+        bool valid = header->magic.load(std::memory_order_acquire) == kSharedTelemetryMagic
+            && header->version == kSharedTelemetryVersion
+            && header->recordSize == sizeof(SharedFrameRecord)
+            && header->capacity && (header->capacity & (header->capacity - 1)) == 0
+            && header->headerSize + (size_t)header->capacity * header->recordSize <= mapping->GetSize();
+
+        if (!valid) {
+            delete mapping;
+            return false;
+        }
+
+        m_Mapping = mapping;
+        m_Header = header;
+        m_Records = reinterpret_cast<const SharedFrameRecord*>(reinterpret_cast<const char*>(header) + header->headerSize);
+
+        uint64_t published = header->published.load(std::memory_order_acquire);
+        m_Next = published > header->capacity ? published - header->capacity : 0;
+        m_Missed = 0;
+        return true;
+    }
+
+    void SharedTelemetryReader::Close() {
+        delete static_cast<SharedMemory*>(m_Mapping);
+        m_Mapping = nullptr;
+        m_Header = nullptr;
+        m_Records = nullptr;
+    }
+
+    size_t SharedTelemetryReader::Read(FrameRecord* records, size_t maxRecords) {
+        if (!m_Header)
+            return 0;
+
+        uint64_t capacity = m_Header->capacity;
+        uint64_t published = m_Header->published.load(std::memory_order_acquire);
+        if (published - m_Next > capacity) {
+            m_Missed += published - capacity - m_Next;
+            m_Next = published - capacity;
+        }
+
+        size_t count = 0;
+        while (m_Next < published && count < maxRecords) {
+            const SharedFrameRecord& slot = m_Records[m_Next & (capacity - 1)];
+            uint64_t expected = 2 * m_Next + 2;
+
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence < expected)
+                break;  // Still being written, pick it up on the next poll
+
+            FrameRecord& record = records[count];
+            record.frameIndex = slot.frameIndex.load(std::memory_order_relaxed);
+            record.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+            record.frameDuration = slot.frameDuration.load(std::memory_order_relaxed);
+            record.presentDuration = slot.presentDuration.load(std::memory_order_relaxed);
+            record.api = slot.api.load(std::memory_order_relaxed);
+            record.width = slot.width.load(std::memory_order_relaxed);
+            record.height = slot.height.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence == expected && slot.sequence.load(std::memory_order_relaxed) == sequence)
+                count++;
+            else
+                m_Missed++;
+            m_Next++;
+        }
+
+        return count;
+    }
+
+}
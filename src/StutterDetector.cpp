@@ -0,0 +1,150 @@
+#include "StutterDetector.h"
+#include "WorkCounters.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace FrameJacker {
+
+    // Settings are copied by the presenting thread when the generation changes
+    static std::mutex g_SettingsMutex;
+    static StutterSettings g_Settings;
+    static std::atomic<uint32_t> g_SettingsGeneration = 0;
+
+    static std::atomic<bool> g_Busy = false;
+    static std::atomic<bool> g_ResizePending = false;
+    static std::atomic<uint64_t> g_Stutters = 0;
+
+    // Presenting-thread state, only touched with g_Busy held
+    static StutterSettings g_Active;
+    static uint32_t g_ActiveGeneration = 0;
+    static uint64_t g_Window[StutterDetector::kMaxWindowFrames];           // Arrival order
+    static uint64_t g_Sorted[StutterDetector::kMaxWindowFrames];
+    static uint32_t g_WindowCount = 0;
+    static uint32_t g_WindowNext = 0;
+    static StutterFrame g_History[StutterDetector::kHistoryCapacity];
+    static uint64_t g_HistoryCount = 0;
+
+    static thread_local std::vector<StutterFrame> t_EventHistory;
+    static thread_local StutterEvent t_Event;
+
+    void StutterDetector::Configure(const StutterSettings& settings) {
+        {
+            std::lock_guard<std::mutex> lock(g_SettingsMutex);
+            g_Settings = settings;
+            g_Settings.WindowFrames = std::clamp<uint32_t>(settings.WindowFrames, 8, kMaxWindowFrames);
+            g_Settings.HistoryFrames = std::clamp<uint32_t>(settings.HistoryFrames, 1, kHistoryCapacity);
+        }
+
+        g_SettingsGeneration.fetch_add(1, std::memory_order_release);
+        s_Enabled.store(settings.Enabled, std::memory_order_relaxed);
+    }
+
+    void StutterDetector::NoteResize() {
+        if (IsEnabled())
+            g_ResizePending.store(true, std::memory_order_relaxed);
+    }
+
+    uint64_t StutterDetector::GetStutterCount() {
+        return g_Stutters.load(std::memory_order_relaxed);
+    }
+
+    static void ApplySettings(uint32_t generation) {
+        std::lock_guard<std::mutex> lock(g_SettingsMutex);
+        g_Active = g_Settings;
+        g_ActiveGeneration = generation;
+        g_WindowCount = 0;
+        g_WindowNext = 0;
+    }
+
+    static void AddToWindow(uint64_t duration) {
+        uint32_t size = g_Active.WindowFrames;
+
+        // Keep g_Sorted ordered: drop the sample leaving the window, then insert the new one
+        if (g_WindowCount == size) {
+            uint64_t oldest = g_Window[g_WindowNext];
+            uint64_t* position = std::lower_bound(g_Sorted, g_Sorted + g_WindowCount, oldest);
+            memmove(position, position + 1, (g_Sorted + g_WindowCount - position - 1) * sizeof(uint64_t));
+            g_WindowCount--;
+        }
+
+        uint64_t* position = std::upper_bound(g_Sorted, g_Sorted + g_WindowCount, duration);
+        memmove(position + 1, position, (g_Sorted + g_WindowCount - position) * sizeof(uint64_t));
+        *position = duration;
+        g_WindowCount++;
+
+        g_Window[g_WindowNext] = duration;
+        g_WindowNext = (g_WindowNext + 1) % size;
+    }
+
+    static uint64_t Median() {
+        return g_Sorted[g_WindowCount / 2];
+    }
+
+    static uint64_t MedianAbsoluteDeviation(uint64_t median) {
+        uint64_t deviations[StutterDetector::kMaxWindowFrames];
+        for (uint32_t i = 0; i < g_WindowCount; i++)
+            deviations[i] = g_Sorted[i] > median ? g_Sorted[i] - median : median - g_Sorted[i];
+
+        std::nth_element(deviations, deviations + g_WindowCount / 2, deviations + g_WindowCount);
+        return deviations[g_WindowCount / 2];
+    }
+
+    const StutterEvent* StutterDetector::Update(const FrameEvent& frame) {
+        if (!IsEnabled() || g_Busy.exchange(true, std::memory_order_acquire))
+            return nullptr;
+
+        uint32_t generation = g_SettingsGeneration.load(std::memory_order_acquire);
+        if (generation != g_ActiveGeneration)
+            ApplySettings(generation);
+
+        StutterFrame& record = g_History[g_HistoryCount++ % kHistoryCapacity];
+        record.frameIndex = frame.frameIndex;
+        record.timestamp = frame.timestamp;
+        record.frameDuration = frame.previousFrameDuration;
+        record.presentDuration = frame.presentDuration;
+        record.submissions = WorkCounters::GetLastSubmissions();
+        record.drawCalls = WorkCounters::GetLastDrawCalls();
+        record.resized = g_ResizePending.exchange(false, std::memory_order_relaxed);
+
+        // The first present has no duration, and a resize legitimately stalls a frame or two
+        const StutterEvent* event = nullptr;
+        uint64_t duration = frame.previousFrameDuration;
+        if (duration && !record.resized) {
+            // Half a window is enough for a stable median after startup or a settings change
+            if (g_WindowCount >= g_Active.WindowFrames / 2) {
+                uint64_t median = Median();
+                uint64_t mad = MedianAbsoluteDeviation(median);
+
+                bool stutter = duration > g_Active.Threshold * median;
+                if (g_Active.MadThreshold > 0.0)
+                    stutter = stutter && duration > median + g_Active.MadThreshold * mad;
+
+                if (stutter) {
+                    uint32_t count = (uint32_t)std::min<uint64_t>(g_HistoryCount, g_Active.HistoryFrames);
+                    t_EventHistory.resize(count);
+                    for (uint32_t i = 0; i < count; i++)
+                        t_EventHistory[i] = g_History[(g_HistoryCount - count + i) % kHistoryCapacity];
+
+                    t_Event.api = frame.api;
+                    t_Event.frameIndex = frame.frameIndex;
+                    t_Event.frameMilliseconds = duration / 1000000.0;
+                    t_Event.medianMilliseconds = median / 1000000.0;
+                    t_Event.madMilliseconds = mad / 1000000.0;
+                    t_Event.history = t_EventHistory.data();
+                    t_Event.historyCount = count;
+
+                    event = &t_Event;
+                    g_Stutters.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            AddToWindow(duration);
+        }
+
+        g_Busy.store(false, std::memory_order_release);
+        return event;
+    }
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "FrameJacker.h"
+#include <atomic>
+
+namespace FrameJacker {
+
+    // Moving median/MAD of frame time over a short window plus a ring of recent frame records, fed
+    // once per present from the post-present phase. Only one presenting thread updates it at a time;
+    // a concurrent present on another swap chain skips the frame instead of waiting.
+    class StutterDetector {
+    public:
+        static constexpr uint32_t kMaxWindowFrames = 256;
+        static constexpr uint32_t kHistoryCapacity = 1024;
+
+        static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+        static void Configure(const StutterSettings& settings);
+
+        // Records the frame and returns the event to deliver if it stuttered, or null. The event and
+        // its history belong to the calling thread and stay valid until its next call.
+        static const StutterEvent* Update(const FrameEvent& frame);
+
+        static void NoteResize();
+        static uint64_t GetStutterCount();
+
+    private:
+        inline static std::atomic<bool> s_Enabled = false;
+    };
+
+}
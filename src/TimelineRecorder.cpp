@@ -0,0 +1,233 @@
+#include "TimelineRecorder.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace FrameJacker {
+
+    struct TimelineBuffer {
+        TimelineEvent events[TimelineRecorder::kThreadEvents];
+        alignas(64) std::atomic<uint32_t> head = 0;     // Written by the owning thread
+        alignas(64) std::atomic<uint32_t> tail = 0;     // Written by the exporter
+        uint32_t threadId = 0;
+    };
+
+    static thread_local TimelineBuffer* t_Buffer = nullptr;
+
+    // Buffers live until the process exits, the thread owning one may come back at any time
+    static std::mutex g_BuffersMutex;
+    static std::vector<std::unique_ptr<TimelineBuffer>> g_Buffers;
+    static std::atomic<uint64_t> g_Dropped = 0;
+
+    static std::mutex g_ExportMutex;                    // One consumer at a time
+    static FILE* g_Stream = nullptr;
+    static bool g_StreamHasEvents = false;
+    static std::atomic<bool> g_StopStreaming = false;
+    static std::atomic<bool> g_StreamingRunning = false;
+
+    static uint32_t CurrentThreadId() {
+#ifdef _WIN32
+        return (uint32_t)::GetCurrentThreadId();
+#else
+        static std::atomic<uint32_t> next = 1;
+        return next.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    static uint32_t CurrentProcessId() {
+#ifdef _WIN32
+        return (uint32_t)::GetCurrentProcessId();
+#else
+        return (uint32_t)::getpid();
+#endif
+    }
+
+    static TimelineBuffer* AcquireBuffer() {
+        if (t_Buffer)
+            return t_Buffer;
+
+        auto buffer = std::make_unique<TimelineBuffer>();
+        buffer->threadId = CurrentThreadId();
+
+        std::lock_guard<std::mutex> lock(g_BuffersMutex);
+        g_Buffers.push_back(std::move(buffer));
+        t_Buffer = g_Buffers.back().get();
+        return t_Buffer;
+    }
+
+    void TimelineRecorder::SetEnabled(bool enabled) {
+        s_Enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void TimelineRecorder::Push(const TimelineEvent& event) {
+        TimelineBuffer* buffer = AcquireBuffer();
+        uint32_t head = buffer->head.load(std::memory_order_relaxed);
+        if (head - buffer->tail.load(std::memory_order_acquire) >= kThreadEvents) {
+            g_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer->events[head % kThreadEvents] = event;
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    void TimelineRecorder::Complete(const char* name, uint64_t start, uint64_t end,
+        const char* argName0, uint64_t arg0, const char* argName1, uint64_t arg1) {
+        if (!IsEnabled())
+            return;
+
+        Push({ name, start, end > start ? end - start : 0, { argName0, argName1 }, { arg0, arg1 }, false });
+    }
+
+    void TimelineRecorder::Instant(const char* name,
+        const char* argName0, uint64_t arg0, const char* argName1, uint64_t arg1) {
+        if (!IsEnabled())
+            return;
+
+        Push({ name, Clock::Now(), 0, { argName0, argName1 }, { arg0, arg1 }, true });
+    }
+
+    // User zone names can hold anything, quote them as JSON strings
+    static void WriteString(FILE* file, const char* text) {
+        fputc('"', file);
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\')
+                fprintf(file, "\\%c", *c);
+            else if ((unsigned char)*c < 0x20)
+                fprintf(file, "\\u%04x", (unsigned)(unsigned char)*c);
+            else
+                fputc(*c, file);
+        }
+        fputc('"', file);
+    }
+
+    static void WriteEvent(FILE* file, const TimelineEvent& event, uint32_t processId, uint32_t threadId) {
+        fprintf(file, "{\"name\":");
+        WriteString(file, event.name);
+        fprintf(file, ",\"cat\":\"FrameJacker\",\"ph\":\"%s\",\"ts\":%.3f,", event.instant ? "i" : "X", event.start / 1000.0);
+        if (event.instant)
+            fprintf(file, "\"s\":\"t\",");
+        else
+            fprintf(file, "\"dur\":%.3f,", event.duration / 1000.0);
+        fprintf(file, "\"pid\":%u,\"tid\":%u", processId, threadId);
+
+        if (event.argNames[0]) {
+            fprintf(file, ",\"args\":{");
+            WriteString(file, event.argNames[0]);
+            fprintf(file, ":%llu", (unsigned long long)event.args[0]);
+            if (event.argNames[1]) {
+                fputc(',', file);
+                WriteString(file, event.argNames[1]);
+                fprintf(file, ":%llu", (unsigned long long)event.args[1]);
+            }
+            fprintf(file, "}");
+        }
+        fprintf(file, "}");
+    }
+
+    // Writes every pending event, comma separated, and consumes it. Caller holds g_ExportMutex.
+    static void Drain(FILE* file, bool& hasEvents) {
+        std::vector<TimelineBuffer*> buffers;
+        {
+            std::lock_guard<std::mutex> lock(g_BuffersMutex);
+            for (const auto& buffer : g_Buffers)
+                buffers.push_back(buffer.get());
+        }
+
+        uint32_t processId = CurrentProcessId();
+        for (TimelineBuffer* buffer : buffers) {
+            uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+            uint32_t head = buffer->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++) {
+                if (hasEvents)
+                    fprintf(file, ",\n");
+                WriteEvent(file, buffer->events[tail % TimelineRecorder::kThreadEvents], processId, buffer->threadId);
+                hasEvents = true;
+            }
+            buffer->tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    bool TimelineRecorder::Export(const char* path) {
+        std::lock_guard<std::mutex> lock(g_ExportMutex);
+
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            DEBUG_LOG("Failed to open timeline file %s", path);
+            return false;
+        }
+
+        bool hasEvents = false;
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        Drain(file, hasEvents);
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        return true;
+    }
+
+    static void StreamingMain() {
+        while (!g_StopStreaming.load(std::memory_order_acquire)) {
+            {
+                std::lock_guard<std::mutex> lock(g_ExportMutex);
+                Drain(g_Stream, g_StreamHasEvents);
+                fflush(g_Stream);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        std::lock_guard<std::mutex> lock(g_ExportMutex);
+        Drain(g_Stream, g_StreamHasEvents);
+        fprintf(g_Stream, "\n]\n");
+        fclose(g_Stream);
+        g_Stream = nullptr;
+        g_StreamingRunning.store(false, std::memory_order_release);
+    }
+
+    bool TimelineRecorder::StartStreaming(const char* path) {
+        StopStreaming();
+
+        // The streaming thread clears the flag under the export mutex once its file is closed. One
+        // that outlived StopStreaming's wait, or a concurrent start, still owns g_Stream.
+        std::lock_guard<std::mutex> lock(g_ExportMutex);
+        if (g_StreamingRunning.load(std::memory_order_acquire)) {
+            DEBUG_LOG("Timeline is still streaming, not starting another stream");
+            return false;
+        }
+
+        g_Stream = fopen(path, "w");
+        if (!g_Stream) {
+            DEBUG_LOG("Failed to open timeline file %s", path);
+            return false;
+        }
+
+        // The JSON array form of the format tolerates a missing closing bracket, so a stream cut
+        // short by a crash still loads
+        fprintf(g_Stream, "[\n");
+        g_StreamHasEvents = false;
+        g_StopStreaming.store(false, std::memory_order_relaxed);
+        g_StreamingRunning.store(true, std::memory_order_relaxed);
+        std::thread(StreamingMain).detach();
+        return true;
+    }
+
+    void TimelineRecorder::StopStreaming() {
+        if (!g_StreamingRunning.load(std::memory_order_acquire))
+            return;
+
+        // May run under the loader lock, so wait (bounded) instead of joining
+        g_StopStreaming.store(true, std::memory_order_release);
+        for (int i = 0; i < 2000 && g_StreamingRunning.load(std::memory_order_acquire); i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    uint64_t TimelineRecorder::GetDroppedEvents() {
+        return g_Dropped.load(std::memory_order_relaxed);
+    }
+
+}
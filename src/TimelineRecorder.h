@@ -0,0 +1,65 @@
+#pragma once
+#include "FrameJacker.h"
+#include "Clock.h"
+#include <atomic>
+
+namespace FrameJacker {
+
+    // Events exported in Chrome trace-event format. Names must be string literals, they are stored
+    // by pointer.
+    struct TimelineEvent {
+        const char* name;
+        uint64_t start;             // Clock nanoseconds
+        uint64_t duration;          // 0 for instant events
+        const char* argNames[2];
+        uint64_t args[2];
+        bool instant;
+    };
+
+    // Per-thread single-producer rings, drained by Export or the streaming thread. Recording costs
+    // a relaxed load while disabled and never locks or waits while enabled; a full ring drops.
+    class TimelineRecorder {
+    public:
+        static constexpr uint32_t kThreadEvents = 4096;
+
+        static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+        static void SetEnabled(bool enabled);
+
+        static void Complete(const char* name, uint64_t start, uint64_t end,
+            const char* argName0 = nullptr, uint64_t arg0 = 0, const char* argName1 = nullptr, uint64_t arg1 = 0);
+        static void Instant(const char* name,
+            const char* argName0 = nullptr, uint64_t arg0 = 0, const char* argName1 = nullptr, uint64_t arg1 = 0);
+
+        static bool Export(const char* path);
+        static bool StartStreaming(const char* path);
+        static void StopStreaming();
+        static uint64_t GetDroppedEvents();
+
+    private:
+        static void Push(const TimelineEvent& event);
+
+        inline static std::atomic<bool> s_Enabled = false;
+    };
+
+    // Times the enclosing block as a complete event when the timeline is enabled
+    class TimelineScope {
+    public:
+        TimelineScope(const char* name, const char* argName = nullptr, uint64_t arg = 0)
+            : m_Name(name), m_ArgName(argName), m_Arg(arg), m_Start(TimelineRecorder::IsEnabled() ? Clock::Now() : 0) {}
+
+        ~TimelineScope() {
+            if (m_Start)
+                TimelineRecorder::Complete(m_Name, m_Start, Clock::Now(), m_ArgName, m_Arg);
+        }
+
+        TimelineScope(const TimelineScope&) = delete;
+        TimelineScope& operator=(const TimelineScope&) = delete;
+
+    private:
+        const char* m_Name;
+        const char* m_ArgName;
+        uint64_t m_Arg;
+        uint64_t m_Start;
+    };
+
+}
@@ -0,0 +1,82 @@
+#include "FrameJacker/TraceFile.h"
+#include "BlockCompression.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace FrameJacker {
+
+    static const char* ApiName(uint8_t api) {
+        static const char* const names[] = { "Auto", "D3D9", "D3D10", "D3D11", "D3D12", "OpenGL", "Vulkan" };
+        return api < sizeof(names) / sizeof(names[0]) ? names[api] : "Unknown";
+    }
+
+    bool ReadTraceFile(const char* path, TraceFileHeader& header, std::vector<TraceRecordEx>& records) {
+        std::unique_ptr<FILE, int(*)(FILE*)> file(fopen(path, "rb"), fclose);
+        if (!file)
+            return false;
+
+        if (fread(&header, sizeof(header), 1, file.get()) != 1
+            || memcmp(header.magic, kTraceMagic, sizeof(header.magic)) != 0
+            || header.version != kTraceVersion || header.recordSize != sizeof(TraceRecord))
+            return false;
+
+        std::vector<uint8_t> stored;
+        std::vector<TraceRecord> block;
+        TraceBlockHeader blockHeader;
+
+        while (fread(&blockHeader, sizeof(blockHeader), 1, file.get()) == 1) {
+            size_t size = (size_t)blockHeader.recordCount * sizeof(TraceRecord);
+            stored.resize(blockHeader.storedSize);
+            block.resize(blockHeader.recordCount);
+
+            if (fread(stored.data(), 1, stored.size(), file.get()) != stored.size())
+                break;
+
+            if (blockHeader.flags & TraceBlockCompressed) {
+                if (!BlockCompression::Decompress(stored.data(), stored.size(), block.data(), size))
+                    break;
+            }
+            else {
+                if (stored.size() != size)
+                    break;
+                memcpy(block.data(), stored.data(), size);
+            }
+
+            for (const TraceRecord& record : block) {
+                TraceRecordEx entry;
+                static_cast<TraceRecord&>(entry) = record;
+                entry.threadId = blockHeader.threadId;
+                records.push_back(entry);
+            }
+        }
+
+        std::stable_sort(records.begin(), records.end(),
+            [](const TraceRecordEx& a, const TraceRecordEx& b) { return a.frameIndex < b.frameIndex; });
+        return true;
+    }
+
+    bool ConvertTraceToCsv(const char* tracePath, const char* csvPath) {
+        TraceFileHeader header;
+        std::vector<TraceRecordEx> records;
+        if (!ReadTraceFile(tracePath, header, records))
+            return false;
+
+        std::unique_ptr<FILE, int(*)(FILE*)> csv(fopen(csvPath, "w"), fclose);
+        if (!csv)
+            return false;
+
+        fprintf(csv.get(), "FrameIndex,API,ThreadId,TimeInSeconds,MsBetweenPresents,MsInPresentAPI,SyncInterval,PresentFlags,Width,Height\n");
+        for (const TraceRecordEx& record : records) {
+            double time = record.timestamp >= header.startTimestamp ? (record.timestamp - header.startTimestamp) / 1e9 : 0.0;
+            fprintf(csv.get(), "%llu,%s,%u,%.6f,%.4f,%.4f,%u,%u,%u,%u\n",
+                (unsigned long long)record.frameIndex, ApiName(record.api), record.threadId, time,
+                record.frameDuration / 1e6, record.presentDuration / 1e6,
+                record.syncInterval, record.flags, record.width, record.height);
+        }
+
+        return true;
+    }
+
+}
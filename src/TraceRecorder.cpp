@@ -0,0 +1,243 @@
+#include "TraceRecorder.h"
+#include "BlockCompression.h"
+#include "Clock.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FrameJacker {
+
+    // Owned by the presenting thread until it marks the block full, then by the flush thread
+    // until it clears the flag again
+    struct TraceBlock {
+        TraceRecord records[TraceRecorder::kBlockRecords];
+        uint32_t count = 0;
+        std::atomic<bool> full = false;
+    };
+
+    struct TraceThreadBuffer {
+        TraceBlock blocks[2];
+        uint32_t active = 0;
+        uint32_t threadId = 0;
+    };
+
+    struct TraceThreadCache {
+        TraceThreadBuffer* buffer = nullptr;
+        uint32_t session = 0;
+    };
+
+    static thread_local TraceThreadCache t_Cache;
+
+    static std::mutex g_Mutex;                  // Start/Stop and the buffer list
+    static std::vector<std::unique_ptr<TraceThreadBuffer>> g_Buffers;
+    static std::atomic<bool> g_Recording = false;
+    static std::atomic<uint32_t> g_ActiveWriters = 0;
+    static std::atomic<uint32_t> g_Session = 0;
+    static std::atomic<uint64_t> g_Dropped = 0;
+    static std::atomic<bool> g_StopFlusher = false;
+    static std::atomic<bool> g_FlusherRunning = false;
+    static std::atomic<bool> g_WritersDrained = false;
+    static FILE* g_File = nullptr;
+
+    static uint32_t CurrentThreadId() {
+#ifdef _WIN32
+        return (uint32_t)::GetCurrentThreadId();
+#else
+        static std::atomic<uint32_t> next = 1;
+        return next.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    static TraceThreadBuffer* AcquireThreadBuffer() {
+        uint32_t session = g_Session.load(std::memory_order_relaxed);
+        if (t_Cache.session == session)
+            return t_Cache.buffer;
+
+        // First frame of this thread in this session
+        auto buffer = std::make_unique<TraceThreadBuffer>();
+        buffer->threadId = CurrentThreadId();
+
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_Buffers.push_back(std::move(buffer));
+        t_Cache.buffer = g_Buffers.back().get();
+        t_Cache.session = session;
+        return t_Cache.buffer;
+    }
+
+    static void WriteBlock(TraceThreadBuffer& buffer, TraceBlock& block, std::vector<uint8_t>& scratch) {
+        if (!block.count)
+            return;
+
+        size_t size = block.count * sizeof(TraceRecord);
+        scratch.resize(BlockCompression::GetBound(size));
+        size_t compressed = BlockCompression::Compress(block.records, size, scratch.data(), scratch.size());
+
+        TraceBlockHeader header = {};
+        header.storedSize = (uint32_t)(compressed ? compressed : size);
+        header.recordCount = block.count;
+        header.threadId = buffer.threadId;
+        header.flags = compressed ? (uint32_t)TraceBlockCompressed : 0u;
+
+        fwrite(&header, sizeof(header), 1, g_File);
+        fwrite(compressed ? (const void*)scratch.data() : (const void*)block.records, header.storedSize, 1, g_File);
+        block.count = 0;
+    }
+
+    static void FlushFullBlocks(std::vector<uint8_t>& scratch) {
+        std::vector<TraceThreadBuffer*> buffers;
+        {
+            std::lock_guard<std::mutex> lock(g_Mutex);
+            for (const auto& buffer : g_Buffers)
+                buffers.push_back(buffer.get());
+        }
+
+        bool wrote = false;
+        for (TraceThreadBuffer* buffer : buffers) {
+            for (TraceBlock& block : buffer->blocks) {
+                if (!block.full.load(std::memory_order_acquire))
+                    continue;
+
+                WriteBlock(*buffer, block, scratch);
+                block.full.store(false, std::memory_order_release);
+                wrote = true;
+            }
+        }
+
+        if (wrote)
+            fflush(g_File);
+    }
+
+    static void FlusherMain() {
+        std::vector<uint8_t> scratch;
+
+        while (!g_StopFlusher.load(std::memory_order_acquire)) {
+            FlushFullBlocks(scratch);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+
+        // Once Stop has drained the writers, partially filled blocks can be written too. Older
+        // records first: the full block, if any, is the inactive one.
+        FlushFullBlocks(scratch);
+        if (g_WritersDrained.load(std::memory_order_acquire)) {
+            for (const auto& buffer : g_Buffers)
+                WriteBlock(*buffer, buffer->blocks[buffer->active], scratch);
+        }
+        else {
+            DEBUG_LOG("Trace writers did not drain, partial blocks not written");
+        }
+
+        fclose(g_File);
+        g_File = nullptr;
+        g_FlusherRunning.store(false, std::memory_order_release);
+    }
+
+    bool TraceRecorder::Start(const char* path) {
+        Stop();
+
+        std::lock_guard<std::mutex> lock(g_Mutex);
+
+        // A stuck writer or flusher from the previous session still uses g_Buffers and g_File
+        if (g_FlusherRunning.load(std::memory_order_acquire) || g_ActiveWriters.load()) {
+            DEBUG_LOG("Previous trace still being written, not starting %s", path);
+            return false;
+        }
+
+        g_File = fopen(path, "wb");
+        if (!g_File) {
+            DEBUG_LOG("Failed to open trace file %s", path);
+            return false;
+        }
+
+        TraceFileHeader header = {};
+        memcpy(header.magic, kTraceMagic, sizeof(header.magic));
+        header.version = kTraceVersion;
+        header.recordSize = sizeof(TraceRecord);
+        header.startTimestamp = Clock::Now();
+        fwrite(&header, sizeof(header), 1, g_File);
+
+        g_Buffers.clear();
+        g_Dropped.store(0, std::memory_order_relaxed);
+        g_Session.fetch_add(1, std::memory_order_relaxed);
+        g_StopFlusher.store(false, std::memory_order_relaxed);
+        g_FlusherRunning.store(true, std::memory_order_relaxed);
+        std::thread(FlusherMain).detach();
+
+        g_Recording.store(true, std::memory_order_release);
+        DEBUG_LOG("Trace recording started: %s", path);
+        return true;
+    }
+
+    void TraceRecorder::Stop() {
+        if (!g_Recording.exchange(false))
+            return;
+
+        // Like AsyncDispatcher::Stop, this may run under the loader lock, so only wait (bounded)
+        // instead of joining
+        for (int i = 0; i < 1000 && g_ActiveWriters.load(); i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        g_WritersDrained.store(g_ActiveWriters.load() == 0, std::memory_order_release);
+        g_StopFlusher.store(true, std::memory_order_release);
+        for (int i = 0; i < 5000 && g_FlusherRunning.load(std::memory_order_acquire); i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        DEBUG_LOG("Trace recording stopped (%llu records dropped)", (unsigned long long)g_Dropped.load(std::memory_order_relaxed));
+    }
+
+    bool TraceRecorder::IsRecording() {
+        return g_Recording.load(std::memory_order_relaxed);
+    }
+
+    uint64_t TraceRecorder::GetDroppedRecords() {
+        return g_Dropped.load(std::memory_order_relaxed);
+    }
+
+    void TraceRecorder::Record(const FrameEvent& frame, uint32_t width, uint32_t height) {
+        if (!g_Recording.load(std::memory_order_relaxed))
+            return;
+
+        // Sequentially consistent, pairs with the exchange in Stop
+        g_ActiveWriters.fetch_add(1);
+        if (g_Recording.load()) {
+            TraceThreadBuffer& buffer = *AcquireThreadBuffer();
+            TraceBlock* block = &buffer.blocks[buffer.active];
+
+            if (block->full.load(std::memory_order_acquire)) {
+                TraceBlock* other = &buffer.blocks[buffer.active ^ 1];
+                if (!other->full.load(std::memory_order_acquire)) {
+                    buffer.active ^= 1;
+                    block = other;
+                }
+                else {
+                    block = nullptr;   // The flush thread is behind, drop rather than wait
+                }
+            }
+
+            if (block) {
+                TraceRecord& record = block->records[block->count];
+                record.frameIndex = frame.frameIndex;
+                record.timestamp = frame.timestamp;
+                record.frameDuration = frame.previousFrameDuration;
+                record.presentDuration = frame.presentDuration;
+                record.width = width;
+                record.height = height;
+                record.api = (uint8_t)frame.api;
+                record.syncInterval = (uint8_t)frame.syncInterval;
+                record.flags = (uint16_t)frame.flags;
+                record.reserved = 0;
+
+                if (++block->count == kBlockRecords)
+                    block->full.store(true, std::memory_order_release);
+            }
+            else {
+                g_Dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        g_ActiveWriters.fetch_sub(1, std::memory_order_release);
+    }
+
+}
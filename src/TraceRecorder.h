@@ -0,0 +1,22 @@
+#pragma once
+#include "FrameJacker.h"
+#include "FrameJacker/TraceFile.h"
+
+namespace FrameJacker {
+
+    // Streams one TraceRecord per present to disk. Each presenting thread appends to its own pair
+    // of blocks; a background thread compresses and writes full blocks, so the present path never
+    // does I/O, locks or allocates (after the thread's first frame).
+    class TraceRecorder {
+    public:
+        static constexpr uint32_t kBlockRecords = 1024;
+
+        static bool Start(const char* path);
+        static void Stop();
+        static bool IsRecording();
+        static uint64_t GetDroppedRecords();
+
+        static void Record(const FrameEvent& frame, uint32_t width, uint32_t height);
+    };
+
+}
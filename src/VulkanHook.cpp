@@ -1,4 +1,11 @@
 #include "FrameJacker.h"
+#include "CallbackRegistry.h"
+#include "OverlayLayer.h"
+#include "VulkanOverlay.h"
+#include "VulkanProbe.h"
+#include "VulkanQueues.h"
+#include "VulkanSwapchainOverride.h"
+#include "WorkCounters.h"
 #include <DetourMacros.hpp>
 #include <MemoryManager.h>
 #if FRAMEJACKER_INCLUDE_VULKAN
@@ -8,12 +15,7 @@
 using namespace ByteWeaver;
 
 namespace FrameJacker {
-    typedef VkResult(VKAPI_PTR* PFN_vkCreateInstance_Custom)(const VkInstanceCreateInfo*, const VkAllocationCallbacks*, VkInstance*);
     typedef void (VKAPI_PTR* PFN_vkDestroyInstance_Custom)(VkInstance, const VkAllocationCallbacks*);
-    typedef VkResult(VKAPI_PTR* PFN_vkEnumeratePhysicalDevices_Custom)(VkInstance, uint32_t*, VkPhysicalDevice*);
-    typedef VkResult(VKAPI_PTR* PFN_vkCreateDevice_Custom)(VkPhysicalDevice, const VkDeviceCreateInfo*, const VkAllocationCallbacks*, VkDevice*);
-    typedef void (VKAPI_PTR* PFN_vkDestroyDevice_Custom)(VkDevice, const VkAllocationCallbacks*);
-    typedef PFN_vkVoidFunction(VKAPI_PTR* PFN_vkGetDeviceProcAddr_Custom)(VkDevice, const char*);
 
     DECLARE_HOOK(vkQueuePresentKHR, VkResult, __stdcall, __stdcall,
         VkQueue queue, const VkPresentInfoKHR* pPresentInfo);
@@ -26,13 +28,43 @@ namespace FrameJacker {
         VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo,
         const VkAllocationCallbacks* pAllocator, VkSwapchainKHR* pSwapchain);
 
+    // Maps the game's devices to their physical device for the overlay's memory types and the
+    // swapchain policy
+    DECLARE_HOOK(vkCreateDevice, VkResult, __stdcall, __stdcall,
+        VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* pCreateInfo,
+        const VkAllocationCallbacks* pAllocator, VkDevice* pDevice);
+
+    // Queue families, for submission statistics and the overlay's composite queue
+    DECLARE_HOOK(vkGetDeviceQueue, void, __stdcall, __stdcall,
+        VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue* pQueue);
+
+    DECLARE_HOOK(vkGetDeviceQueue2, void, __stdcall, __stdcall,
+        VkDevice device, const VkDeviceQueueInfo2* pQueueInfo, VkQueue* pQueue);
+
+    // Drop cached surface capabilities and device records, the handles get reused
+    DECLARE_HOOK(vkDestroySurfaceKHR, void, __stdcall, __stdcall,
+        VkInstance instance, VkSurfaceKHR surface, const VkAllocationCallbacks* pAllocator);
+
+    DECLARE_HOOK(vkDestroyDevice, void, __stdcall, __stdcall,
+        VkDevice device, const VkAllocationCallbacks* pAllocator);
+
+    // The retained overlay holds views of the swapchain images
+    DECLARE_HOOK(vkDestroySwapchainKHR, void, __stdcall, __stdcall,
+        VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks* pAllocator);
+
+    // Submission statistics, installed on demand
+    DECLARE_HOOK(vkQueueSubmit, VkResult, __stdcall, __stdcall,
+        VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence);
+
+    DECLARE_HOOK(vkQueueSubmit2, VkResult, __stdcall, __stdcall,
+        VkQueue queue, uint32_t submitCount, const VkSubmitInfo2* pSubmits, VkFence fence);
+
     static uint150_t* g_MethodsTable = nullptr;
-    static VkDevice g_FakeDevice = VK_NULL_HANDLE;
     static VkDevice g_Device = VK_NULL_HANDLE;
     static VkInstance g_Instance = VK_NULL_HANDLE;
-    static VkPhysicalDevice g_PhysicalDevice = VK_NULL_HANDLE;
     static VkSwapchainKHR g_CurrentSwapchain = VK_NULL_HANDLE;
     static uint32_t g_CurrentImageIndex = 0;
+    static bool g_SubmitHooksInstalled = false;
 
     static VkResult __stdcall vkAcquireNextImageKHRHook(
         VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout,
@@ -54,112 +86,200 @@ namespace FrameJacker {
         VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo,
         const VkAllocationCallbacks* pAllocator, VkSwapchainKHR* pSwapchain) {
 
-        if (Hook::s_Callbacks.OnResize)
-            Hook::s_Callbacks.OnResize();
+        TimelineScope timeline("vkCreateSwapchainKHR", "minImageCount", pCreateInfo->minImageCount);
+
+        // The new swapchain doesn't exist yet, so the immediate event carries the one being replaced
+        CallbackScope callbacks;
+        ResizeEvent resize = { API::Vulkan, pCreateInfo->imageExtent.width, pCreateInfo->imageExtent.height,
+            (uint32_t)pCreateInfo->imageFormat, (void*)pCreateInfo->oldSwapchain };
+        callbacks.OnResize(resize);
+
+        VkSwapchainCreateInfoKHR rewritten;
+        bool overridden = VulkanSwapchainOverride::Apply(device, *pCreateInfo, rewritten);
+        VkResult result = vkCreateSwapchainKHROriginal(device, overridden ? &rewritten : pCreateInfo, pAllocator, pSwapchain);
+
+        // Fall back to what the game asked for. The failed call already retired oldSwapchain.
+        if (overridden && result != VK_SUCCESS) {
+            DEBUG_LOG("vkCreateSwapchainKHR failed with the policy applied (%d), retrying as requested", (int)result);
+            VulkanSwapchainOverride::ForgetSurface(pCreateInfo->surface);
+            VkSwapchainCreateInfoKHR original = *pCreateInfo;
+            original.oldSwapchain = VK_NULL_HANDLE;
+            result = vkCreateSwapchainKHROriginal(device, &original, pAllocator, pSwapchain);
+        }
+
+        if (result == VK_SUCCESS) {
+            FrameTracker::SetSurfaceSize((void*)*pSwapchain, pCreateInfo->imageExtent.width, pCreateInfo->imageExtent.height);
+            // The policy never changes the format, size or usage the overlay needs
+            VulkanOverlay::NoteSwapchain(device, *pSwapchain, *pCreateInfo);
+        }
+
+        if (result == VK_SUCCESS && callbacks.IsCoalescingResize()) {
+            resize.swapChain = (void*)*pSwapchain;
+            callbacks.DeferResize(resize);
+        }
 
-        return vkCreateSwapchainKHROriginal(device, pCreateInfo, pAllocator, pSwapchain);
+        return result;
     }
 
-    static VkResult __stdcall vkQueuePresentKHRHook(VkQueue queue, const VkPresentInfoKHR* pPresentInfo) {
-        if (Hook::s_Callbacks.OnPresent)
-            Hook::s_Callbacks.OnPresent();
+    static VkResult __stdcall vkCreateDeviceHook(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* pCreateInfo,
+        const VkAllocationCallbacks* pAllocator, VkDevice* pDevice) {
 
-        if (Hook::s_Callbacks.OnRender && g_Device) {
-            RenderContext ctx = {};
-            ctx.api = API::Vulkan;
-            ctx.device = g_Device;
-            ctx.commandBuffer = nullptr; 
-            ctx.swapChain = (void*)g_CurrentSwapchain;
-            ctx.imageIndex = g_CurrentImageIndex;
-            ctx.extra = (void*)queue; 
-            Hook::s_Callbacks.OnRender(ctx);
-        }
+        VkResult result = vkCreateDeviceOriginal(physicalDevice, pCreateInfo, pAllocator, pDevice);
+        if (result == VK_SUCCESS)
+            VulkanQueues::NoteDevice(*pDevice, physicalDevice);
+        return result;
+    }
 
-        return vkQueuePresentKHROriginal(queue, pPresentInfo);
+    static void __stdcall vkDestroySurfaceKHRHook(VkInstance instance, VkSurfaceKHR surface, const VkAllocationCallbacks* pAllocator) {
+        VulkanSwapchainOverride::ForgetSurface(surface);
+        vkDestroySurfaceKHROriginal(instance, surface, pAllocator);
     }
 
-    void VulkanHook::InitializeMethodTable() {
-        DEBUG_LOG("Vulkan InitMethodTable starting...");
+    static void __stdcall vkDestroySwapchainKHRHook(VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks* pAllocator) {
+        VulkanOverlay::ForgetSwapchain(swapchain);
+        vkDestroySwapchainKHROriginal(device, swapchain, pAllocator);
+    }
 
-        VkInstanceCreateInfo instanceInfo = {};
-        instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    static void __stdcall vkDestroyDeviceHook(VkDevice device, const VkAllocationCallbacks* pAllocator) {
+        VulkanOverlay::ForgetDevice(device);
+        VulkanQueues::ForgetDevice(device);
+        if (g_Device == device)
+            g_Device = VK_NULL_HANDLE;
+        vkDestroyDeviceOriginal(device, pAllocator);
+    }
 
-        HMODULE libVulkan = ::GetModuleHandleW(L"vulkan-1.dll");
-        if (!libVulkan) {
-            DEBUG_LOG("vulkan-1.dll not found");
-            return;
-        }
+    static void __stdcall vkGetDeviceQueueHook(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue* pQueue) {
+        vkGetDeviceQueueOriginal(device, queueFamilyIndex, queueIndex, pQueue);
+        VulkanQueues::NoteQueue(device, *pQueue, queueFamilyIndex);
+    }
 
-        auto vkCreateInstance = (PFN_vkCreateInstance_Custom)::GetProcAddress(libVulkan, "vkCreateInstance");
-        auto vkDestroyInstance = (PFN_vkDestroyInstance_Custom)::GetProcAddress(libVulkan, "vkDestroyInstance");
-        auto vkEnumeratePhysicalDevices = (PFN_vkEnumeratePhysicalDevices_Custom)::GetProcAddress(libVulkan, "vkEnumeratePhysicalDevices");
-        auto vkCreateDevice = (PFN_vkCreateDevice_Custom)::GetProcAddress(libVulkan, "vkCreateDevice");
-        auto vkDestroyDevice = (PFN_vkDestroyDevice_Custom)::GetProcAddress(libVulkan, "vkDestroyDevice");
-        auto vkGetDeviceProcAddr = (PFN_vkGetDeviceProcAddr_Custom)::GetProcAddress(libVulkan, "vkGetDeviceProcAddr");
+    static void __stdcall vkGetDeviceQueue2Hook(VkDevice device, const VkDeviceQueueInfo2* pQueueInfo, VkQueue* pQueue) {
+        vkGetDeviceQueue2Original(device, pQueueInfo, pQueue);
+        VulkanQueues::NoteQueue(device, *pQueue, pQueueInfo->queueFamilyIndex);
+    }
 
-        if (vkCreateInstance(&instanceInfo, nullptr, &g_Instance) != VK_SUCCESS) {
-            DEBUG_LOG("vkCreateInstance failed");
-            return;
-        }
+    static VkResult __stdcall vkQueueSubmitHook(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence) {
+        if (!WorkCounters::IsSubmissionsEnabled() || WorkCounters::IsInternalWork())
+            return vkQueueSubmitOriginal(queue, submitCount, pSubmits, fence);
 
-        uint32_t deviceCount = 0;
-        vkEnumeratePhysicalDevices(g_Instance, &deviceCount, nullptr);
-        if (deviceCount == 0) {
-            DEBUG_LOG("No Vulkan devices found");
-            vkDestroyInstance(g_Instance, nullptr);
-            return;
-        }
+        SubmissionCounts counts = VulkanQueues::CountSubmits(submitCount, pSubmits);
+        uint64_t start = Clock::Now();
+        VkResult result = vkQueueSubmitOriginal(queue, submitCount, pSubmits, fence);
+        counts.nanoseconds = Clock::Now() - start;
+
+        VulkanQueues::RecordSubmission(queue, counts);
+        return result;
+    }
 
+    static VkResult __stdcall vkQueueSubmit2Hook(VkQueue queue, uint32_t submitCount, const VkSubmitInfo2* pSubmits, VkFence fence) {
+        if (!WorkCounters::IsSubmissionsEnabled() || WorkCounters::IsInternalWork())
+            return vkQueueSubmit2Original(queue, submitCount, pSubmits, fence);
 
+        SubmissionCounts counts = VulkanQueues::CountSubmits(submitCount, pSubmits);
+        uint64_t start = Clock::Now();
+        VkResult result = vkQueueSubmit2Original(queue, submitCount, pSubmits, fence);
+        counts.nanoseconds = Clock::Now() - start;
 
+        VulkanQueues::RecordSubmission(queue, counts);
+        return result;
+    }
 
-        VkPhysicalDevice devices[8];
-        vkEnumeratePhysicalDevices(g_Instance, &deviceCount, devices);
-        g_PhysicalDevice = devices[0];
+    // Patched from the presenting thread once submission statistics are first enabled, and left in
+    // place until Uninstall. vkQueueSubmit2 is only there on devices that support Vulkan 1.3 or
+    // VK_KHR_synchronization2.
+    static void InstallSubmitHooks() {
+        DEBUG_LOG("Installing Vulkan submission statistics hooks...");
+        INSTALL_HOOK_ADDRESS(vkQueueSubmit, g_MethodsTable[3]);
+        MemoryManager::ApplyMod("vkQueueSubmit");
+
+        if (g_MethodsTable[4]) {
+            INSTALL_HOOK_ADDRESS(vkQueueSubmit2, g_MethodsTable[4]);
+            MemoryManager::ApplyMod("vkQueueSubmit2");
+        }
 
-        uint32_t queueFamily = 0;
-        float queuePriority = 1.0f;
+        g_SubmitHooksInstalled = true;
+    }
 
-        VkDeviceQueueCreateInfo queueInfo = {};
-        queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queueInfo.queueFamilyIndex = queueFamily;
-        queueInfo.queueCount = 1;
-        queueInfo.pQueuePriorities = &queuePriority;
+    static VkResult __stdcall vkQueuePresentKHRHook(VkQueue queue, const VkPresentInfoKHR* pPresentInfo) {
+        CallbackScope callbacks;
+        VkSwapchainKHR swapchain = pPresentInfo && pPresentInfo->swapchainCount ? pPresentInfo->pSwapchains[0] : g_CurrentSwapchain;
+        callbacks.BeginFrame(API::Vulkan, (void*)swapchain, 0, 0, (void*)queue);
 
-        const char* swapchainExt = "VK_KHR_swapchain";
-        VkDeviceCreateInfo deviceInfo = {};
-        deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        deviceInfo.queueCreateInfoCount = 1;
-        deviceInfo.pQueueCreateInfos = &queueInfo;
-        deviceInfo.enabledExtensionCount = 1;
-        deviceInfo.ppEnabledExtensionNames = &swapchainExt;
+        callbacks.OnPresent();
 
-        if (vkCreateDevice(g_PhysicalDevice, &deviceInfo, nullptr, &g_FakeDevice) != VK_SUCCESS) {
-            DEBUG_LOG("vkCreateDevice failed");
-            vkDestroyInstance(g_Instance, nullptr);
-            return;
+        // The retained overlay's composite waits on the game's semaphores, the present on the composite
+        VkPresentInfoKHR composited;
+        const VkPresentInfoKHR* presentInfo = pPresentInfo;
+
+        if (callbacks.HasRender() && g_Device) {
+            RenderContext ctx = {};
+            ctx.api = API::Vulkan;
+            ctx.device = g_Device;
+            ctx.commandBuffer = nullptr; 
+            ctx.swapChain = (void*)g_CurrentSwapchain;
+            ctx.imageIndex = g_CurrentImageIndex;
+            ctx.extra = (void*)queue; 
+
+            InternalWorkScope internal;
+            if (OverlayLayer::IsEnabled() && pPresentInfo) {
+                composited = *pPresentInfo;
+                if (VulkanOverlay::Render(callbacks, ctx, queue, composited))
+                    presentInfo = &composited;
+            }
+            if (presentInfo == pPresentInfo)
+                callbacks.OnRender(ctx);
         }
 
-        void* acquireNextImageAddr = vkGetDeviceProcAddr(g_FakeDevice, "vkAcquireNextImageKHR");
-        void* queuePresentAddr = vkGetDeviceProcAddr(g_FakeDevice, "vkQueuePresentKHR");
-        void* createSwapchainAddr = vkGetDeviceProcAddr(g_FakeDevice, "vkCreateSwapchainKHR");
+        callbacks.BeginOriginalPresent();
+        VkResult result = vkQueuePresentKHROriginal(queue, presentInfo);
 
-        if (!acquireNextImageAddr || !queuePresentAddr || !createSwapchainAddr) {
-            DEBUG_LOG("Failed to get Vulkan function pointers");
-            vkDestroyDevice(g_FakeDevice, nullptr);
-            vkDestroyInstance(g_Instance, nullptr);
+        callbacks.OnPostPresent();
+
+        if (!g_SubmitHooksInstalled && WorkCounters::IsSubmissionsEnabled() && g_MethodsTable && g_MethodsTable[3])
+            InstallSubmitHooks();
+
+        return result;
+    }
+
+    void VulkanHook::InitializeMethodTable() {
+        DEBUG_LOG("Vulkan InitMethodTable starting...");
+
+        HMODULE libVulkan = ::GetModuleHandleW(L"vulkan-1.dll");
+        if (!libVulkan) {
+            DEBUG_LOG("vulkan-1.dll not found");
             return;
         }
 
-        g_MethodsTable = (uint150_t*)::calloc(3, sizeof(uint150_t));
-        g_MethodsTable[0] = (uint150_t)acquireNextImageAddr;
-        g_MethodsTable[1] = (uint150_t)queuePresentAddr;
-        g_MethodsTable[2] = (uint150_t)createSwapchainAddr;
-
-        DEBUG_LOG("Vulkan function pointers obtained");
+        auto vkGetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)::GetProcAddress(libVulkan, "vkGetInstanceProcAddr");
+        VulkanEntryPoints entryPoints;
+        if (!vkGetInstanceProcAddr || !VulkanProbe::Resolve(vkGetInstanceProcAddr, g_Instance, entryPoints))
+            return;
 
-        vkDestroyDevice(g_FakeDevice, nullptr);
-        g_FakeDevice = VK_NULL_HANDLE;
+        DEBUG_LOG("Vulkan device probed for %u.%u%s", VK_API_VERSION_MAJOR(entryPoints.apiVersion),
+            VK_API_VERSION_MINOR(entryPoints.apiVersion), entryPoints.synchronization2 ? " with VK_KHR_synchronization2" : "");
+
+        g_MethodsTable = (uint150_t*)::calloc(11, sizeof(uint150_t));
+        g_MethodsTable[0] = (uint150_t)entryPoints.acquireNextImage;
+        g_MethodsTable[1] = (uint150_t)entryPoints.queuePresent;
+        g_MethodsTable[2] = (uint150_t)entryPoints.createSwapchain;
+        g_MethodsTable[3] = (uint150_t)entryPoints.queueSubmit;
+        g_MethodsTable[4] = (uint150_t)entryPoints.queueSubmit2;
+        g_MethodsTable[5] = (uint150_t)::GetProcAddress(libVulkan, "vkCreateDevice");
+        g_MethodsTable[6] = (uint150_t)entryPoints.getDeviceQueue;
+        g_MethodsTable[7] = (uint150_t)entryPoints.getDeviceQueue2;
+        g_MethodsTable[8] = (uint150_t)entryPoints.destroyDevice;
+        g_MethodsTable[9] = (uint150_t)::GetProcAddress(libVulkan, "vkDestroySurfaceKHR");
+        g_MethodsTable[10] = (uint150_t)entryPoints.destroySwapchain;
+
+        // Loader trampolines, which work with the game's physical devices as well as ours
+        VulkanSwapchainOverride::Initialize(
+            (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)::GetProcAddress(libVulkan, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR"),
+            (PFN_vkGetPhysicalDeviceSurfacePresentModesKHR)::GetProcAddress(libVulkan, "vkGetPhysicalDeviceSurfacePresentModesKHR"));
+        VulkanQueues::Initialize(
+            (PFN_vkGetPhysicalDeviceQueueFamilyProperties)::GetProcAddress(libVulkan, "vkGetPhysicalDeviceQueueFamilyProperties"));
+        VulkanOverlay::Initialize(
+            (PFN_vkGetDeviceProcAddr)::GetProcAddress(libVulkan, "vkGetDeviceProcAddr"),
+            (PFN_vkGetPhysicalDeviceMemoryProperties)::GetProcAddress(libVulkan, "vkGetPhysicalDeviceMemoryProperties"));
 
         DEBUG_LOG("Vulkan method table initialized");
     }
@@ -181,10 +301,37 @@ namespace FrameJacker {
         INSTALL_HOOK_ADDRESS(vkAcquireNextImageKHR, g_MethodsTable[0]);
         INSTALL_HOOK_ADDRESS(vkQueuePresentKHR, g_MethodsTable[1]);
         INSTALL_HOOK_ADDRESS(vkCreateSwapchainKHR, g_MethodsTable[2]);
+        INSTALL_HOOK_ADDRESS(vkCreateDevice, g_MethodsTable[5]);
 
         MemoryManager::ApplyMod("vkAcquireNextImageKHR");
         MemoryManager::ApplyMod("vkQueuePresentKHR");
         MemoryManager::ApplyMod("vkCreateSwapchainKHR");
+        MemoryManager::ApplyMod("vkCreateDevice");
+
+        if (g_MethodsTable[6]) {
+            INSTALL_HOOK_ADDRESS(vkGetDeviceQueue, g_MethodsTable[6]);
+            MemoryManager::ApplyMod("vkGetDeviceQueue");
+        }
+
+        if (g_MethodsTable[7]) {
+            INSTALL_HOOK_ADDRESS(vkGetDeviceQueue2, g_MethodsTable[7]);
+            MemoryManager::ApplyMod("vkGetDeviceQueue2");
+        }
+
+        if (g_MethodsTable[8]) {
+            INSTALL_HOOK_ADDRESS(vkDestroyDevice, g_MethodsTable[8]);
+            MemoryManager::ApplyMod("vkDestroyDevice");
+        }
+
+        if (g_MethodsTable[9]) {
+            INSTALL_HOOK_ADDRESS(vkDestroySurfaceKHR, g_MethodsTable[9]);
+            MemoryManager::ApplyMod("vkDestroySurfaceKHR");
+        }
+
+        if (g_MethodsTable[10]) {
+            INSTALL_HOOK_ADDRESS(vkDestroySwapchainKHR, g_MethodsTable[10]);
+            MemoryManager::ApplyMod("vkDestroySwapchainKHR");
+        }
 
         DEBUG_LOG("Vulkan installation complete");
         return 0;
@@ -209,6 +356,28 @@ namespace FrameJacker {
         MemoryManager::RestoreAndEraseMod("vkAcquireNextImageKHR");
         MemoryManager::RestoreAndEraseMod("vkQueuePresentKHR");
         MemoryManager::RestoreAndEraseMod("vkCreateSwapchainKHR");
+        MemoryManager::RestoreAndEraseMod("vkCreateDevice");
+        if (g_MethodsTable && g_MethodsTable[6])
+            MemoryManager::RestoreAndEraseMod("vkGetDeviceQueue");
+        if (g_MethodsTable && g_MethodsTable[7])
+            MemoryManager::RestoreAndEraseMod("vkGetDeviceQueue2");
+        if (g_MethodsTable && g_MethodsTable[8])
+            MemoryManager::RestoreAndEraseMod("vkDestroyDevice");
+        if (g_MethodsTable && g_MethodsTable[9])
+            MemoryManager::RestoreAndEraseMod("vkDestroySurfaceKHR");
+        if (g_MethodsTable && g_MethodsTable[10])
+            MemoryManager::RestoreAndEraseMod("vkDestroySwapchainKHR");
+        VulkanOverlay::Shutdown();
+        VulkanSwapchainOverride::Shutdown();
+        VulkanQueues::Shutdown();
+
+        if (g_SubmitHooksInstalled) {
+            MemoryManager::RestoreAndEraseMod("vkQueueSubmit");
+            if (g_MethodsTable && g_MethodsTable[4])
+                MemoryManager::RestoreAndEraseMod("vkQueueSubmit2");
+            g_SubmitHooksInstalled = false;
+        }
+
         HMODULE libVulkan = ::GetModuleHandleW(L"vulkan-1.dll");
         auto vkDestroyInstance = (PFN_vkDestroyInstance_Custom)::GetProcAddress(libVulkan, "vkDestroyInstance");
         if (g_Instance) {
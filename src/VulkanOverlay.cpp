@@ -0,0 +1,773 @@
+#include "VulkanOverlay.h"
+#include "OverlayLayer.h"
+#include "VulkanQueues.h"
+#include <mutex>
+#include <vector>
+
+namespace FrameJacker {
+
+    // The fullscreen triangle of the D3D overlays, as SPIR-V assembled from the equivalent of
+    //   vertex:   uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    //             gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+    //   fragment: layout(set = 0, binding = 0) uniform sampler2D overlay;
+    //             color = texture(overlay, uv);
+    static const uint32_t g_VertexCode[] = {
+        0x07230203, 0x00010000, 0x00000000, 0x00000021, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+        0x00000000, 0x00000001, 0x0008000f, 0x00000000, 0x00000013, 0x6e69616d, 0x00000000, 0x00000010,
+        0x00000011, 0x00000012, 0x00040047, 0x00000010, 0x0000000b, 0x0000002a, 0x00040047, 0x00000012,
+        0x0000000b, 0x00000000, 0x00040047, 0x00000011, 0x0000001e, 0x00000000, 0x00020013, 0x00000001,
+        0x00030021, 0x00000002, 0x00000001, 0x00040015, 0x00000003, 0x00000020, 0x00000001, 0x00030016,
+        0x00000004, 0x00000020, 0x00040017, 0x00000005, 0x00000004, 0x00000002, 0x00040017, 0x00000006,
+        0x00000004, 0x00000004, 0x00040020, 0x00000007, 0x00000001, 0x00000003, 0x00040020, 0x00000008,
+        0x00000003, 0x00000005, 0x00040020, 0x00000009, 0x00000003, 0x00000006, 0x0004002b, 0x00000003,
+        0x0000000a, 0x00000001, 0x0004002b, 0x00000003, 0x0000000b, 0x00000002, 0x0004002b, 0x00000004,
+        0x0000000c, 0x00000000, 0x0004002b, 0x00000004, 0x0000000d, 0x3f800000, 0x0004002b, 0x00000004,
+        0x0000000e, 0x40000000, 0x0005002c, 0x00000005, 0x0000000f, 0x0000000d, 0x0000000d, 0x0004003b,
+        0x00000007, 0x00000010, 0x00000001, 0x0004003b, 0x00000008, 0x00000011, 0x00000003, 0x0004003b,
+        0x00000009, 0x00000012, 0x00000003, 0x00050036, 0x00000001, 0x00000013, 0x00000000, 0x00000002,
+        0x000200f8, 0x00000014, 0x0004003d, 0x00000003, 0x00000015, 0x00000010, 0x000500c4, 0x00000003,
+        0x00000016, 0x00000015, 0x0000000a, 0x000500c7, 0x00000003, 0x00000017, 0x00000016, 0x0000000b,
+        0x000500c7, 0x00000003, 0x00000018, 0x00000015, 0x0000000b, 0x0004006f, 0x00000004, 0x00000019,
+        0x00000017, 0x0004006f, 0x00000004, 0x0000001a, 0x00000018, 0x00050050, 0x00000005, 0x0000001b,
+        0x00000019, 0x0000001a, 0x0003003e, 0x00000011, 0x0000001b, 0x0005008e, 0x00000005, 0x0000001c,
+        0x0000001b, 0x0000000e, 0x00050083, 0x00000005, 0x0000001d, 0x0000001c, 0x0000000f, 0x00050051,
+        0x00000004, 0x0000001e, 0x0000001d, 0x00000000, 0x00050051, 0x00000004, 0x0000001f, 0x0000001d,
+        0x00000001, 0x00070050, 0x00000006, 0x00000020, 0x0000001e, 0x0000001f, 0x0000000c, 0x0000000d,
+        0x0003003e, 0x00000012, 0x00000020, 0x000100fd, 0x00010038,
+    };
+
+    static const uint32_t g_FragmentCode[] = {
+        0x07230203, 0x00010000, 0x00000000, 0x00000013, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+        0x00000000, 0x00000001, 0x0007000f, 0x00000004, 0x0000000e, 0x6e69616d, 0x00000000, 0x0000000c,
+        0x0000000d, 0x00030010, 0x0000000e, 0x00000007, 0x00040047, 0x0000000c, 0x0000001e, 0x00000000,
+        0x00040047, 0x0000000d, 0x0000001e, 0x00000000, 0x00040047, 0x0000000b, 0x00000022, 0x00000000,
+        0x00040047, 0x0000000b, 0x00000021, 0x00000000, 0x00020013, 0x00000001, 0x00030021, 0x00000002,
+        0x00000001, 0x00030016, 0x00000003, 0x00000020, 0x00040017, 0x00000004, 0x00000003, 0x00000002,
+        0x00040017, 0x00000005, 0x00000003, 0x00000004, 0x00090019, 0x00000006, 0x00000003, 0x00000001,
+        0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000000, 0x0003001b, 0x00000007, 0x00000006,
+        0x00040020, 0x00000008, 0x00000000, 0x00000007, 0x00040020, 0x00000009, 0x00000001, 0x00000004,
+        0x00040020, 0x0000000a, 0x00000003, 0x00000005, 0x0004003b, 0x00000008, 0x0000000b, 0x00000000,
+        0x0004003b, 0x00000009, 0x0000000c, 0x00000001, 0x0004003b, 0x0000000a, 0x0000000d, 0x00000003,
+        0x00050036, 0x00000001, 0x0000000e, 0x00000000, 0x00000002, 0x000200f8, 0x0000000f, 0x0004003d,
+        0x00000007, 0x00000010, 0x0000000b, 0x0004003d, 0x00000004, 0x00000011, 0x0000000c, 0x00050057,
+        0x00000005, 0x00000012, 0x00000010, 0x00000011, 0x0003003e, 0x0000000d, 0x00000012, 0x000100fd,
+        0x00010038,
+    };
+
+    static constexpr uint64_t kFenceTimeoutNanoseconds = 1000000000;
+    static constexpr VkFormat kLayerFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+#define FRAMEJACKER_VULKAN_OVERLAY_FUNCTIONS(X) \
+    X(vkGetSwapchainImagesKHR) X(vkCreateImage) X(vkDestroyImage) X(vkGetImageMemoryRequirements) \
+    X(vkAllocateMemory) X(vkFreeMemory) X(vkBindImageMemory) X(vkCreateImageView) X(vkDestroyImageView) \
+    X(vkCreateRenderPass) X(vkDestroyRenderPass) X(vkCreateFramebuffer) X(vkDestroyFramebuffer) \
+    X(vkCreateShaderModule) X(vkDestroyShaderModule) X(vkCreateSampler) X(vkDestroySampler) \
+    X(vkCreateDescriptorSetLayout) X(vkDestroyDescriptorSetLayout) X(vkCreatePipelineLayout) \
+    X(vkDestroyPipelineLayout) X(vkCreateGraphicsPipelines) X(vkDestroyPipeline) X(vkCreateDescriptorPool) \
+    X(vkDestroyDescriptorPool) X(vkAllocateDescriptorSets) X(vkUpdateDescriptorSets) X(vkCreateCommandPool) \
+    X(vkDestroyCommandPool) X(vkAllocateCommandBuffers) X(vkResetCommandBuffer) X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) X(vkCreateFence) X(vkDestroyFence) X(vkWaitForFences) X(vkResetFences) \
+    X(vkCreateSemaphore) X(vkDestroySemaphore) X(vkCmdBeginRenderPass) X(vkCmdEndRenderPass) \
+    X(vkCmdBindPipeline) X(vkCmdBindDescriptorSets) X(vkCmdSetViewport) X(vkCmdSetScissor) X(vkCmdDraw) \
+    X(vkQueueSubmit)
+
+    struct VulkanOverlayFunctions {
+#define X(name) PFN_##name name = nullptr;
+        FRAMEJACKER_VULKAN_OVERLAY_FUNCTIONS(X)
+#undef X
+    };
+
+    // One per swapchain image, so recording the next frame never resets a command buffer the GPU still reads
+    struct VulkanFrame {
+        VkImageView view = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        VkSemaphore composited = VK_NULL_HANDLE;      // Signalled by the composite, waited on by the present
+        bool submitted = false;
+    };
+
+    struct VulkanLayer {
+        // From the swapchain's create info
+        VkDevice device = VK_NULL_HANDLE;
+        VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent = {};
+        bool supported = false;                       // The images can be rendered to
+        bool failed = false;                          // Creation failed, not retried until the pipeline is rebuilt
+
+        // Built on the first present, on the overlay device
+        uint32_t queueFamily = VK_QUEUE_FAMILY_IGNORED;
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkRenderPass layerPass = VK_NULL_HANDLE;      // Handed to OnRender as RenderContext::renderTarget
+        VkFramebuffer layerFramebuffer = VK_NULL_HANDLE;
+        VkRenderPass compositePass = VK_NULL_HANDLE;  // Loads the presented image, built for its format
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        std::vector<VulkanFrame> frames;
+        OverlayLayerState state;
+    };
+
+    static PFN_vkGetDeviceProcAddr g_GetDeviceProcAddr = nullptr;
+    static PFN_vkGetPhysicalDeviceMemoryProperties g_GetMemoryProperties = nullptr;
+
+    // Swapchains are created, presented and destroyed on whichever threads the game likes
+    static std::mutex g_Mutex;
+    static std::vector<VulkanLayer> g_Layers;
+
+    // Shared by every layer, built for one device at a time like the D3D12 overlay
+    static VkDevice g_OverlayDevice = VK_NULL_HANDLE;
+    static VulkanOverlayFunctions g_Vk;
+    static VkShaderModule g_VertexShader = VK_NULL_HANDLE;
+    static VkShaderModule g_FragmentShader = VK_NULL_HANDLE;
+    static VkSampler g_Sampler = VK_NULL_HANDLE;
+    static VkDescriptorSetLayout g_SetLayout = VK_NULL_HANDLE;
+    static VkPipelineLayout g_PipelineLayout = VK_NULL_HANDLE;
+    static bool g_PipelineFailed = false;
+    static std::vector<VkPipelineStageFlags> g_WaitStages;
+
+    template<typename Handle, typename Destroy>
+    static void SafeDestroy(Destroy destroy, Handle& handle) {
+        if (handle) {
+            destroy(g_OverlayDevice, handle, nullptr);
+            handle = VK_NULL_HANDLE;
+        }
+    }
+
+    static VulkanLayer* Find(VkSwapchainKHR swapchain) {
+        for (auto& layer : g_Layers) {
+            if (layer.swapchain == swapchain)
+                return &layer;
+        }
+        return nullptr;
+    }
+
+    // Leaves what the create info said, so the layer can be built again
+    static void ReleaseLayer(VulkanLayer& layer) {
+        // Only layers on the overlay device are ever built
+        if (layer.device != g_OverlayDevice)
+            return;
+
+        std::vector<VkFence> pending;
+        for (auto& frame : layer.frames) {
+            if (frame.submitted)
+                pending.push_back(frame.fence);
+        }
+        if (!pending.empty() && g_Vk.vkWaitForFences(g_OverlayDevice, (uint32_t)pending.size(), pending.data(),
+                VK_TRUE, kFenceTimeoutNanoseconds) != VK_SUCCESS)
+            DEBUG_LOG("Vulkan overlay timed out waiting for the GPU");
+
+        for (auto& frame : layer.frames) {
+            SafeDestroy(g_Vk.vkDestroyFramebuffer, frame.framebuffer);
+            SafeDestroy(g_Vk.vkDestroyImageView, frame.view);
+            SafeDestroy(g_Vk.vkDestroyFence, frame.fence);
+            SafeDestroy(g_Vk.vkDestroySemaphore, frame.composited);
+        }
+        layer.frames.clear();
+
+        // Frees the command buffers and the descriptor set with them
+        SafeDestroy(g_Vk.vkDestroyCommandPool, layer.commandPool);
+        SafeDestroy(g_Vk.vkDestroyDescriptorPool, layer.descriptorPool);
+        layer.descriptorSet = VK_NULL_HANDLE;
+        SafeDestroy(g_Vk.vkDestroyPipeline, layer.pipeline);
+        SafeDestroy(g_Vk.vkDestroyRenderPass, layer.compositePass);
+        SafeDestroy(g_Vk.vkDestroyFramebuffer, layer.layerFramebuffer);
+        SafeDestroy(g_Vk.vkDestroyRenderPass, layer.layerPass);
+        SafeDestroy(g_Vk.vkDestroyImageView, layer.imageView);
+        SafeDestroy(g_Vk.vkDestroyImage, layer.image);
+        SafeDestroy(g_Vk.vkFreeMemory, layer.memory);
+        layer.queueFamily = VK_QUEUE_FAMILY_IGNORED;
+        layer.state = {};
+    }
+
+    static void ReleasePipeline() {
+        for (auto& layer : g_Layers) {
+            ReleaseLayer(layer);
+            layer.failed = false;
+        }
+
+        if (g_OverlayDevice) {
+            SafeDestroy(g_Vk.vkDestroyPipelineLayout, g_PipelineLayout);
+            SafeDestroy(g_Vk.vkDestroyDescriptorSetLayout, g_SetLayout);
+            SafeDestroy(g_Vk.vkDestroySampler, g_Sampler);
+            SafeDestroy(g_Vk.vkDestroyShaderModule, g_FragmentShader);
+            SafeDestroy(g_Vk.vkDestroyShaderModule, g_VertexShader);
+        }
+
+        g_Vk = {};
+        g_OverlayDevice = VK_NULL_HANDLE;
+        g_PipelineFailed = false;
+    }
+
+    static VkShaderModule CreateShader(const uint32_t* code, size_t size) {
+        VkShaderModuleCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        info.codeSize = size;
+        info.pCode = code;
+
+        VkShaderModule module = VK_NULL_HANDLE;
+        if (g_Vk.vkCreateShaderModule(g_OverlayDevice, &info, nullptr, &module) != VK_SUCCESS)
+            return VK_NULL_HANDLE;
+        return module;
+    }
+
+    // Shaders, the sampler and the pipeline layout are shared by every layer on the device,
+    // render passes and pipelines are per layer since they depend on the swapchain format
+    static bool CreatePipeline(VkDevice device) {
+        if (g_OverlayDevice == device)
+            return !g_PipelineFailed;
+
+        ReleasePipeline();
+        g_OverlayDevice = device;
+        g_PipelineFailed = true;
+
+        if (!g_GetDeviceProcAddr || !g_GetMemoryProperties)
+            return false;
+
+        bool missing = false;
+#define X(name) g_Vk.name = (PFN_##name)g_GetDeviceProcAddr(device, #name); missing |= !g_Vk.name;
+        FRAMEJACKER_VULKAN_OVERLAY_FUNCTIONS(X)
+#undef X
+        if (missing) {
+            DEBUG_LOG("Vulkan device functions missing, overlay falls back to immediate rendering");
+            return false;
+        }
+
+        g_VertexShader = CreateShader(g_VertexCode, sizeof(g_VertexCode));
+        g_FragmentShader = CreateShader(g_FragmentCode, sizeof(g_FragmentCode));
+
+        VkSamplerCreateInfo samplerInfo = {};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.maxLod = 0.25f;
+
+        if (!g_VertexShader || !g_FragmentShader
+            || g_Vk.vkCreateSampler(device, &samplerInfo, nullptr, &g_Sampler) != VK_SUCCESS) {
+            DEBUG_LOG("Vulkan overlay shader or sampler creation failed");
+            return false;
+        }
+
+        // The sampler is baked into the set layout, like the D3D12 overlay's static sampler
+        VkDescriptorSetLayoutBinding binding = {};
+        binding.binding = 0;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        binding.descriptorCount = 1;
+        binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        binding.pImmutableSamplers = &g_Sampler;
+
+        VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+        setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutInfo.bindingCount = 1;
+        setLayoutInfo.pBindings = &binding;
+
+        VkPipelineLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutInfo.setLayoutCount = 1;
+        layoutInfo.pSetLayouts = &g_SetLayout;
+
+        if (g_Vk.vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &g_SetLayout) != VK_SUCCESS
+            || g_Vk.vkCreatePipelineLayout(device, &layoutInfo, nullptr, &g_PipelineLayout) != VK_SUCCESS) {
+            DEBUG_LOG("Vulkan overlay pipeline layout creation failed");
+            return false;
+        }
+
+        DEBUG_LOG("Vulkan overlay pipeline created");
+        g_PipelineFailed = false;
+        return true;
+    }
+
+    static VkRenderPass CreateRenderPass(VkFormat format, bool composite) {
+        VkAttachmentDescription attachment = {};
+        attachment.format = format;
+        attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+        VkSubpassDependency dependencies[2] = {};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        if (composite) {
+            // Blends over whatever the game presents, which is already in the present layout. The
+            // present's semaphores are waited on at the color output stage; games that present
+            // without one rendered on this queue before.
+            attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachment.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            dependencies[0].srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        }
+        else {
+            // Redrawn from scratch, then sampled by the composite. The previous composite may still
+            // be reading it.
+            attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        }
+
+        VkAttachmentReference reference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &reference;
+
+        VkRenderPassCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        info.attachmentCount = 1;
+        info.pAttachments = &attachment;
+        info.subpassCount = 1;
+        info.pSubpasses = &subpass;
+        info.dependencyCount = 2;
+        info.pDependencies = dependencies;
+
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        if (g_Vk.vkCreateRenderPass(g_OverlayDevice, &info, nullptr, &renderPass) != VK_SUCCESS)
+            return VK_NULL_HANDLE;
+        return renderPass;
+    }
+
+    static VkPipeline CreatePipelineState(VkRenderPass renderPass) {
+        VkPipelineShaderStageCreateInfo stages[2] = {};
+        stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        stages[0].module = g_VertexShader;
+        stages[0].pName = "main";
+        stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[1].module = g_FragmentShader;
+        stages[1].pName = "main";
+
+        VkPipelineVertexInputStateCreateInfo vertexInput = {};
+        vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        VkPipelineViewportStateCreateInfo viewport = {};
+        viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewport.viewportCount = 1;
+        viewport.scissorCount = 1;
+
+        VkPipelineRasterizationStateCreateInfo rasterization = {};
+        rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterization.cullMode = VK_CULL_MODE_NONE;
+        rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        rasterization.lineWidth = 1.0f;
+
+        VkPipelineMultisampleStateCreateInfo multisample = {};
+        multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        // Same premultiplied blend as the D3D overlays
+        VkPipelineColorBlendAttachmentState blend = {};
+        blend.blendEnable = VK_TRUE;
+        blend.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blend.colorBlendOp = VK_BLEND_OP_ADD;
+        blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blend.alphaBlendOp = VK_BLEND_OP_ADD;
+        blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+        VkPipelineColorBlendStateCreateInfo colorBlend = {};
+        colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlend.attachmentCount = 1;
+        colorBlend.pAttachments = &blend;
+
+        VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        VkPipelineDynamicStateCreateInfo dynamic = {};
+        dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamic.dynamicStateCount = 2;
+        dynamic.pDynamicStates = dynamicStates;
+
+        VkGraphicsPipelineCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        info.stageCount = 2;
+        info.pStages = stages;
+        info.pVertexInputState = &vertexInput;
+        info.pInputAssemblyState = &inputAssembly;
+        info.pViewportState = &viewport;
+        info.pRasterizationState = &rasterization;
+        info.pMultisampleState = &multisample;
+        info.pColorBlendState = &colorBlend;
+        info.pDynamicState = &dynamic;
+        info.layout = g_PipelineLayout;
+        info.renderPass = renderPass;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        if (g_Vk.vkCreateGraphicsPipelines(g_OverlayDevice, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline) != VK_SUCCESS)
+            return VK_NULL_HANDLE;
+        return pipeline;
+    }
+
+    static VkImageView CreateView(VkImage image, VkFormat format) {
+        VkImageViewCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        info.image = image;
+        info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        info.format = format;
+        info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        VkImageView view = VK_NULL_HANDLE;
+        if (g_Vk.vkCreateImageView(g_OverlayDevice, &info, nullptr, &view) != VK_SUCCESS)
+            return VK_NULL_HANDLE;
+        return view;
+    }
+
+    static VkFramebuffer CreateFramebuffer(VkRenderPass renderPass, VkImageView view, VkExtent2D extent) {
+        VkFramebufferCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        info.renderPass = renderPass;
+        info.attachmentCount = 1;
+        info.pAttachments = &view;
+        info.width = extent.width;
+        info.height = extent.height;
+        info.layers = 1;
+
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        if (g_Vk.vkCreateFramebuffer(g_OverlayDevice, &info, nullptr, &framebuffer) != VK_SUCCESS)
+            return VK_NULL_HANDLE;
+        return framebuffer;
+    }
+
+    static bool AllocateLayerImage(VulkanLayer& layer, VkPhysicalDevice physicalDevice) {
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = kLayerFormat;
+        imageInfo.extent = { layer.extent.width, layer.extent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (g_Vk.vkCreateImage(g_OverlayDevice, &imageInfo, nullptr, &layer.image) != VK_SUCCESS)
+            return false;
+
+        VkMemoryRequirements requirements;
+        g_Vk.vkGetImageMemoryRequirements(g_OverlayDevice, layer.image, &requirements);
+        VkPhysicalDeviceMemoryProperties properties;
+        g_GetMemoryProperties(physicalDevice, &properties);
+
+        uint32_t memoryType = properties.memoryTypeCount;
+        for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+            if ((requirements.memoryTypeBits & (1u << i))
+                && (properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+                memoryType = i;
+                break;
+            }
+        }
+        if (memoryType == properties.memoryTypeCount)
+            return false;
+
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = memoryType;
+
+        return g_Vk.vkAllocateMemory(g_OverlayDevice, &allocateInfo, nullptr, &layer.memory) == VK_SUCCESS
+            && g_Vk.vkBindImageMemory(g_OverlayDevice, layer.image, layer.memory, 0) == VK_SUCCESS;
+    }
+
+    static bool CreateLayer(VulkanLayer& layer, uint32_t queueFamily) {
+        // Memory types come from the physical device, which is only known for devices created after the hooks
+        VkPhysicalDevice physicalDevice = VulkanQueues::GetPhysicalDevice(layer.device);
+        if (!physicalDevice)
+            return false;
+
+        uint32_t imageCount = 0;
+        if (g_Vk.vkGetSwapchainImagesKHR(g_OverlayDevice, layer.swapchain, &imageCount, nullptr) != VK_SUCCESS || !imageCount)
+            return false;
+        std::vector<VkImage> images(imageCount);
+        if (g_Vk.vkGetSwapchainImagesKHR(g_OverlayDevice, layer.swapchain, &imageCount, images.data()) != VK_SUCCESS)
+            return false;
+
+        layer.queueFamily = queueFamily;
+        if (!AllocateLayerImage(layer, physicalDevice))
+            return false;
+
+        layer.imageView = CreateView(layer.image, kLayerFormat);
+        layer.layerPass = CreateRenderPass(kLayerFormat, false);
+        layer.compositePass = CreateRenderPass(layer.format, true);
+        if (!layer.imageView || !layer.layerPass || !layer.compositePass)
+            return false;
+
+        layer.layerFramebuffer = CreateFramebuffer(layer.layerPass, layer.imageView, layer.extent);
+        layer.pipeline = CreatePipelineState(layer.compositePass);
+        if (!layer.layerFramebuffer || !layer.pipeline)
+            return false;
+
+        VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 };
+        VkDescriptorPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+
+        VkDescriptorSetAllocateInfo setInfo = {};
+        setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        setInfo.descriptorSetCount = 1;
+        setInfo.pSetLayouts = &g_SetLayout;
+
+        VkCommandPoolCreateInfo commandPoolInfo = {};
+        commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        commandPoolInfo.queueFamilyIndex = queueFamily;
+
+        if (g_Vk.vkCreateDescriptorPool(g_OverlayDevice, &poolInfo, nullptr, &layer.descriptorPool) != VK_SUCCESS)
+            return false;
+        setInfo.descriptorPool = layer.descriptorPool;
+        if (g_Vk.vkAllocateDescriptorSets(g_OverlayDevice, &setInfo, &layer.descriptorSet) != VK_SUCCESS
+            || g_Vk.vkCreateCommandPool(g_OverlayDevice, &commandPoolInfo, nullptr, &layer.commandPool) != VK_SUCCESS)
+            return false;
+
+        VkDescriptorImageInfo imageDescriptor = { VK_NULL_HANDLE, layer.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = layer.descriptorSet;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &imageDescriptor;
+        g_Vk.vkUpdateDescriptorSets(g_OverlayDevice, 1, &write, 0, nullptr);
+
+        std::vector<VkCommandBuffer> commandBuffers(imageCount);
+        VkCommandBufferAllocateInfo commandBufferInfo = {};
+        commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferInfo.commandPool = layer.commandPool;
+        commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferInfo.commandBufferCount = imageCount;
+        if (g_Vk.vkAllocateCommandBuffers(g_OverlayDevice, &commandBufferInfo, commandBuffers.data()) != VK_SUCCESS)
+            return false;
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        layer.frames.resize(imageCount);
+        for (uint32_t i = 0; i < imageCount; i++) {
+            VulkanFrame& frame = layer.frames[i];
+            frame.commandBuffer = commandBuffers[i];
+            frame.view = CreateView(images[i], layer.format);
+            if (!frame.view
+                || g_Vk.vkCreateFence(g_OverlayDevice, &fenceInfo, nullptr, &frame.fence) != VK_SUCCESS
+                || g_Vk.vkCreateSemaphore(g_OverlayDevice, &semaphoreInfo, nullptr, &frame.composited) != VK_SUCCESS)
+                return false;
+
+            frame.framebuffer = CreateFramebuffer(layer.compositePass, frame.view, layer.extent);
+            if (!frame.framebuffer)
+                return false;
+        }
+
+        return true;
+    }
+
+    static void SetViewport(VkCommandBuffer commandBuffer, VkExtent2D extent) {
+        VkViewport viewport = { 0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f };
+        VkRect2D scissor = { { 0, 0 }, extent };
+        g_Vk.vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        g_Vk.vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+
+    static void Redraw(const CallbackScope& callbacks, RenderContext& ctx, VulkanLayer& layer, VkCommandBuffer commandBuffer) {
+        VkClearValue transparent = {};
+        VkRenderPassBeginInfo begin = {};
+        begin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        begin.renderPass = layer.layerPass;
+        begin.framebuffer = layer.layerFramebuffer;
+        begin.renderArea = { { 0, 0 }, layer.extent };
+        begin.clearValueCount = 1;
+        begin.pClearValues = &transparent;
+
+        g_Vk.vkCmdBeginRenderPass(commandBuffer, &begin, VK_SUBPASS_CONTENTS_INLINE);
+        SetViewport(commandBuffer, layer.extent);
+
+        ctx.commandBuffer = (void*)commandBuffer;
+        ctx.renderTarget = (void*)layer.layerPass;
+        callbacks.OnRender(ctx);
+
+        g_Vk.vkCmdEndRenderPass(commandBuffer);
+    }
+
+    static void Composite(VulkanLayer& layer, VulkanFrame& frame) {
+        VkRenderPassBeginInfo begin = {};
+        begin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        begin.renderPass = layer.compositePass;
+        begin.framebuffer = frame.framebuffer;
+        begin.renderArea = { { 0, 0 }, layer.extent };
+
+        g_Vk.vkCmdBeginRenderPass(frame.commandBuffer, &begin, VK_SUBPASS_CONTENTS_INLINE);
+        g_Vk.vkCmdBindPipeline(frame.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layer.pipeline);
+        g_Vk.vkCmdBindDescriptorSets(frame.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, g_PipelineLayout,
+            0, 1, &layer.descriptorSet, 0, nullptr);
+        SetViewport(frame.commandBuffer, layer.extent);
+        g_Vk.vkCmdDraw(frame.commandBuffer, 3, 1, 0, 0);
+        g_Vk.vkCmdEndRenderPass(frame.commandBuffer);
+    }
+
+    void VulkanOverlay::Initialize(PFN_vkGetDeviceProcAddr getDeviceProcAddr,
+        PFN_vkGetPhysicalDeviceMemoryProperties getMemoryProperties) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_GetDeviceProcAddr = getDeviceProcAddr;
+        g_GetMemoryProperties = getMemoryProperties;
+    }
+
+    void VulkanOverlay::NoteSwapchain(VkDevice device, VkSwapchainKHR swapchain, const VkSwapchainCreateInfoKHR& info) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        VulkanLayer* layer = Find(swapchain);
+        if (!layer) {
+            g_Layers.emplace_back();
+            layer = &g_Layers.back();
+        }
+        else {
+            ReleaseLayer(*layer);
+        }
+
+        layer->device = device;
+        layer->swapchain = swapchain;
+        layer->format = info.imageFormat;
+        layer->extent = info.imageExtent;
+        layer->failed = false;
+        // The composite renders into the presented images
+        layer->supported = (info.imageUsage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) && info.imageArrayLayers == 1;
+    }
+
+    bool VulkanOverlay::Render(const CallbackScope& callbacks, RenderContext& ctx, VkQueue queue, VkPresentInfoKHR& presentInfo) {
+        // One composite per present, games presenting several swapchains at once render immediately
+        if (presentInfo.swapchainCount != 1)
+            return false;
+
+        // The composite is submitted on the presenting queue, so it lands between the game's
+        // rendering and the present
+        uint32_t queueFamily = VulkanQueues::GetFamily(queue);
+        if (queueFamily == VK_QUEUE_FAMILY_IGNORED || !(VulkanQueues::GetType(queue) & VK_QUEUE_GRAPHICS_BIT))
+            return false;
+
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        VulkanLayer* layer = Find(presentInfo.pSwapchains[0]);
+        if (!layer || !layer->supported || layer->failed || !CreatePipeline(layer->device))
+            return false;
+
+        if (layer->commandPool && layer->queueFamily != queueFamily)
+            ReleaseLayer(*layer);
+
+        if (!layer->commandPool && !CreateLayer(*layer, queueFamily)) {
+            DEBUG_LOG("Vulkan overlay layer creation failed (%ux%u)", layer->extent.width, layer->extent.height);
+            ReleaseLayer(*layer);
+            layer->failed = true;
+            return false;
+        }
+
+        uint32_t imageIndex = presentInfo.pImageIndices[0];
+        if (imageIndex >= layer->frames.size())
+            return false;
+
+        VulkanFrame& frame = layer->frames[imageIndex];
+        if (frame.submitted) {
+            if (g_Vk.vkWaitForFences(g_OverlayDevice, 1, &frame.fence, VK_TRUE, kFenceTimeoutNanoseconds) != VK_SUCCESS) {
+                DEBUG_LOG("Vulkan overlay timed out waiting for the GPU");
+                return false;
+            }
+            g_Vk.vkResetFences(g_OverlayDevice, 1, &frame.fence);
+            frame.submitted = false;
+        }
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (g_Vk.vkResetCommandBuffer(frame.commandBuffer, 0) != VK_SUCCESS
+            || g_Vk.vkBeginCommandBuffer(frame.commandBuffer, &beginInfo) != VK_SUCCESS)
+            return false;
+
+        uint64_t now = callbacks.GetFrame().timestamp;
+        ctx.device = (void*)layer->device;
+        ctx.swapChain = (void*)layer->swapchain;
+        ctx.imageIndex = imageIndex;
+        ctx.extra = (void*)queue;
+        if (OverlayLayer::ShouldRedraw(layer->state, now))
+            Redraw(callbacks, ctx, *layer, frame.commandBuffer);
+
+        Composite(*layer, frame);
+
+        // OnRender may already have run, so a failed submit doesn't hand the frame back to the
+        // caller. The game's present goes ahead without the overlay, which is drawn again next time.
+        g_WaitStages.assign(presentInfo.waitSemaphoreCount, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        VkSubmitInfo submit = {};
+        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.waitSemaphoreCount = presentInfo.waitSemaphoreCount;
+        submit.pWaitSemaphores = presentInfo.pWaitSemaphores;
+        submit.pWaitDstStageMask = g_WaitStages.data();
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &frame.commandBuffer;
+        submit.signalSemaphoreCount = 1;
+        submit.pSignalSemaphores = &frame.composited;
+
+        if (g_Vk.vkEndCommandBuffer(frame.commandBuffer) != VK_SUCCESS
+            || g_Vk.vkQueueSubmit(queue, 1, &submit, frame.fence) != VK_SUCCESS) {
+            DEBUG_LOG("Vulkan overlay composite submission failed");
+            layer->state = {};
+            return true;
+        }
+
+        frame.submitted = true;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &frame.composited;
+        return true;
+    }
+
+    void VulkanOverlay::ForgetSwapchain(VkSwapchainKHR swapchain) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        for (auto it = g_Layers.begin(); it != g_Layers.end(); ++it) {
+            if (it->swapchain == swapchain) {
+                ReleaseLayer(*it);
+                g_Layers.erase(it);
+                return;
+            }
+        }
+    }
+
+    void VulkanOverlay::ForgetDevice(VkDevice device) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        if (g_OverlayDevice == device)
+            ReleasePipeline();
+
+        for (auto it = g_Layers.begin(); it != g_Layers.end();) {
+            if (it->device == device)
+                it = g_Layers.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void VulkanOverlay::Shutdown() {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        ReleasePipeline();
+        g_Layers.clear();
+    }
+
+}
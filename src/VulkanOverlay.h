@@ -0,0 +1,34 @@
+#pragma once
+#include "FrameJacker.h"
+#include "CallbackRegistry.h"
+#include "vulkan_core.h"
+
+namespace FrameJacker {
+
+    // Retained overlay target for Vulkan swapchains. The layer image and its render pass live per
+    // swapchain, with a command buffer, fence and semaphore per swapchain image. OnRender records
+    // into that command buffer inside the layer's render pass only when OverlayLayer asks for a
+    // redraw. The layer is blended over the presented image by a submit that waits on the present's
+    // semaphores, and the present waits on that submit instead.
+    class VulkanOverlay {
+    public:
+        // Loader entry points, device functions are resolved per device
+        static void Initialize(PFN_vkGetDeviceProcAddr getDeviceProcAddr,
+            PFN_vkGetPhysicalDeviceMemoryProperties getMemoryProperties);
+
+        // Swapchain creation hooks report every swapchain with the create info it was made from.
+        // Swapchains created before the hooks get no layer.
+        static void NoteSwapchain(VkDevice device, VkSwapchainKHR swapchain, const VkSwapchainCreateInfoKHR& info);
+
+        // Returns false when the layer could not be used, the caller then renders immediately. On
+        // success presentInfo waits on the overlay's semaphore instead of the game's.
+        static bool Render(const CallbackScope& callbacks, RenderContext& ctx, VkQueue queue, VkPresentInfoKHR& presentInfo);
+
+        // Wait for the layer's work on the GPU and release it, before the swapchain or device goes
+        static void ForgetSwapchain(VkSwapchainKHR swapchain);
+        static void ForgetDevice(VkDevice device);
+
+        static void Shutdown();
+    };
+
+}
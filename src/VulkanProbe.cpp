@@ -0,0 +1,129 @@
+#include "VulkanProbe.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace FrameJacker {
+
+    static bool HasExtension(const std::vector<VkExtensionProperties>& extensions, const char* name) {
+        return std::any_of(extensions.begin(), extensions.end(),
+            [name](const VkExtensionProperties& extension) { return strcmp(extension.extensionName, name) == 0; });
+    }
+
+    bool VulkanProbe::Resolve(PFN_vkGetInstanceProcAddr getInstanceProcAddr, VkInstance& instance, VulkanEntryPoints& entryPoints) {
+        entryPoints = {};
+        instance = VK_NULL_HANDLE;
+
+        auto vkCreateInstance = (PFN_vkCreateInstance)getInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance");
+        auto vkEnumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)getInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion");
+        if (!vkCreateInstance)
+            return false;
+
+        uint32_t instanceVersion = VK_API_VERSION_1_0;
+        if (vkEnumerateInstanceVersion)
+            vkEnumerateInstanceVersion(&instanceVersion);
+
+        // Core 1.3 entry points such as vkQueueSubmit2 only resolve on a device created for 1.3
+        VkApplicationInfo applicationInfo = {};
+        applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        applicationInfo.apiVersion = std::min<uint32_t>(VK_MAKE_API_VERSION(0, VK_API_VERSION_MAJOR(instanceVersion),
+            VK_API_VERSION_MINOR(instanceVersion), 0), VK_API_VERSION_1_3);
+
+        VkInstanceCreateInfo instanceInfo = {};
+        instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        instanceInfo.pApplicationInfo = &applicationInfo;
+
+        if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS) {
+            DEBUG_LOG("vkCreateInstance failed");
+            instance = VK_NULL_HANDLE;
+            return false;
+        }
+
+        auto vkDestroyInstance = (PFN_vkDestroyInstance)getInstanceProcAddr(instance, "vkDestroyInstance");
+        auto vkEnumeratePhysicalDevices = (PFN_vkEnumeratePhysicalDevices)getInstanceProcAddr(instance, "vkEnumeratePhysicalDevices");
+        auto vkGetPhysicalDeviceProperties = (PFN_vkGetPhysicalDeviceProperties)getInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties");
+        auto vkEnumerateDeviceExtensionProperties = (PFN_vkEnumerateDeviceExtensionProperties)getInstanceProcAddr(instance, "vkEnumerateDeviceExtensionProperties");
+        auto vkCreateDevice = (PFN_vkCreateDevice)getInstanceProcAddr(instance, "vkCreateDevice");
+        auto vkDestroyDevice = (PFN_vkDestroyDevice)getInstanceProcAddr(instance, "vkDestroyDevice");
+        auto vkGetDeviceProcAddr = (PFN_vkGetDeviceProcAddr)getInstanceProcAddr(instance, "vkGetDeviceProcAddr");
+
+        auto fail = [&](const char* message) {
+            DEBUG_LOG("%s", message);
+            if (vkDestroyInstance)
+                vkDestroyInstance(instance, nullptr);
+            instance = VK_NULL_HANDLE;
+            return false;
+        };
+
+        if (!vkDestroyInstance || !vkEnumeratePhysicalDevices || !vkGetPhysicalDeviceProperties
+            || !vkEnumerateDeviceExtensionProperties || !vkCreateDevice || !vkDestroyDevice || !vkGetDeviceProcAddr)
+            return fail("Vulkan loader is missing instance functions");
+
+        uint32_t deviceCount = 0;
+        vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+        if (deviceCount == 0)
+            return fail("No Vulkan devices found");
+
+        std::vector<VkPhysicalDevice> devices(deviceCount);
+        vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+        VkPhysicalDevice physicalDevice = devices[0];
+
+        // A device only exposes the core entry points of versions both it and the instance support
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        entryPoints.apiVersion = std::min<uint32_t>(applicationInfo.apiVersion,
+            VK_MAKE_API_VERSION(0, VK_API_VERSION_MAJOR(properties.apiVersion), VK_API_VERSION_MINOR(properties.apiVersion), 0));
+
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+        std::vector<const char*> enabled = { "VK_KHR_swapchain" };
+        entryPoints.synchronization2 = entryPoints.apiVersion < VK_API_VERSION_1_3 && HasExtension(extensions, "VK_KHR_synchronization2");
+        if (entryPoints.synchronization2)
+            enabled.push_back("VK_KHR_synchronization2");
+
+        float queuePriority = 1.0f;
+        VkDeviceQueueCreateInfo queueInfo = {};
+        queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueInfo.queueFamilyIndex = 0;
+        queueInfo.queueCount = 1;
+        queueInfo.pQueuePriorities = &queuePriority;
+
+        VkDeviceCreateInfo deviceInfo = {};
+        deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        deviceInfo.queueCreateInfoCount = 1;
+        deviceInfo.pQueueCreateInfos = &queueInfo;
+        deviceInfo.enabledExtensionCount = (uint32_t)enabled.size();
+        deviceInfo.ppEnabledExtensionNames = enabled.data();
+
+        VkDevice device = VK_NULL_HANDLE;
+        if (vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) != VK_SUCCESS)
+            return fail("vkCreateDevice failed");
+
+        entryPoints.acquireNextImage = (void*)vkGetDeviceProcAddr(device, "vkAcquireNextImageKHR");
+        entryPoints.queuePresent = (void*)vkGetDeviceProcAddr(device, "vkQueuePresentKHR");
+        entryPoints.createSwapchain = (void*)vkGetDeviceProcAddr(device, "vkCreateSwapchainKHR");
+        entryPoints.queueSubmit = (void*)vkGetDeviceProcAddr(device, "vkQueueSubmit");
+        entryPoints.getDeviceQueue = (void*)vkGetDeviceProcAddr(device, "vkGetDeviceQueue");
+        entryPoints.destroyDevice = (void*)vkGetDeviceProcAddr(device, "vkDestroyDevice");
+        entryPoints.destroySwapchain = (void*)vkGetDeviceProcAddr(device, "vkDestroySwapchainKHR");
+
+        if (entryPoints.apiVersion >= VK_API_VERSION_1_3)
+            entryPoints.queueSubmit2 = (void*)vkGetDeviceProcAddr(device, "vkQueueSubmit2");
+        else if (entryPoints.synchronization2)
+            entryPoints.queueSubmit2 = (void*)vkGetDeviceProcAddr(device, "vkQueueSubmit2KHR");
+
+        if (entryPoints.apiVersion >= VK_API_VERSION_1_1)
+            entryPoints.getDeviceQueue2 = (void*)vkGetDeviceProcAddr(device, "vkGetDeviceQueue2");
+
+        vkDestroyDevice(device, nullptr);
+
+        if (!entryPoints.acquireNextImage || !entryPoints.queuePresent || !entryPoints.createSwapchain)
+            return fail("Failed to get Vulkan function pointers");
+
+        return true;
+    }
+
+}
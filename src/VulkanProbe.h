@@ -0,0 +1,30 @@
+#pragma once
+#include "FrameJacker.h"
+#include "vulkan_core.h"
+
+namespace FrameJacker {
+
+    // Device-level entry points of the installed driver, resolved from a throwaway device
+    struct VulkanEntryPoints {
+        void* acquireNextImage;
+        void* queuePresent;
+        void* createSwapchain;
+        void* queueSubmit;
+        void* queueSubmit2;         // Core 1.3 or VK_KHR_synchronization2, may be null
+        void* getDeviceQueue;
+        void* getDeviceQueue2;      // Core 1.1, may be null
+        void* destroyDevice;
+        void* destroySwapchain;
+        uint32_t apiVersion;        // Version the device was created for, at most the physical device's
+        bool synchronization2;      // queueSubmit2 is vkQueueSubmit2KHR
+    };
+
+    class VulkanProbe {
+    public:
+        // Creates an instance and a device on the first physical device, resolves the entry points
+        // and destroys the device again. The instance is handed back and must outlive the hooks, so
+        // the driver stays loaded.
+        static bool Resolve(PFN_vkGetInstanceProcAddr getInstanceProcAddr, VkInstance& instance, VulkanEntryPoints& entryPoints);
+    };
+
+}
@@ -0,0 +1,158 @@
+#include "VulkanQueues.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace FrameJacker {
+
+    struct DeviceRecord {
+        VkDevice device;
+        VkPhysicalDevice physicalDevice;
+    };
+
+    struct QueueFamily {
+        VkDevice device;
+        VkQueue queue;
+        uint32_t family;
+        uint32_t type;
+    };
+
+    static PFN_vkGetPhysicalDeviceQueueFamilyProperties g_GetFamilyProperties = nullptr;
+
+    // Written when the game creates a device or fetches a queue, read when a queue is first used
+    static std::mutex g_Mutex;
+    static std::vector<DeviceRecord> g_Devices;
+    static std::vector<QueueFamily> g_Queues;
+
+    void VulkanQueues::Initialize(PFN_vkGetPhysicalDeviceQueueFamilyProperties getFamilyProperties) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_GetFamilyProperties = getFamilyProperties;
+    }
+
+    static VkPhysicalDevice FindPhysicalDevice(VkDevice device) {
+        for (const auto& entry : g_Devices) {
+            if (entry.device == device)
+                return entry.physicalDevice;
+        }
+        return VK_NULL_HANDLE;
+    }
+
+    void VulkanQueues::NoteDevice(VkDevice device, VkPhysicalDevice physicalDevice) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        for (auto& entry : g_Devices) {
+            // Handles are reused once a device is destroyed
+            if (entry.device == device) {
+                entry.physicalDevice = physicalDevice;
+                return;
+            }
+        }
+        g_Devices.push_back({ device, physicalDevice });
+    }
+
+    VkPhysicalDevice VulkanQueues::GetPhysicalDevice(VkDevice device) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        return FindPhysicalDevice(device);
+    }
+
+    void VulkanQueues::NoteQueue(VkDevice device, VkQueue queue, uint32_t family) {
+        if (!queue)
+            return;
+
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        uint32_t type = kUnknownQueueType;
+        VkPhysicalDevice physicalDevice = FindPhysicalDevice(device);
+        if (physicalDevice && g_GetFamilyProperties) {
+            uint32_t count = 0;
+            g_GetFamilyProperties(physicalDevice, &count, nullptr);
+            std::vector<VkQueueFamilyProperties> families(count);
+            g_GetFamilyProperties(physicalDevice, &count, families.data());
+            if (family < count)
+                type = families[family].queueFlags;
+        }
+
+        for (auto& entry : g_Queues) {
+            if (entry.queue == queue) {
+                entry.device = device;
+                entry.family = family;
+                entry.type = type;
+                return;
+            }
+        }
+        g_Queues.push_back({ device, queue, family, type });
+    }
+
+    void VulkanQueues::ForgetDevice(VkDevice device) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_Devices.erase(std::remove_if(g_Devices.begin(), g_Devices.end(),
+            [&](const DeviceRecord& entry) { return entry.device == device; }), g_Devices.end());
+        g_Queues.erase(std::remove_if(g_Queues.begin(), g_Queues.end(),
+            [&](const QueueFamily& entry) { return entry.device == device; }), g_Queues.end());
+    }
+
+    uint32_t VulkanQueues::GetType(VkQueue queue) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        for (const auto& entry : g_Queues) {
+            if (entry.queue == queue)
+                return entry.type;
+        }
+        return kUnknownQueueType;
+    }
+
+    uint32_t VulkanQueues::GetFamily(VkQueue queue) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        for (const auto& entry : g_Queues) {
+            if (entry.queue == queue)
+                return entry.family;
+        }
+        return VK_QUEUE_FAMILY_IGNORED;
+    }
+
+    QueueGroup VulkanQueues::GetGroup(uint32_t type) {
+        if (type == kUnknownQueueType)
+            return QueueGroup::Other;
+        if (type & VK_QUEUE_GRAPHICS_BIT)
+            return QueueGroup::Direct;
+        if (type & VK_QUEUE_COMPUTE_BIT)
+            return QueueGroup::Compute;
+        if (type & VK_QUEUE_TRANSFER_BIT)
+            return QueueGroup::Copy;
+        return QueueGroup::Other;
+    }
+
+    SubmissionCounts VulkanQueues::CountSubmits(uint32_t submitCount, const VkSubmitInfo* pSubmits) {
+        SubmissionCounts counts = { submitCount };
+        for (uint32_t i = 0; i < submitCount; i++) {
+            counts.commandLists += pSubmits[i].commandBufferCount;
+            counts.waitSemaphores += pSubmits[i].waitSemaphoreCount;
+            counts.signalSemaphores += pSubmits[i].signalSemaphoreCount;
+        }
+        return counts;
+    }
+
+    SubmissionCounts VulkanQueues::CountSubmits(uint32_t submitCount, const VkSubmitInfo2* pSubmits) {
+        SubmissionCounts counts = { submitCount };
+        for (uint32_t i = 0; i < submitCount; i++) {
+            counts.commandLists += pSubmits[i].commandBufferInfoCount;
+            counts.waitSemaphores += pSubmits[i].waitSemaphoreInfoCount;
+            counts.signalSemaphores += pSubmits[i].signalSemaphoreInfoCount;
+        }
+        return counts;
+    }
+
+    void VulkanQueues::RecordSubmission(VkQueue queue, const SubmissionCounts& counts) {
+        uint32_t slot = WorkCounters::FindQueue((void*)queue);
+        if (slot == WorkCounters::kMaxQueues) {
+            uint32_t type = GetType(queue);
+            slot = WorkCounters::AddQueue((void*)queue, type, GetGroup(type));
+        }
+        WorkCounters::RecordSubmission(slot, counts);
+    }
+
+    void VulkanQueues::Shutdown() {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_Devices.clear();
+        g_Queues.clear();
+        g_GetFamilyProperties = nullptr;
+    }
+
+}
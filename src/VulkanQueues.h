@@ -0,0 +1,38 @@
+#pragma once
+#include "FrameJacker.h"
+#include "WorkCounters.h"
+#include "vulkan_core.h"
+
+namespace FrameJacker {
+
+    // Physical device of every device the game created, and family of every queue it fetched with
+    // vkGetDeviceQueue(2), since the hooks went in
+    class VulkanQueues {
+    public:
+        static void Initialize(PFN_vkGetPhysicalDeviceQueueFamilyProperties getFamilyProperties);
+
+        static void NoteDevice(VkDevice device, VkPhysicalDevice physicalDevice);
+        // Null for devices created before the hooks
+        static VkPhysicalDevice GetPhysicalDevice(VkDevice device);
+
+        // The queue's type is unknown when its device was created before the hooks
+        static void NoteQueue(VkDevice device, VkQueue queue, uint32_t family);
+        static void ForgetDevice(VkDevice device);
+
+        // VkQueueFlags of the queue's family, or kUnknownQueueType
+        static uint32_t GetType(VkQueue queue);
+        static QueueGroup GetGroup(uint32_t type);
+        // Family index, or VK_QUEUE_FAMILY_IGNORED for queues fetched before the hooks
+        static uint32_t GetFamily(VkQueue queue);
+
+        // What one vkQueueSubmit or vkQueueSubmit2 call submits, apart from the time it took
+        static SubmissionCounts CountSubmits(uint32_t submitCount, const VkSubmitInfo* pSubmits);
+        static SubmissionCounts CountSubmits(uint32_t submitCount, const VkSubmitInfo2* pSubmits);
+        // Adds the call to the queue's WorkCounters slot, registering the queue under its family's
+        // group the first time
+        static void RecordSubmission(VkQueue queue, const SubmissionCounts& counts);
+
+        static void Shutdown();
+    };
+
+}
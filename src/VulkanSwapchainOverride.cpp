@@ -0,0 +1,131 @@
+#include "VulkanSwapchainOverride.h"
+#include "VulkanQueues.h"
+#include <algorithm>
+#include <vector>
+
+namespace FrameJacker {
+
+    struct SurfaceSupport {
+        VkSurfaceKHR surface;
+        VkPhysicalDevice physicalDevice;
+        uint32_t minImageCount;
+        uint32_t maxImageCount;         // 0 = no limit
+        uint32_t presentModes;          // Bit per core VkPresentModeKHR (IMMEDIATE to FIFO_RELAXED)
+    };
+
+    static PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR g_GetCapabilities = nullptr;
+    static PFN_vkGetPhysicalDeviceSurfacePresentModesKHR g_GetPresentModes = nullptr;
+
+    // Only touched from swapchain creation and surface destruction, so a plain mutex is enough
+    static std::mutex g_Mutex;
+    static std::vector<SurfaceSupport> g_Surfaces;
+
+    static const char* PresentModeName(VkPresentModeKHR mode) {
+        switch (mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "IMMEDIATE";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "MAILBOX";
+        case VK_PRESENT_MODE_FIFO_KHR: return "FIFO";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+        default: return "other";
+        }
+    }
+
+    void VulkanSwapchainOverride::Initialize(PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR getCapabilities,
+        PFN_vkGetPhysicalDeviceSurfacePresentModesKHR getPresentModes) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_GetCapabilities = getCapabilities;
+        g_GetPresentModes = getPresentModes;
+    }
+
+    static const SurfaceSupport* QuerySurface(VkSurfaceKHR surface, VkPhysicalDevice physicalDevice) {
+        for (const auto& entry : g_Surfaces) {
+            if (entry.surface == surface && entry.physicalDevice == physicalDevice)
+                return &entry;
+        }
+
+        if (!g_GetCapabilities || !g_GetPresentModes)
+            return nullptr;
+
+        VkSurfaceCapabilitiesKHR capabilities;
+        if (g_GetCapabilities(physicalDevice, surface, &capabilities) != VK_SUCCESS)
+            return nullptr;
+
+        VkPresentModeKHR modes[16];
+        uint32_t modeCount = 16;
+        VkResult result = g_GetPresentModes(physicalDevice, surface, &modeCount, modes);
+        if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+            return nullptr;
+
+        SurfaceSupport support = { surface, physicalDevice, capabilities.minImageCount, capabilities.maxImageCount, 0 };
+        for (uint32_t i = 0; i < modeCount; i++) {
+            if ((uint32_t)modes[i] <= VK_PRESENT_MODE_FIFO_RELAXED_KHR)
+                support.presentModes |= 1u << modes[i];
+        }
+
+        DEBUG_LOG("Surface %llx: %u to %u images, present modes 0x%x", (unsigned long long)surface,
+            support.minImageCount, support.maxImageCount, support.presentModes);
+        g_Surfaces.push_back(support);
+        return &g_Surfaces.back();
+    }
+
+    bool VulkanSwapchainOverride::Apply(VkDevice device, const VkSwapchainCreateInfoKHR& info, VkSwapchainCreateInfoKHR& rewritten) {
+        VulkanSwapchainPolicy policy;
+        {
+            std::lock_guard<std::mutex> lock(s_PolicyMutex);
+            policy = s_Policy;
+        }
+        if (policy.PresentMode == VulkanPresentMode::Keep && !policy.MinImageCount)
+            return false;
+
+        VkPhysicalDevice physicalDevice = VulkanQueues::GetPhysicalDevice(device);
+        if (!physicalDevice) {
+            DEBUG_LOG("Device %p was created before the hooks, keeping its swapchain settings", (void*)device);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        const SurfaceSupport* support = QuerySurface(info.surface, physicalDevice);
+        if (!support) {
+            DEBUG_LOG("Could not query surface %llx, keeping its swapchain settings", (unsigned long long)info.surface);
+            return false;
+        }
+
+        rewritten = info;
+
+        if (policy.PresentMode != VulkanPresentMode::Keep) {
+            VkPresentModeKHR mode = (VkPresentModeKHR)policy.PresentMode;
+            if (support->presentModes & (1u << mode))
+                rewritten.presentMode = mode;
+            else
+                DEBUG_LOG("Surface does not support %s, keeping %s", PresentModeName(mode), PresentModeName(info.presentMode));
+        }
+
+        if (policy.MinImageCount) {
+            uint32_t count = std::max(policy.MinImageCount, support->minImageCount);
+            if (support->maxImageCount)
+                count = std::min(count, support->maxImageCount);
+            rewritten.minImageCount = count;
+        }
+
+        if (rewritten.presentMode == info.presentMode && rewritten.minImageCount == info.minImageCount)
+            return false;
+
+        DEBUG_LOG("Swapchain %s with %u images -> %s with %u images", PresentModeName(info.presentMode), info.minImageCount,
+            PresentModeName(rewritten.presentMode), rewritten.minImageCount);
+        return true;
+    }
+
+    void VulkanSwapchainOverride::ForgetSurface(VkSurfaceKHR surface) {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_Surfaces.erase(std::remove_if(g_Surfaces.begin(), g_Surfaces.end(),
+            [&](const SurfaceSupport& entry) { return entry.surface == surface; }), g_Surfaces.end());
+    }
+
+    void VulkanSwapchainOverride::Shutdown() {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_Surfaces.clear();
+        g_GetCapabilities = nullptr;
+        g_GetPresentModes = nullptr;
+    }
+
+}
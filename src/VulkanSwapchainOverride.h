@@ -0,0 +1,38 @@
+#pragma once
+#include "FrameJacker.h"
+#include <mutex>
+#if FRAMEJACKER_INCLUDE_VULKAN
+#include "vulkan_core.h"
+#endif
+
+namespace FrameJacker {
+
+    // Applies the VulkanSwapchainPolicy to the game's vkCreateSwapchainKHR calls. What a surface
+    // supports is queried once per surface and physical device and cached; the physical device
+    // comes from VulkanQueues, so devices created before the hooks went in are left alone.
+    class VulkanSwapchainOverride {
+    public:
+        static void SetPolicy(const VulkanSwapchainPolicy& policy) {
+            std::lock_guard<std::mutex> lock(s_PolicyMutex);
+            s_Policy = policy;
+        }
+
+#if FRAMEJACKER_INCLUDE_VULKAN
+        static void Initialize(PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR getCapabilities,
+            PFN_vkGetPhysicalDeviceSurfacePresentModesKHR getPresentModes);
+
+        // Fills rewritten and returns true when the policy changes the create info
+        static bool Apply(VkDevice device, const VkSwapchainCreateInfoKHR& info, VkSwapchainCreateInfoKHR& rewritten);
+
+        // The rewritten create info failed or the surface was destroyed; query it again next time
+        static void ForgetSurface(VkSurfaceKHR surface);
+
+        static void Shutdown();
+#endif
+
+    private:
+        inline static std::mutex s_PolicyMutex;
+        inline static VulkanSwapchainPolicy s_Policy;
+    };
+
+}
@@ -0,0 +1,203 @@
+#include "WorkCounters.h"
+#include <mutex>
+
+namespace FrameJacker {
+
+    static constexpr uint32_t kCounterCount = (uint32_t)WorkCounter::Count;
+
+    static std::atomic<WorkThreadBlock*> g_Blocks = nullptr;
+
+    static std::atomic<void*> g_Queues[WorkCounters::kMaxQueues] = {};
+    static std::atomic<uint32_t> g_QueueTypes[WorkCounters::kMaxQueues] = {};
+    static std::atomic<QueueGroup> g_QueueGroups[WorkCounters::kMaxQueues] = {};
+
+    // Held by EndFrame to publish and by the Get functions to copy. EndFrame only tries the lock, so a
+    // reader never stalls a present; a frame it misses is folded into the next one.
+    static std::mutex g_FoldMutex;
+    struct QueueSums {
+        uint64_t submissions;
+        uint64_t batches;
+        uint64_t commandLists;
+        uint64_t waitSemaphores;
+        uint64_t signalSemaphores;
+        uint64_t nanoseconds;
+    };
+
+    static QueueSums g_PreviousQueues[WorkCounters::kMaxQueues] = {};
+    static uint64_t g_PreviousCounters[kCounterCount] = {};
+    static SubmissionStats g_Submissions = {};
+    static DrawStats g_Draws = {};
+    static std::atomic<uint64_t> g_LastSubmissions = 0;
+    static std::atomic<uint64_t> g_LastDrawCalls = 0;
+
+    WorkThreadBlock* WorkCounters::RegisterThread() {
+        WorkThreadBlock* block = new WorkThreadBlock();
+        block->next = g_Blocks.load(std::memory_order_relaxed);
+        while (!g_Blocks.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) {}
+
+        t_Block = block;
+        return block;
+    }
+
+    void WorkCounters::SetSubmissionsEnabled(bool enabled) {
+        s_Submissions.store(enabled, std::memory_order_relaxed);
+    }
+
+    void WorkCounters::SetDrawsEnabled(bool enabled, bool timing) {
+        s_Timing.store(enabled && timing, std::memory_order_relaxed);
+        s_Draws.store(enabled, std::memory_order_relaxed);
+    }
+
+    uint32_t WorkCounters::FindQueue(void* queue) {
+        for (uint32_t i = 0; i < kMaxQueues; i++) {
+            void* known = g_Queues[i].load(std::memory_order_acquire);
+            if (known == queue)
+                return i;
+            if (!known)
+                break;
+        }
+
+        return kMaxQueues;
+    }
+
+    uint32_t WorkCounters::AddQueue(void* queue, uint32_t type, QueueGroup group) {
+        for (uint32_t i = 0; i < kMaxQueues; i++) {
+            void* expected = nullptr;
+            if (g_Queues[i].compare_exchange_strong(expected, queue, std::memory_order_acq_rel)) {
+                g_QueueTypes[i].store(type, std::memory_order_relaxed);
+                g_QueueGroups[i].store(group, std::memory_order_relaxed);
+                return i;
+            }
+            if (expected == queue)
+                return i;
+        }
+
+        return kMaxQueues - 1;
+    }
+
+    void WorkCounters::RecordSubmission(uint32_t slot, const SubmissionCounts& counts) {
+        QueueTotals& totals = AcquireBlock()->queues[slot];
+        Add(totals.submissions, 1);
+        Add(totals.batches, counts.batches);
+        Add(totals.commandLists, counts.commandLists);
+        Add(totals.waitSemaphores, counts.waitSemaphores);
+        Add(totals.signalSemaphores, counts.signalSemaphores);
+        Add(totals.nanoseconds, counts.nanoseconds);
+    }
+
+    static void FoldSubmissions(const QueueSums* queues) {
+        SubmissionStats& stats = g_Submissions;
+        uint64_t frames = stats.frames + 1;
+        stats = {};
+        stats.frames = frames;
+
+        for (uint32_t i = 0; i < WorkCounters::kMaxQueues; i++) {
+            void* queue = g_Queues[i].load(std::memory_order_acquire);
+            if (!queue)
+                break;
+
+            QueueSubmissionStats& entry = stats.queues[stats.queueCount++];
+            entry.queue = queue;
+            entry.type = g_QueueTypes[i].load(std::memory_order_relaxed);
+            QueueSums& previous = g_PreviousQueues[i];
+            entry.submissions = queues[i].submissions - previous.submissions;
+            entry.batches = queues[i].batches - previous.batches;
+            entry.commandLists = queues[i].commandLists - previous.commandLists;
+            entry.waitSemaphores = queues[i].waitSemaphores - previous.waitSemaphores;
+            entry.signalSemaphores = queues[i].signalSemaphores - previous.signalSemaphores;
+            entry.submitMicroseconds = (queues[i].nanoseconds - previous.nanoseconds) / 1000.0;
+            previous = queues[i];
+
+            stats.submissions += entry.submissions;
+            stats.batches += entry.batches;
+            stats.commandLists += entry.commandLists;
+            stats.submitMicroseconds += entry.submitMicroseconds;
+            QueueGroup group = g_QueueGroups[i].load(std::memory_order_relaxed);
+            if (group == QueueGroup::Direct)
+                stats.directSubmissions += entry.submissions;
+            else if (group == QueueGroup::Compute)
+                stats.computeSubmissions += entry.submissions;
+            else if (group == QueueGroup::Copy)
+                stats.copySubmissions += entry.submissions;
+        }
+
+        g_LastSubmissions.store(stats.submissions, std::memory_order_relaxed);
+    }
+
+    static void FoldDraws(const uint64_t* counters) {
+        uint64_t frame[kCounterCount];
+        for (uint32_t i = 0; i < kCounterCount; i++) {
+            frame[i] = counters[i] - g_PreviousCounters[i];
+            g_PreviousCounters[i] = counters[i];
+        }
+
+        DrawStats& stats = g_Draws;
+        stats.frames++;
+        stats.drawCalls = frame[(uint32_t)WorkCounter::DrawCalls];
+        stats.textureBinds = frame[(uint32_t)WorkCounter::TextureBinds];
+        stats.renderStateChanges = frame[(uint32_t)WorkCounter::RenderStateChanges];
+        stats.shaderChanges = frame[(uint32_t)WorkCounter::ShaderChanges];
+        stats.dispatches = frame[(uint32_t)WorkCounter::Dispatches];
+        stats.maps = frame[(uint32_t)WorkCounter::Maps];
+        stats.unmaps = frame[(uint32_t)WorkCounter::Unmaps];
+        stats.resourceUpdates = frame[(uint32_t)WorkCounter::ResourceUpdates];
+        stats.resourceCopies = frame[(uint32_t)WorkCounter::ResourceCopies];
+        stats.drawMicroseconds = frame[(uint32_t)WorkCounter::DrawNanoseconds] / 1000.0;
+        stats.dispatchMicroseconds = frame[(uint32_t)WorkCounter::DispatchNanoseconds] / 1000.0;
+        stats.mapMicroseconds = frame[(uint32_t)WorkCounter::MapNanoseconds] / 1000.0;
+        stats.transferMicroseconds = frame[(uint32_t)WorkCounter::TransferNanoseconds] / 1000.0;
+
+        g_LastDrawCalls.store(stats.drawCalls, std::memory_order_relaxed);
+    }
+
+    void WorkCounters::EndFrame() {
+        bool submissionsEnabled = IsSubmissionsEnabled();
+        bool drawsEnabled = IsDrawsEnabled();
+        if (!submissionsEnabled && !drawsEnabled)
+            return;
+
+        std::unique_lock<std::mutex> lock(g_FoldMutex, std::try_to_lock);
+        if (!lock.owns_lock())
+            return;
+
+        uint64_t counters[kCounterCount] = {};
+        QueueSums queues[kMaxQueues] = {};
+        for (WorkThreadBlock* block = g_Blocks.load(std::memory_order_acquire); block; block = block->next) {
+            for (uint32_t i = 0; i < kCounterCount; i++)
+                counters[i] += block->counters[i].load(std::memory_order_relaxed);
+            for (uint32_t i = 0; i < kMaxQueues; i++) {
+                const QueueTotals& totals = block->queues[i];
+                queues[i].submissions += totals.submissions.load(std::memory_order_relaxed);
+                queues[i].batches += totals.batches.load(std::memory_order_relaxed);
+                queues[i].commandLists += totals.commandLists.load(std::memory_order_relaxed);
+                queues[i].waitSemaphores += totals.waitSemaphores.load(std::memory_order_relaxed);
+                queues[i].signalSemaphores += totals.signalSemaphores.load(std::memory_order_relaxed);
+                queues[i].nanoseconds += totals.nanoseconds.load(std::memory_order_relaxed);
+            }
+        }
+
+        if (submissionsEnabled)
+            FoldSubmissions(queues);
+        if (drawsEnabled)
+            FoldDraws(counters);
+    }
+
+    SubmissionStats WorkCounters::GetSubmissions() {
+        std::lock_guard<std::mutex> lock(g_FoldMutex);
+        return g_Submissions;
+    }
+
+    DrawStats WorkCounters::GetDraws() {
+        std::lock_guard<std::mutex> lock(g_FoldMutex);
+        return g_Draws;
+    }
+
+    uint64_t WorkCounters::GetLastSubmissions() {
+        return IsSubmissionsEnabled() ? g_LastSubmissions.load(std::memory_order_relaxed) : 0;
+    }
+
+    uint64_t WorkCounters::GetLastDrawCalls() {
+        return IsDrawsEnabled() ? g_LastDrawCalls.load(std::memory_order_relaxed) : 0;
+    }
+
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include "FrameJacker.h"
+#include "Clock.h"
+#include <atomic>
+
+namespace FrameJacker {
+
+    enum class WorkCounter : uint32_t {
+        DrawCalls,
+        TextureBinds,
+        RenderStateChanges,
+        ShaderChanges,
+        Dispatches,
+        Maps,
+        Unmaps,
+        ResourceUpdates,
+        ResourceCopies,
+
+        // CPU time inside the original calls, counted with timing enabled
+        DrawNanoseconds,
+        DispatchNanoseconds,
+        MapNanoseconds,
+        TransferNanoseconds,
+        Count
+    };
+
+    // Which of the per-type submission sums a queue counts towards
+    enum class QueueGroup : uint32_t {
+        Direct,         // D3D12 direct queues, Vulkan graphics families
+        Compute,
+        Copy,           // D3D12 copy queues, Vulkan transfer-only families
+        Other
+    };
+
+    // One ExecuteCommandLists or vkQueueSubmit(2) call
+    struct SubmissionCounts {
+        uint32_t batches;               // VkSubmitInfo count, 1 on D3D12
+        uint32_t commandLists;
+        uint32_t waitSemaphores;
+        uint32_t signalSemaphores;
+        uint64_t nanoseconds;
+    };
+
+    struct QueueTotals {
+        std::atomic<uint64_t> submissions = 0;
+        std::atomic<uint64_t> batches = 0;
+        std::atomic<uint64_t> commandLists = 0;
+        std::atomic<uint64_t> waitSemaphores = 0;
+        std::atomic<uint64_t> signalSemaphores = 0;
+        std::atomic<uint64_t> nanoseconds = 0;
+    };
+
+    // Running totals written only by the owning thread. Blocks are never freed: a thread that exits
+    // leaves its totals behind, which keeps the per-frame deltas right.
+    struct WorkThreadBlock {
+        std::atomic<uint64_t> counters[(uint32_t)WorkCounter::Count] = {};
+        QueueTotals queues[kMaxTrackedQueues];
+        WorkThreadBlock* next = nullptr;
+    };
+
+    // API work issued between presents. The hooked calls bump counters owned by their own thread, so
+    // they never contend or take a lock prefix; the presenting thread folds every thread's counters
+    // into per-frame figures in EndFrame.
+    class WorkCounters {
+    public:
+        static constexpr uint32_t kMaxQueues = kMaxTrackedQueues;
+
+        static bool IsSubmissionsEnabled() { return s_Submissions.load(std::memory_order_relaxed); }
+        static void SetSubmissionsEnabled(bool enabled);
+
+        static bool IsDrawsEnabled() { return s_Draws.load(std::memory_order_relaxed); }
+        static bool IsTimingEnabled() { return s_Timing.load(std::memory_order_relaxed); }
+        static void SetDrawsEnabled(bool enabled, bool timing = false);
+
+        // Set while FrameJacker renders on the game's thread (overlay composite, OnRender). The hooks
+        // record nothing meanwhile, so our own calls never show up as the game's work.
+        static bool IsInternalWork() { return t_Internal; }
+
+        static void Count(WorkCounter counter, uint64_t value = 1) {
+            if (!t_Internal)
+                Add(AcquireBlock()->counters[(uint32_t)counter], value);
+        }
+
+        // Slot of a queue seen before, or kMaxQueues. AddQueue registers a new one; once the table is
+        // full, further queues share the last slot.
+        static uint32_t FindQueue(void* queue);
+        static uint32_t AddQueue(void* queue, uint32_t type, QueueGroup group);
+        static void RecordSubmission(uint32_t slot, const SubmissionCounts& counts);
+
+        // Called by the presenting thread once per frame
+        static void EndFrame();
+
+        static SubmissionStats GetSubmissions();
+        static DrawStats GetDraws();
+
+        // Totals of the last folded frame, readable without the lock
+        static uint64_t GetLastSubmissions();
+        static uint64_t GetLastDrawCalls();
+
+    private:
+        static WorkThreadBlock* AcquireBlock() {
+            return t_Block ? t_Block : RegisterThread();
+        }
+
+        static void Add(std::atomic<uint64_t>& counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        static WorkThreadBlock* RegisterThread();
+
+        inline static std::atomic<bool> s_Submissions = false;
+        inline static std::atomic<bool> s_Draws = false;
+        inline static std::atomic<bool> s_Timing = false;
+        inline static thread_local WorkThreadBlock* t_Block = nullptr;
+        inline static thread_local bool t_Internal = false;
+
+        friend class InternalWorkScope;
+    };
+
+    // Marks the API calls FrameJacker makes within it as its own. Nests.
+    class InternalWorkScope {
+    public:
+        InternalWorkScope() : m_Previous(WorkCounters::t_Internal) { WorkCounters::t_Internal = true; }
+        ~InternalWorkScope() { WorkCounters::t_Internal = m_Previous; }
+
+        InternalWorkScope(const InternalWorkScope&) = delete;
+        InternalWorkScope& operator=(const InternalWorkScope&) = delete;
+
+    private:
+        bool m_Previous;
+    };
+
+    // Counts the hooked call it encloses and, with timing enabled, the time spent in it. Costs one
+    // relaxed load while draw statistics are off.
+    class WorkScope {
+    public:
+        WorkScope(WorkCounter counter, WorkCounter time) : m_Time(time) {
+            if (!WorkCounters::IsDrawsEnabled() || WorkCounters::IsInternalWork())
+                return;
+
+            WorkCounters::Count(counter);
+            if (WorkCounters::IsTimingEnabled())
+                m_Start = Clock::Now();
+        }
+
+        ~WorkScope() {
+            if (m_Start)
+                WorkCounters::Count(m_Time, Clock::Now() - m_Start);
+        }
+
+        WorkScope(const WorkScope&) = delete;
+        WorkScope& operator=(const WorkScope&) = delete;
+
+    private:
+        WorkCounter m_Time;
+        uint64_t m_Start = 0;
+    };
+
+}
@@ -0,0 +1,162 @@
+#include "CallbackRegistry.h"
+#include "Check.h"
+#include "Clock.h"
+#include "FrameTelemetry.h"
+#include "ResizeCoalescer.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Presents on several threads while subscribers come and go. Run it under ASan or TSan to catch a
+// snapshot freed while a hook still reads it.
+static void ConcurrentPublish() {
+    std::atomic<bool> stop = false;
+    std::atomic<uint64_t> calls = 0;
+    std::vector<std::thread> presenters;
+
+    for (int i = 0; i < 4; i++) {
+        presenters.emplace_back([&] {
+            int swapChain = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                CallbackScope callbacks;
+                callbacks.BeginFrame(API::D3D11, &swapChain);
+                callbacks.OnPresent();
+                callbacks.BeginOriginalPresent();
+                callbacks.OnPostPresent();
+            }
+        });
+    }
+
+    std::vector<SubscriptionId> ids;
+    for (int i = 0; i < 2000; i++) {
+        Callbacks callbacks;
+        callbacks.OnPresent = [&calls](const FrameEvent&) { calls.fetch_add(1, std::memory_order_relaxed); };
+        callbacks.Priority = i % 3;
+        ids.push_back(CallbackRegistry::Subscribe(callbacks));
+        if (ids.size() > 8) {
+            CHECK(CallbackRegistry::Unsubscribe(ids.front()));
+            ids.erase(ids.begin());
+        }
+    }
+
+    // Give the presenters a chance to see the last subscribers
+    for (int i = 0; i < 1000 && calls.load() == 0; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    stop = true;
+    for (auto& thread : presenters)
+        thread.join();
+    for (SubscriptionId id : ids)
+        CHECK(CallbackRegistry::Unsubscribe(id));
+    CHECK(calls.load() > 0);
+}
+
+// A hook that stays inside its scope for most of the frame (frame limiter, latency delay) must not
+// keep replaced snapshots alive once it moves on
+static void ReclaimWhileReading() {
+    std::atomic<bool> stop = false;
+    std::thread presenter([&] {
+        int swapChain = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            CallbackScope callbacks;
+            callbacks.BeginFrame(API::Vulkan, &swapChain);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    });
+
+    for (int i = 0; i < 200; i++) {
+        Callbacks callbacks;
+        callbacks.OnPostPresent = [](const FrameEvent&) {};
+        CHECK(CallbackRegistry::Unsubscribe(CallbackRegistry::Subscribe(callbacks)));
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    // No more publishes from here on: the presenter's own scope exits have to free them
+    for (int i = 0; i < 100 && CallbackRegistry::GetRetiredSnapshotCount(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    size_t retired = CallbackRegistry::GetRetiredSnapshotCount();
+
+    stop = true;
+    presenter.join();
+    CHECK(retired == 0);
+}
+
+static void NestedScopes() {
+    Callbacks callbacks;
+    int outerCalls = 0;
+    callbacks.OnPresent = [&outerCalls](const FrameEvent&) { outerCalls++; };
+    SubscriptionId id = CallbackRegistry::Subscribe(callbacks);
+
+    {
+        int swapChain = 0;
+        CallbackScope outer;
+        outer.BeginFrame(API::D3D12, &swapChain);
+        {
+            // A hook firing from inside a callback, e.g. ExecuteCommandLists from OnRender
+            CallbackScope inner;
+            CHECK(CallbackRegistry::Unsubscribe(id));
+        }
+        // Still pinned by the outer scope
+        CHECK(CallbackRegistry::GetRetiredSnapshotCount() >= 1);
+        outer.OnPresent();
+        CHECK(outerCalls == 1);
+    }
+
+    CHECK(CallbackRegistry::GetRetiredSnapshotCount() == 0);
+}
+
+// A settled resize handed to a present is a subscriber's cost, not the hook's, and is delivered
+// even while the subscriber is throttled
+static void EventsAreTimed() {
+    static constexpr uint64_t kSpinNanoseconds = 2000000;
+    Callbacks callbacks;
+    int resizes = 0;
+    callbacks.OnResize = [&resizes](const ResizeEvent& resize) {
+        if (!resize.settled)
+            return;
+        resizes++;
+        uint64_t start = Clock::Now();
+        while (Clock::Now() - start < kSpinNanoseconds) {}
+    };
+    callbacks.BudgetMicroseconds = 100.0;
+    callbacks.ThrottleInterval = 4;
+    SubscriptionId id = CallbackRegistry::Subscribe(callbacks);
+
+    ResizeCoalescer::SetSettleTime(1);
+    FrameTelemetry::Reset();
+    int swapChain = 0;
+    for (int i = 0; i < 8; i++) {
+        CallbackScope scope;
+        scope.DeferResize({ API::D3D11, 640, 480, 0, &swapChain, true });
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        scope.BeginFrame(API::D3D11, &swapChain);
+        scope.OnPresent();
+        scope.BeginOriginalPresent();
+        scope.OnPostPresent();
+    }
+    ResizeCoalescer::SetSettleTime(0);
+
+    CHECK(resizes == 8);
+    OverheadStats overhead = FrameTelemetry::GetOverhead();
+    CHECK(overhead.frames == 8);
+    CHECK(overhead.averageMicroseconds < kSpinNanoseconds / 2000.0);
+
+    CallbackStats stats;
+    CHECK(CallbackRegistry::GetCallbackStats(id, stats));
+    CHECK(stats.throttled);
+    CHECK(stats.skippedFrames > 0);
+    CHECK(stats.averageMicroseconds >= kSpinNanoseconds / 1000.0);
+    CHECK(CallbackRegistry::Unsubscribe(id));
+}
+
+int main() {
+    ConcurrentPublish();
+    ReclaimWhileReading();
+    NestedScopes();
+    EventsAreTimed();
+    std::printf("CallbackRegistryTest passed\n");
+    return 0;
+}
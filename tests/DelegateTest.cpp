@@ -0,0 +1,42 @@
+#include <FrameJacker/Delegate.h>
+#include "Check.h"
+
+using namespace FrameJacker;
+
+static int g_Calls = 0;
+static void Increment(int amount) { g_Calls += amount; }
+
+int main() {
+    Delegate<void(int)> empty;
+    CHECK(!empty);
+
+    void (*none)(int) = nullptr;
+    Delegate<void(int)> fromNull(none);
+    CHECK(!fromNull);
+
+    Delegate<void(int)> function(&Increment);
+    CHECK(function);
+    function(2);
+    CHECK(g_Calls == 2);
+
+    int total = 0;
+    int* target = &total;
+    Delegate<int(int, int)> captured([target](int a, int b) { *target += a * b; return *target; });
+    Delegate<int(int, int)> copy = captured;
+    CHECK(captured(2, 3) == 6);
+    CHECK(copy(1, 4) == 10);
+
+    // Plain values are stored inline, so copies are independent
+    struct Values { int a, b, c, d; };
+    Values values = { 1, 2, 3, 4 };
+    Delegate<int()> byValue([values]() { return values.a + values.b + values.c + values.d; });
+    values.a = 100;
+    CHECK(byValue() == 10);
+
+    copy = nullptr;
+    CHECK(!copy);
+    CHECK(captured);
+
+    std::printf("DelegateTest passed\n");
+    return 0;
+}
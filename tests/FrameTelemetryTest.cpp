@@ -0,0 +1,134 @@
+#include "FrameTelemetry.h"
+#include "CallbackRegistry.h"
+#include "Check.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Presents from several threads at once: every sample lands and Snapshot never sees a torn window
+static void ConcurrentRecord() {
+    static constexpr uint32_t kThreads = 4;
+    static constexpr uint32_t kSamples = 20000;
+
+    std::atomic<bool> stop = false;
+    std::thread reader([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            FrameStats stats = FrameTelemetry::Snapshot();
+            CHECK(stats.windowFrames <= FrameTelemetry::kWindowFrames);
+            if (stats.windowFrames) {
+                CHECK(stats.averageMilliseconds >= 1.0 && stats.averageMilliseconds <= 4.0);
+                CHECK(stats.p50Milliseconds >= 1.0 && stats.p50Milliseconds <= 4.1);
+            }
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (uint32_t i = 0; i < kThreads; i++) {
+        writers.emplace_back([i] {
+            for (uint32_t sample = 0; sample < kSamples; sample++)
+                FrameTelemetry::Record((i + 1) * 1000000ull);
+        });
+    }
+
+    for (auto& writer : writers)
+        writer.join();
+    stop = true;
+    reader.join();
+
+    FrameStats stats = FrameTelemetry::Snapshot();
+    CHECK(stats.frames == kThreads * kSamples);
+    CHECK(stats.windowFrames == FrameTelemetry::kWindowFrames);
+}
+
+static void WindowContents() {
+    FrameTelemetry::Reset();
+    FrameStats stats = FrameTelemetry::Snapshot();
+    CHECK(stats.frames == 0 && stats.windowFrames == 0);
+
+    for (uint32_t i = 0; i < 100; i++)
+        FrameTelemetry::Record(10000000);
+    FrameTelemetry::RecordPresent(4000000);
+
+    stats = FrameTelemetry::Snapshot();
+    CHECK(stats.frames == 100);
+    CHECK(stats.windowFrames == 100);
+    CHECK(stats.averageMilliseconds > 9.99 && stats.averageMilliseconds < 10.01);
+    CHECK(stats.averagePresentMilliseconds > 3.99 && stats.averagePresentMilliseconds < 4.01);
+
+    // The oldest samples leave the window as new ones come in
+    for (uint32_t i = 0; i < FrameTelemetry::kWindowFrames; i++)
+        FrameTelemetry::Record(20000000);
+    stats = FrameTelemetry::Snapshot();
+    CHECK(stats.windowFrames == FrameTelemetry::kWindowFrames);
+    CHECK(stats.averageMilliseconds > 19.99 && stats.averageMilliseconds < 20.01);
+    CHECK(stats.p99Milliseconds > 19.9 && stats.p99Milliseconds < 20.1);
+}
+
+static void ResetWhileRecording() {
+    std::atomic<bool> stop = false;
+    std::thread writer([&] {
+        while (!stop.load(std::memory_order_relaxed))
+            FrameTelemetry::Record(5000000);
+    });
+
+    for (int i = 0; i < 1000; i++)
+        FrameTelemetry::Reset();
+
+    stop = true;
+    writer.join();
+
+    // Whatever survived the last Reset has to be exactly the 5 ms samples recorded after it
+    FrameStats stats = FrameTelemetry::Snapshot();
+    CHECK(stats.windowFrames <= FrameTelemetry::kWindowFrames);
+    if (stats.windowFrames)
+        CHECK(stats.averageMilliseconds > 4.99 && stats.averageMilliseconds < 5.01);
+}
+
+// Disabling keeps the session's data, the same precision picks it up again, and a histogram replaced
+// while a writer records into it is freed once the writer is done with it
+static void HistogramSession() {
+    FrameTelemetry::SetHistogramEnabled(true, 8);
+    for (uint32_t i = 0; i < 10; i++)
+        FrameTelemetry::Record(1000000);
+    CHECK(FrameTelemetry::GetHistogram().GetTotalCount() == 10);
+
+    FrameTelemetry::SetHistogramEnabled(false, 8);
+    for (uint32_t i = 0; i < 5; i++)
+        FrameTelemetry::Record(1000000);
+    CHECK(FrameTelemetry::GetHistogram().GetTotalCount() == 10);
+
+    FrameTelemetry::SetHistogramEnabled(true, 8);
+    for (uint32_t i = 0; i < 5; i++)
+        FrameTelemetry::Record(1000000);
+    CHECK(FrameTelemetry::GetHistogram().GetTotalCount() == 15);
+
+    std::atomic<bool> stop = false;
+    std::thread writer([&] {
+        while (!stop.load(std::memory_order_relaxed))
+            FrameTelemetry::Record(2000000);
+    });
+    for (uint32_t i = 0; i < 200; i++)
+        FrameTelemetry::SetHistogramEnabled(true, i % 2 ? 6 : 7);
+    stop = true;
+    writer.join();
+
+    // The last one retired may have waited for the writer, any reader leaving frees it
+    FrameTelemetry::Record(2000000);
+    CHECK(CallbackRegistry::GetRetiredSnapshotCount() == 0);
+
+    Histogram histogram = FrameTelemetry::GetHistogram();
+    CHECK(histogram.GetPrecisionBits() == 6);
+    CHECK(histogram.GetTotalCount() == 0 || histogram.GetMin() == histogram.GetLowestEquivalent(2000000));
+    FrameTelemetry::SetHistogramEnabled(false, 6);
+}
+
+int main() {
+    ConcurrentRecord();
+    WindowContents();
+    ResetWhileRecording();
+    HistogramSession();
+    std::printf("FrameTelemetryTest passed\n");
+    return 0;
+}
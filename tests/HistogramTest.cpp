@@ -0,0 +1,104 @@
+#include <FrameJacker/Histogram.h>
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Every value falls inside its own bucket, buckets tile the range without gaps, and a bucket is never
+// wider than the precision promises
+static void BucketBoundaries() {
+    Histogram histogram;
+    double precision = 1.0 / (1u << (Histogram::kDefaultPrecisionBits - 1));
+
+    for (uint64_t value = 0; value < 5000000; value += value < 100000 ? 1 : 97) {
+        uint64_t lowest = histogram.GetLowestEquivalent(value);
+        uint64_t highest = histogram.GetHighestEquivalent(value);
+        CHECK(lowest <= value && value <= highest);
+        if (value >= 256)
+            CHECK((double)(highest - lowest + 1) / lowest <= precision + 1e-9);
+    }
+
+    for (uint64_t value = 1; value < histogram.GetHighestValue(); value = value * 3 / 2 + 1) {
+        uint64_t next = histogram.GetHighestEquivalent(value) + 1;
+        CHECK(histogram.GetLowestEquivalent(next) == next);
+    }
+}
+
+// Percentiles against the exact order statistics of the same samples
+static void Percentiles() {
+    std::mt19937_64 random(1);
+    std::exponential_distribution<> frameTimes(1.0 / 16.6e6);
+
+    Histogram histogram;
+    std::vector<uint64_t> values;
+    for (int i = 0; i < 100000; i++) {
+        uint64_t value = (uint64_t)frameTimes(random);
+        values.push_back(value);
+        histogram.Record(value);
+    }
+    std::sort(values.begin(), values.end());
+
+    CHECK(histogram.GetTotalCount() == values.size());
+    CHECK(histogram.GetMin() == histogram.GetLowestEquivalent(values.front()));
+    CHECK(histogram.GetHighestEquivalent(histogram.GetMax()) == histogram.GetHighestEquivalent(values.back()));
+
+    for (double percentile : { 1.0, 50.0, 90.0, 99.0, 99.9 }) {
+        uint64_t exact = values[(size_t)std::ceil(percentile / 100.0 * values.size()) - 1];
+        uint64_t reported = histogram.GetValueAtPercentile(percentile);
+        CHECK(histogram.GetLowestEquivalent(reported) == histogram.GetLowestEquivalent(exact));
+    }
+
+    double mean = 0.0;
+    for (uint64_t value : values)
+        mean += (double)value / values.size();
+    CHECK(std::fabs(histogram.GetMean() - mean) / mean < 0.01);
+}
+
+static void MergeAndSubtract() {
+    Histogram all;
+    Histogram firstHalf;
+    for (uint64_t i = 0; i < 1000; i++) {
+        all.Record(i * 10000);
+        if (i < 500)
+            firstHalf.Record(i * 10000);
+    }
+
+    Histogram secondHalf = all;
+    CHECK(secondHalf.Subtract(firstHalf));
+    CHECK(secondHalf.GetTotalCount() == 500);
+    CHECK(secondHalf.GetMin() == secondHalf.GetLowestEquivalent(5000000));
+
+    CHECK(secondHalf.Merge(firstHalf));
+    CHECK(secondHalf.GetTotalCount() == all.GetTotalCount());
+    CHECK(secondHalf.GetValueAtPercentile(50) == all.GetValueAtPercentile(50));
+
+    Histogram coarse(Histogram::kDefaultHighestValue, 4);
+    CHECK(!coarse.IsCompatible(all));
+    CHECK(!coarse.Merge(all));
+    CHECK(!coarse.Subtract(all));
+
+    all.Reset();
+    CHECK(all.GetTotalCount() == 0);
+}
+
+static void OutOfRange() {
+    Histogram histogram(1000000000, 8);
+    histogram.Record(1ull << 62);
+    histogram.Record(5, 3);
+    CHECK(histogram.GetTotalCount() == 4);
+    CHECK(histogram.GetMax() <= histogram.GetHighestEquivalent(histogram.GetHighestValue()));
+    CHECK(histogram.GetMax() >= histogram.GetHighestValue());
+    CHECK(histogram.GetValueAtPercentile(50) == 5);
+}
+
+int main() {
+    BucketBoundaries();
+    Percentiles();
+    MergeAndSubtract();
+    OutOfRange();
+    std::printf("HistogramTest passed\n");
+    return 0;
+}
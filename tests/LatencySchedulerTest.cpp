@@ -0,0 +1,137 @@
+#include "LatencyScheduler.h"
+#include "Clock.h"
+#include "Check.h"
+#include <cstdio>
+
+using namespace FrameJacker;
+
+static constexpr uint64_t kMillisecond = 1000000;
+static constexpr uint64_t kSkipped = LatencyScheduler::kSkipped;
+
+// A game on a virtual clock. With a cycle its presents wait for the next slot (vsync, a GPU-bound
+// queue); without one they return at once.
+struct Game {
+    void* swapChain;
+    uint64_t cycle;
+    uint64_t frameStart;
+    uint64_t postPresent = kMillisecond / 10;     // From the present returning to the scheduler
+    uint64_t presentEnd = 0;
+    uint64_t missedSlots = 0;
+
+    // Builds a frame for work nanoseconds, presents it and returns the scheduler's delay
+    uint64_t Frame(uint64_t work) {
+        uint64_t submit = frameStart + work;
+        uint64_t end = cycle ? (submit / cycle + 1) * cycle : submit + kMillisecond / 10;
+        if (cycle && presentEnd && end - presentEnd > cycle)
+            missedSlots++;
+        presentEnd = end;
+
+        uint64_t now = presentEnd + postPresent;
+        uint64_t delay = LatencyScheduler::Schedule(swapChain, now, submit, presentEnd);
+        frameStart = now + (delay == kSkipped ? 0 : delay);
+        return delay;
+    }
+};
+
+static int g_SwapChains[2];
+
+// A vsync-bound game: the delay creeps up on what the slot leaves over and never costs a slot
+static void CreepUp(Game& game) {
+    CHECK(game.Frame(4 * kMillisecond) == kSkipped);
+
+    // Cycle 16, work 4 with a 4 ms deviation against the empty average, safety 0.5, post-present
+    // 0.1: a quarter of the 3.4 ms target
+    CHECK(game.Frame(4 * kMillisecond) == 850000);
+
+    uint64_t previous = 850000;
+    for (int i = 0; i < 60; i++) {
+        uint64_t delay = game.Frame(4 * kMillisecond);
+        CHECK(delay >= previous);
+        CHECK(delay <= 11400000);
+        previous = delay;
+    }
+    CHECK(previous > 11200000);
+    CHECK(game.missedSlots == 0);
+}
+
+// More time after the present leaves less to delay, given back in a single frame
+static void GiveBack(Game& game) {
+    game.postPresent = 3 * kMillisecond;
+    uint64_t delay = game.Frame(4 * kMillisecond);
+    CHECK(delay <= 8500000 && delay > 8000000);
+    CHECK(game.Frame(4 * kMillisecond) <= 8500000);
+    CHECK(game.missedSlots == 0);
+    game.postPresent = kMillisecond / 10;
+}
+
+// Presents that no longer block halve the delay every frame
+static void BackOff(Game& game) {
+    uint64_t previous = game.Frame(4 * kMillisecond);
+    game.cycle = 0;
+    for (int i = 0; i < 8; i++) {
+        uint64_t delay = game.Frame(4 * kMillisecond);
+        CHECK(delay == previous / 2);
+        previous = delay;
+    }
+}
+
+// A resize starts over, and no delay ever exceeds 50 ms
+static void ResizeAndLimit(Game& game) {
+    LatencyScheduler::NoteResize();
+    game.cycle = 200 * kMillisecond;
+    CHECK(game.Frame(kMillisecond) == kSkipped);
+
+    uint64_t delay = 0;
+    for (int i = 0; i < 60; i++) {
+        delay = game.Frame(kMillisecond);
+        CHECK(delay <= 50 * kMillisecond);
+    }
+    CHECK(delay > 49 * kMillisecond);
+}
+
+// A present the scheduler did not see start is skipped and restarts the frame
+static void OutOfOrder(Game& game) {
+    uint64_t now = game.frameStart + kMillisecond;
+    CHECK(LatencyScheduler::Schedule(game.swapChain, now, game.frameStart - 1, now) == kSkipped);
+    game.frameStart = now;
+    CHECK(game.Frame(kMillisecond) != kSkipped);
+}
+
+// Another swap chain is only followed once the current one has been quiet for 500 ms
+static void SwitchSwapChain(Game& first) {
+    Game second = { &g_SwapChains[1], 16 * kMillisecond, first.frameStart };
+    CHECK(second.Frame(4 * kMillisecond) == kSkipped);
+    uint64_t delay = first.Frame(kMillisecond);
+    CHECK(delay != kSkipped && delay > 0);
+
+    // Quiet from here on: the second swap chain takes over and warms up, the first is ignored
+    second.frameStart = first.frameStart + 500 * kMillisecond;
+    CHECK(second.Frame(4 * kMillisecond) == kSkipped);
+    CHECK(second.Frame(4 * kMillisecond) == 850000);
+    CHECK(first.Frame(kMillisecond) == kSkipped);
+}
+
+// Delay itself on the real clock: warm-up, then a present that did not block sleeps nothing
+static void RealClock() {
+    LatencyScheduler::SetEnabled(true);
+    uint64_t now = Clock::Now();
+    CHECK(LatencyScheduler::Delay(&g_SwapChains[1], now, now) == 0);
+    now = Clock::Now();
+    CHECK(LatencyScheduler::Delay(&g_SwapChains[1], now, now) == 0);
+    CHECK(LatencyScheduler::GetStats().frames == 1);
+}
+
+int main() {
+    LatencyScheduler::SetEnabled(true);
+    Game game = { &g_SwapChains[0], 16 * kMillisecond, 1000 * kMillisecond };
+    CreepUp(game);
+    GiveBack(game);
+    BackOff(game);
+    ResizeAndLimit(game);
+    OutOfOrder(game);
+    SwitchSwapChain(game);
+    RealClock();
+    LatencyScheduler::SetEnabled(false);
+    std::printf("LatencySchedulerTest passed\n");
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "SharedTelemetry.h"
+#include "Check.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace FrameJacker;
+
+static uint32_t ProcessId() {
+#ifdef _WIN32
+    return (uint32_t)::GetCurrentProcessId();
+#else
+    return (uint32_t)::getpid();
+#endif
+}
+
+static void PublishFrames(uint64_t first, uint64_t count) {
+    for (uint64_t i = first; i < first + count; i++) {
+        FrameEvent frame = {};
+        frame.api = API::Vulkan;
+        frame.frameIndex = i;
+        frame.timestamp = 1000 * i;
+        frame.previousFrameDuration = i + 1;
+        frame.presentDuration = i + 2;
+        SharedTelemetry::Publish(frame, 1920, (uint32_t)i);
+    }
+}
+
+// Records come out in order with every field intact, and a reader that falls behind skips ahead
+// to the oldest record still in the ring
+static void ReadInOrder() {
+    CHECK(SharedTelemetry::Open(8));
+    SharedTelemetryReader reader;
+    CHECK(reader.Open(ProcessId()));
+
+    FrameRecord records[16];
+    PublishFrames(0, 5);
+    CHECK(reader.Read(records, 16) == 5);
+    for (uint64_t i = 0; i < 5; i++) {
+        CHECK(records[i].frameIndex == i);
+        CHECK(records[i].timestamp == 1000 * i);
+        CHECK(records[i].frameDuration == i + 1);
+        CHECK(records[i].presentDuration == i + 2);
+        CHECK(records[i].api == (uint32_t)API::Vulkan);
+        CHECK(records[i].width == 1920);
+        CHECK(records[i].height == i);
+    }
+    CHECK(reader.Read(records, 16) == 0);
+
+    PublishFrames(5, 20);
+    CHECK(reader.Read(records, 16) == 8);
+    CHECK(reader.GetMissed() == 12);
+    CHECK(records[0].frameIndex == 17);
+    CHECK(records[7].frameIndex == 24);
+
+    // Closing the writer removes the name, the reader's mapping stays valid until it closes too
+    SharedTelemetry::Close();
+    SharedTelemetryReader late;
+    CHECK(!late.Open(ProcessId()));
+    CHECK(reader.Read(records, 16) == 0);
+}
+
+// Reopening and closing under a present that keeps publishing never pulls the mapping out from
+// under it, and a closed ring can no longer be opened by name
+static void ReopenWhilePublishing() {
+    std::atomic<bool> stop = false;
+    std::thread publisher([&] {
+        uint64_t frame = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            PublishFrames(frame, 64);
+            frame += 64;
+        }
+    });
+
+    for (int i = 0; i < 200; i++) {
+        CHECK(SharedTelemetry::Open(i % 2 ? 16 : 4096));
+        SharedTelemetry::Close();
+        SharedTelemetryReader reader;
+        CHECK(!reader.Open(ProcessId()));
+    }
+
+    stop = true;
+    publisher.join();
+    SharedTelemetry::Close();
+}
+
+#ifndef _WIN32
+// The ring is read through its own POSIX shm mapping from a second process, while this one keeps
+// publishing
+static void ReadFromChildProcess() {
+    static constexpr uint64_t kFrames = 100000;
+    CHECK(SharedTelemetry::Open(64));
+    uint32_t parent = ProcessId();
+    int opened[2];
+    CHECK(::pipe(opened) == 0);
+
+    pid_t child = ::fork();
+    CHECK(child >= 0);
+    if (child == 0) {
+        // _exit only, the inherited writer must not unlink the parent's ring on the way out
+        SharedTelemetryReader reader;
+        bool open = reader.Open(parent);
+        char ready = 1;
+        if (::write(opened[1], &ready, 1) != 1 || !open)
+            ::_exit(2);
+
+        std::vector<FrameRecord> records(64);
+        uint64_t received = 0;
+        uint64_t last = 0;
+        while (last + 1 < kFrames) {
+            size_t count = reader.Read(records.data(), records.size());
+            for (size_t i = 0; i < count; i++) {
+                const FrameRecord& record = records[i];
+                // A torn copy would mix fields from two frames
+                if (record.timestamp != 1000 * record.frameIndex || record.height != (uint32_t)record.frameIndex)
+                    ::_exit(3);
+                if (received && record.frameIndex <= last)
+                    ::_exit(4);
+                last = record.frameIndex;
+                received++;
+            }
+        }
+        ::_exit(received + reader.GetMissed() == kFrames ? 0 : 5);
+    }
+
+    // Start publishing once the child has mapped the ring, so it accounts for every frame
+    char ready = 0;
+    CHECK(::read(opened[0], &ready, 1) == 1);
+    ::close(opened[0]);
+    ::close(opened[1]);
+    PublishFrames(0, kFrames);
+
+    int status = 0;
+    CHECK(::waitpid(child, &status, 0) == child);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    SharedTelemetry::Close();
+}
+#endif
+
+int main() {
+    ReadInOrder();
+    ReopenWhilePublishing();
+#ifndef _WIN32
+    ReadFromChildProcess();
+#endif
+    std::printf("SharedTelemetryTest passed\n");
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "StutterDetector.h"
+#include "Check.h"
+#include <cstdio>
+#include <vector>
+
+using namespace FrameJacker;
+
+static constexpr uint64_t kMillisecond = 1000000;
+
+static uint64_t g_FrameIndex = 0;
+static uint64_t g_Timestamp = 0;
+
+// One present whose previous frame took milliseconds, 0 for the first present
+static const StutterEvent* Present(uint64_t milliseconds) {
+    FrameEvent frame = {};
+    frame.api = API::D3D11;
+    frame.frameIndex = g_FrameIndex++;
+    frame.timestamp = g_Timestamp += milliseconds * kMillisecond;
+    frame.previousFrameDuration = milliseconds * kMillisecond;
+    return StutterDetector::Update(frame);
+}
+
+// Presents every duration in turn and returns the frame indices that stuttered
+static std::vector<uint64_t> PresentAll(const std::vector<uint64_t>& milliseconds) {
+    std::vector<uint64_t> stutters;
+    for (uint64_t duration : milliseconds) {
+        if (Present(duration))
+            stutters.push_back(g_FrameIndex - 1);
+    }
+    return stutters;
+}
+
+static void Configure(double threshold, double madThreshold, uint32_t historyFrames) {
+    StutterSettings settings;
+    settings.Threshold = threshold;
+    settings.MadThreshold = madThreshold;
+    settings.WindowFrames = 8;
+    settings.HistoryFrames = historyFrames;
+    StutterDetector::Configure(settings);
+}
+
+// History holds the last frames, oldest first, ending with the stuttering one
+static void CheckHistory(const StutterEvent& event, uint32_t count) {
+    CHECK(event.historyCount == count);
+    for (uint32_t i = 0; i < count; i++)
+        CHECK(event.history[i].frameIndex == event.frameIndex + 1 - count + i);
+    CHECK(event.history[count - 1].frameDuration == (uint64_t)(event.frameMilliseconds * kMillisecond));
+}
+
+// Nothing fires before half a window, and a frame over twice the median fires from then on
+static void WarmUp() {
+    Configure(2.0, 0.0, 8);
+
+    // Frame 0 has no duration; frame 4 comes with 3 frames in the window and cannot fire
+    CHECK(PresentAll({ 0, 10, 10, 10, 50 }).empty());
+
+    const StutterEvent* event = Present(30);
+    CHECK(event);
+    CHECK(event->frameIndex == 5);
+    CHECK(event->frameMilliseconds == 30.0);
+    CHECK(event->medianMilliseconds == 10.0);
+    CHECK(event->madMilliseconds == 0.0);
+    // Fewer frames recorded than HistoryFrames
+    CheckHistory(*event, 6);
+}
+
+// The frame after a resize neither fires nor enters the window
+static void Resize() {
+    StutterDetector::NoteResize();
+    CHECK(!Present(100));
+
+    // With the 100 ms frame in the window the median would be 30 and this would not fire
+    const StutterEvent* event = Present(25);
+    CHECK(event);
+    CHECK(event->frameIndex == 7);
+    CHECK(event->medianMilliseconds == 10.0);
+    CheckHistory(*event, 8);
+    CHECK(event->history[6].resized);
+    CHECK(event->history[6].frameDuration == 100 * kMillisecond);
+    CHECK(!event->history[5].resized && !event->history[7].resized);
+}
+
+// The window only holds the last WindowFrames frames; a settings change starts it over
+static void SlidingWindow() {
+    Configure(2.0, 0.0, 4);
+
+    // 15 ms never exceeds twice the 10 ms median
+    CHECK(PresentAll({ 10, 10, 10, 10, 10, 10, 10, 10, 15, 15, 15, 15, 15, 15, 15, 15 }).empty());
+
+    // Only the 15 ms frames are left, so no deviation at all
+    const StutterEvent* event = Present(35);
+    CHECK(event);
+    CHECK(event->frameIndex == 24);
+    CHECK(event->medianMilliseconds == 15.0);
+    CHECK(event->madMilliseconds == 0.0);
+    CheckHistory(*event, 4);
+}
+
+// With a MAD threshold a frame must also stand out from the window's spread
+static void MedianAbsoluteDeviation() {
+    Configure(1.5, 3.0, 4);
+
+    // Median 14 ms, MAD 4 ms: 22 ms is over 1.5 x 14 but not over 14 + 3 x 4
+    CHECK(PresentAll({ 10, 14, 10, 14, 10, 14, 10, 14, 22 }).empty());
+
+    const StutterEvent* event = Present(27);
+    CHECK(event);
+    CHECK(event->frameIndex == 34);
+    CHECK(event->medianMilliseconds == 14.0);
+    CHECK(event->madMilliseconds == 4.0);
+    CheckHistory(*event, 4);
+}
+
+int main() {
+    WarmUp();
+    Resize();
+    SlidingWindow();
+    MedianAbsoluteDeviation();
+    CHECK(StutterDetector::GetStutterCount() == 4);
+
+    // Disabled, nothing is recorded
+    StutterSettings settings;
+    settings.Enabled = false;
+    StutterDetector::Configure(settings);
+    CHECK(!Present(1000));
+    std::printf("StutterDetectorTest passed\n");
+    return 0;
+}
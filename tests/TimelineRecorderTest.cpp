@@ -0,0 +1,211 @@
+#include "TimelineRecorder.h"
+#include "Check.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace FrameJacker;
+
+static const char* kPath = "TimelineRecorderTest.json";
+static const char* kStreamPath = "TimelineRecorderTest.stream.json";
+
+// Quotes, backslashes and control characters a zone name may carry
+static const char* kZoneName = "Zone \"quoted\" C:\\path\ttab";
+static const char* kArgName = "arg \"one\"";
+
+// Just enough JSON to read the files back: objects, arrays, strings, numbers
+struct JsonValue {
+    enum class Type { Null, Number, String, Array, Object } type = Type::Null;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::map<std::string, JsonValue> object;
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : m_Text(text) {}
+
+    bool Parse(JsonValue& value) {
+        if (!ParseValue(value))
+            return false;
+        SkipSpace();
+        return m_Pos == m_Text.size();
+    }
+
+private:
+    void SkipSpace() {
+        while (m_Pos < m_Text.size() && strchr(" \t\r\n", m_Text[m_Pos]))
+            m_Pos++;
+    }
+
+    bool Take(char c) {
+        SkipSpace();
+        if (m_Pos < m_Text.size() && m_Text[m_Pos] == c) {
+            m_Pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ParseString(std::string& out) {
+        if (!Take('"'))
+            return false;
+        while (m_Pos < m_Text.size()) {
+            char c = m_Text[m_Pos++];
+            if (c == '"')
+                return true;
+            if ((unsigned char)c < 0x20)
+                return false;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (m_Pos >= m_Text.size())
+                return false;
+            switch (m_Text[m_Pos++]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+                if (m_Pos + 4 > m_Text.size())
+                    return false;
+                out += (char)std::stoi(m_Text.substr(m_Pos, 4), nullptr, 16);
+                m_Pos += 4;
+                break;
+            default: return false;
+            }
+        }
+        return false;
+    }
+
+    bool ParseValue(JsonValue& value) {
+        SkipSpace();
+        if (m_Pos >= m_Text.size())
+            return false;
+
+        char c = m_Text[m_Pos];
+        if (c == '"') {
+            value.type = JsonValue::Type::String;
+            return ParseString(value.string);
+        }
+        if (c == '[') {
+            m_Pos++;
+            value.type = JsonValue::Type::Array;
+            if (Take(']'))
+                return true;
+            do {
+                value.array.emplace_back();
+                if (!ParseValue(value.array.back()))
+                    return false;
+            } while (Take(','));
+            return Take(']');
+        }
+        if (c == '{') {
+            m_Pos++;
+            value.type = JsonValue::Type::Object;
+            if (Take('}'))
+                return true;
+            do {
+                std::string key;
+                if (!ParseString(key) || !Take(':') || !ParseValue(value.object[key]))
+                    return false;
+            } while (Take(','));
+            return Take('}');
+        }
+
+        size_t end = 0;
+        value.type = JsonValue::Type::Number;
+        value.number = std::stod(m_Text.substr(m_Pos), &end);
+        m_Pos += end;
+        return end > 0;
+    }
+
+    const std::string& m_Text;
+    size_t m_Pos = 0;
+};
+
+static bool ReadJson(const char* path, JsonValue& value) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream text;
+    text << file.rdbuf();
+    return JsonParser(text.str()).Parse(value);
+}
+
+// Records one complete and one instant event carrying the awkward names
+static void RecordEvents() {
+    TimelineRecorder::Complete(kZoneName, 1000, 3000, kArgName, 7);
+    TimelineRecorder::Instant("Resize", "width", 1280, kArgName, 720);
+}
+
+static void CheckEvents(const JsonValue& events) {
+    CHECK(events.type == JsonValue::Type::Array);
+    CHECK(events.array.size() == 2);
+
+    const JsonValue& zone = events.array[0];
+    CHECK(zone.object.at("name").string == kZoneName);
+    CHECK(zone.object.at("ph").string == "X");
+    CHECK(zone.object.at("ts").number == 1.0);
+    CHECK(zone.object.at("dur").number == 2.0);
+    CHECK(zone.object.at("args").object.at(kArgName).number == 7);
+
+    const JsonValue& instant = events.array[1];
+    CHECK(instant.object.at("name").string == "Resize");
+    CHECK(instant.object.at("ph").string == "i");
+    CHECK(instant.object.at("args").object.at("width").number == 1280);
+    CHECK(instant.object.at("args").object.at(kArgName).number == 720);
+}
+
+// Export writes the object form and consumes what it wrote
+static void ExportRoundTrip() {
+    TimelineRecorder::SetEnabled(true);
+    RecordEvents();
+    TimelineRecorder::SetEnabled(false);
+
+    CHECK(TimelineRecorder::Export(kPath));
+    JsonValue root;
+    CHECK(ReadJson(kPath, root));
+    CHECK(root.type == JsonValue::Type::Object);
+    CHECK(root.object.at("displayTimeUnit").string == "ms");
+    CheckEvents(root.object.at("traceEvents"));
+
+    CHECK(TimelineRecorder::Export(kPath));
+    JsonValue empty;
+    CHECK(ReadJson(kPath, empty));
+    CHECK(empty.object.at("traceEvents").array.empty());
+}
+
+// Streaming writes the array form, closed once StopStreaming returns
+static void StreamRoundTrip() {
+    TimelineRecorder::SetEnabled(true);
+    CHECK(TimelineRecorder::StartStreaming(kStreamPath));
+    RecordEvents();
+    TimelineRecorder::StopStreaming();
+    TimelineRecorder::SetEnabled(false);
+
+    JsonValue events;
+    CHECK(ReadJson(kStreamPath, events));
+    CheckEvents(events);
+
+    // A restart right after stopping gets a fresh, well formed file
+    CHECK(TimelineRecorder::StartStreaming(kStreamPath));
+    TimelineRecorder::StopStreaming();
+    JsonValue empty;
+    CHECK(ReadJson(kStreamPath, empty));
+    CHECK(empty.type == JsonValue::Type::Array && empty.array.empty());
+}
+
+int main() {
+    ExportRoundTrip();
+    StreamRoundTrip();
+    std::remove(kPath);
+    std::remove(kStreamPath);
+    std::printf("TimelineRecorderTest passed\n");
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "TraceRecorder.h"
+#include "Check.h"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace FrameJacker;
+
+static const char* kPath = "TraceRecorderTest.fjtrace";
+
+static void RecordFrames(uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        FrameEvent frame = {};
+        frame.api = API::D3D12;
+        frame.frameIndex = i;
+        frame.timestamp = 1000 * i;
+        TraceRecorder::Record(frame, 1280, 720);
+    }
+}
+
+// Full blocks and the partial block left at Stop all make it into the file, in order
+static void RoundTrip() {
+    static constexpr uint64_t kFrames = TraceRecorder::kBlockRecords * 2 + 100;
+    CHECK(TraceRecorder::Start(kPath));
+
+    // Slow enough for the flusher to keep up, so nothing is dropped
+    for (uint64_t i = 0; i < kFrames; i += 256) {
+        FrameEvent frame = {};
+        for (uint64_t j = i; j < i + 256 && j < kFrames; j++) {
+            frame.frameIndex = j;
+            frame.timestamp = 1000 * j;
+            TraceRecorder::Record(frame, 1280, 720);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    TraceRecorder::Stop();
+    CHECK(!TraceRecorder::IsRecording());
+    CHECK(TraceRecorder::GetDroppedRecords() == 0);
+
+    TraceFileHeader header;
+    std::vector<TraceRecordEx> records;
+    CHECK(ReadTraceFile(kPath, header, records));
+    CHECK(records.size() == kFrames);
+    for (uint64_t i = 0; i < kFrames; i++) {
+        CHECK(records[i].frameIndex == i);
+        CHECK(records[i].timestamp == 1000 * i);
+        CHECK(records[i].width == 1280 && records[i].height == 720);
+    }
+}
+
+// Start right after Stop, with presents on other threads, must never hand the new session a file
+// or buffers the previous flusher still owns
+static void RestartWhilePresenting() {
+    std::atomic<bool> stop = false;
+    std::vector<std::thread> presenters;
+    for (int i = 0; i < 4; i++) {
+        presenters.emplace_back([&stop] {
+            while (!stop.load(std::memory_order_relaxed))
+                RecordFrames(64);
+        });
+    }
+
+    for (int i = 0; i < 50; i++) {
+        CHECK(TraceRecorder::Start(kPath));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        TraceRecorder::Stop();
+    }
+
+    stop = true;
+    for (std::thread& presenter : presenters)
+        presenter.join();
+
+    TraceFileHeader header;
+    std::vector<TraceRecordEx> records;
+    CHECK(ReadTraceFile(kPath, header, records));
+}
+
+int main() {
+    RoundTrip();
+    RestartWhilePresenting();
+    std::remove(kPath);
+    std::printf("TraceRecorderTest passed\n");
+    return 0;
+}
@@ -0,0 +1,319 @@
+#include "VulkanOverlay.h"
+#include "OverlayLayer.h"
+#include "VulkanQueues.h"
+#include "Check.h"
+#include <algorithm>
+#include <cstring>
+#include <dlfcn.h>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Presents through the retained overlay on a VK_EXT_headless_surface swapchain the way the present
+// hook does. Runs against whichever driver the loader picks; set VK_ICD_FILENAMES to Mesa's
+// lvp_icd json to run on lavapipe. Skipped without a Vulkan loader or headless surface support.
+static constexpr int kSkipped = 77;
+
+static PFN_vkGetInstanceProcAddr LoadLoader() {
+    void* library = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+    return library ? (PFN_vkGetInstanceProcAddr)dlsym(library, "vkGetInstanceProcAddr") : nullptr;
+}
+
+int main() {
+    PFN_vkGetInstanceProcAddr getInstanceProcAddr = LoadLoader();
+    if (!getInstanceProcAddr) {
+        std::printf("No Vulkan loader, skipped\n");
+        return kSkipped;
+    }
+
+    auto vkEnumerateInstanceExtensionProperties = (PFN_vkEnumerateInstanceExtensionProperties)getInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceExtensionProperties");
+    auto vkCreateInstance = (PFN_vkCreateInstance)getInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance");
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+    if (std::none_of(extensions.begin(), extensions.end(),
+            [](const VkExtensionProperties& extension) { return strcmp(extension.extensionName, "VK_EXT_headless_surface") == 0; })) {
+        std::printf("No VK_EXT_headless_surface, skipped\n");
+        return kSkipped;
+    }
+
+    const char* instanceExtensions[] = { "VK_KHR_surface", "VK_EXT_headless_surface" };
+    VkInstanceCreateInfo instanceInfo = {};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.enabledExtensionCount = 2;
+    instanceInfo.ppEnabledExtensionNames = instanceExtensions;
+
+    VkInstance instance;
+    CHECK(vkCreateInstance(&instanceInfo, nullptr, &instance) == VK_SUCCESS);
+
+#define LOAD(name) auto name = (PFN_##name)getInstanceProcAddr(instance, #name); CHECK(name)
+    LOAD(vkDestroyInstance);
+    LOAD(vkEnumeratePhysicalDevices);
+    LOAD(vkGetPhysicalDeviceQueueFamilyProperties);
+    LOAD(vkGetPhysicalDeviceMemoryProperties);
+    LOAD(vkCreateDevice);
+    LOAD(vkGetDeviceProcAddr);
+    LOAD(vkCreateHeadlessSurfaceEXT);
+    LOAD(vkDestroySurfaceKHR);
+    LOAD(vkGetPhysicalDeviceSurfaceSupportKHR);
+    LOAD(vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
+    LOAD(vkGetPhysicalDeviceSurfaceFormatsKHR);
+#undef LOAD
+
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    if (deviceCount == 0) {
+        std::printf("No Vulkan device, skipped\n");
+        vkDestroyInstance(instance, nullptr);
+        return kSkipped;
+    }
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+    VkPhysicalDevice physicalDevice = devices[0];
+
+    VkHeadlessSurfaceCreateInfoEXT surfaceInfo = {};
+    surfaceInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+    VkSurfaceKHR surface;
+    CHECK(vkCreateHeadlessSurfaceEXT(instance, &surfaceInfo, nullptr, &surface) == VK_SUCCESS);
+
+    // A graphics queue that can present, which is where the overlay composites
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+    uint32_t family = familyCount;
+    for (uint32_t i = 0; i < familyCount && family == familyCount; i++) {
+        VkBool32 supported = VK_FALSE;
+        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &supported);
+        if (supported && (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+            family = i;
+    }
+    if (family == familyCount) {
+        std::printf("No graphics queue presenting to a headless surface, skipped\n");
+        vkDestroySurfaceKHR(instance, surface, nullptr);
+        vkDestroyInstance(instance, nullptr);
+        return kSkipped;
+    }
+
+    float queuePriority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = family;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &queuePriority;
+
+    const char* swapchainExtension = "VK_KHR_swapchain";
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    deviceInfo.enabledExtensionCount = 1;
+    deviceInfo.ppEnabledExtensionNames = &swapchainExtension;
+
+    VkDevice device;
+    CHECK(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) == VK_SUCCESS);
+
+#define LOAD(name) auto name = (PFN_##name)vkGetDeviceProcAddr(device, #name); CHECK(name)
+    LOAD(vkDestroyDevice);
+    LOAD(vkGetDeviceQueue);
+    LOAD(vkCreateSwapchainKHR);
+    LOAD(vkDestroySwapchainKHR);
+    LOAD(vkGetSwapchainImagesKHR);
+    LOAD(vkAcquireNextImageKHR);
+    LOAD(vkQueuePresentKHR);
+    LOAD(vkQueueSubmit);
+    LOAD(vkQueueWaitIdle);
+    LOAD(vkCreateSemaphore);
+    LOAD(vkDestroySemaphore);
+    LOAD(vkCreateCommandPool);
+    LOAD(vkDestroyCommandPool);
+    LOAD(vkAllocateCommandBuffers);
+    LOAD(vkBeginCommandBuffer);
+    LOAD(vkEndCommandBuffer);
+    LOAD(vkCmdPipelineBarrier);
+#undef LOAD
+
+    VkQueue queue;
+    vkGetDeviceQueue(device, family, 0, &queue);
+
+    VkSurfaceCapabilitiesKHR capabilities;
+    CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities) == VK_SUCCESS);
+    uint32_t formatCount = 1;
+    VkSurfaceFormatKHR format;
+    VkResult formats = vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, &format);
+    CHECK((formats == VK_SUCCESS || formats == VK_INCOMPLETE) && formatCount == 1);
+
+    VkSwapchainCreateInfoKHR info = {};
+    info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    info.surface = surface;
+    info.minImageCount = capabilities.minImageCount;
+    info.imageFormat = format.format;
+    info.imageColorSpace = format.colorSpace;
+    info.imageExtent = capabilities.currentExtent.width != 0xFFFFFFFF ? capabilities.currentExtent : VkExtent2D{ 640, 480 };
+    info.imageArrayLayers = 1;
+    info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.preTransform = capabilities.currentTransform;
+    info.compositeAlpha = (VkCompositeAlphaFlagBitsKHR)(capabilities.supportedCompositeAlpha & (0u - capabilities.supportedCompositeAlpha));
+    info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    info.clipped = VK_TRUE;
+
+    VkSwapchainKHR swapchain;
+    CHECK(vkCreateSwapchainKHR(device, &info, nullptr, &swapchain) == VK_SUCCESS);
+    uint32_t imageCount = 0;
+    vkGetSwapchainImagesKHR(device, swapchain, &imageCount, nullptr);
+    std::vector<VkImage> images(imageCount);
+    vkGetSwapchainImagesKHR(device, swapchain, &imageCount, images.data());
+
+    // What the game does each frame: render into the acquired image and leave it in the present layout
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = family;
+    VkCommandPool commandPool;
+    CHECK(vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) == VK_SUCCESS);
+
+    VkCommandBufferAllocateInfo commandBufferInfo = {};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.commandPool = commandPool;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount = imageCount;
+    std::vector<VkCommandBuffer> commandBuffers(imageCount);
+    CHECK(vkAllocateCommandBuffers(device, &commandBufferInfo, commandBuffers.data()) == VK_SUCCESS);
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkSemaphore acquired;
+    VkSemaphore rendered;
+    CHECK(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &acquired) == VK_SUCCESS);
+    CHECK(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &rendered) == VK_SUCCESS);
+
+    // What the hooks record before the first present
+    VulkanQueues::Initialize(vkGetPhysicalDeviceQueueFamilyProperties);
+    VulkanQueues::NoteDevice(device, physicalDevice);
+    VulkanQueues::NoteQueue(device, queue, family);
+    VulkanOverlay::Initialize(vkGetDeviceProcAddr, vkGetPhysicalDeviceMemoryProperties);
+    VulkanOverlay::NoteSwapchain(device, swapchain, info);
+
+    uint32_t renders = 0;
+    Callbacks subscriber;
+    subscriber.OnRender = [&](const RenderContext& ctx) {
+        CHECK(ctx.commandBuffer && ctx.renderTarget && ctx.device == (void*)device);
+        renders++;
+    };
+    SubscriptionId id = CallbackRegistry::Subscribe(subscriber);
+    OverlayLayer::Configure(true, 0.0);
+
+    auto present = [&] {
+        uint32_t imageIndex;
+        CHECK(vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, acquired, VK_NULL_HANDLE, &imageIndex) == VK_SUCCESS);
+        CHECK(vkQueueWaitIdle(queue) == VK_SUCCESS);
+
+        VkCommandBuffer commandBuffer = commandBuffers[imageIndex];
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS);
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = images[imageIndex];
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+        CHECK(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS);
+
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        VkSubmitInfo submit = {};
+        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.waitSemaphoreCount = 1;
+        submit.pWaitSemaphores = &acquired;
+        submit.pWaitDstStageMask = &waitStage;
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &commandBuffer;
+        submit.signalSemaphoreCount = 1;
+        submit.pSignalSemaphores = &rendered;
+        CHECK(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE) == VK_SUCCESS);
+
+        VkPresentInfoKHR presentInfo = {};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &rendered;
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &swapchain;
+        presentInfo.pImageIndices = &imageIndex;
+
+        // The present now waits on the composite, which waited on the game's semaphore
+        CallbackScope callbacks;
+        callbacks.BeginFrame(API::Vulkan, (void*)swapchain, 0, 0, (void*)queue);
+        RenderContext ctx = {};
+        ctx.api = API::Vulkan;
+        CHECK(VulkanOverlay::Render(callbacks, ctx, queue, presentInfo));
+        CHECK(presentInfo.waitSemaphoreCount == 1 && presentInfo.pWaitSemaphores[0] != rendered);
+        CHECK(vkQueuePresentKHR(queue, &presentInfo) == VK_SUCCESS);
+    };
+
+    // Drawn once, then composited until invalidated
+    for (int i = 0; i < 4; i++)
+        present();
+    CHECK(renders == 1);
+    OverlayLayer::Invalidate();
+    present();
+    present();
+    CHECK(renders == 2);
+
+    // Rebuilt with a fresh layer when the swapchain is recreated at the same handle
+    CHECK(vkQueueWaitIdle(queue) == VK_SUCCESS);
+    VulkanOverlay::NoteSwapchain(device, swapchain, info);
+    present();
+    CHECK(renders == 3);
+
+    // Swapchains that can't be rendered to, or several at once, are left to immediate rendering
+    CHECK(vkQueueWaitIdle(queue) == VK_SUCCESS);
+    VkSwapchainCreateInfoKHR transferOnly = info;
+    transferOnly.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    VulkanOverlay::NoteSwapchain(device, swapchain, transferOnly);
+    {
+        uint32_t imageIndex = 0;
+        VkSwapchainKHR swapchains[] = { swapchain, swapchain };
+        uint32_t imageIndices[] = { 0, 0 };
+        VkPresentInfoKHR presentInfo = {};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &swapchain;
+        presentInfo.pImageIndices = &imageIndex;
+
+        CallbackScope callbacks;
+        callbacks.BeginFrame(API::Vulkan, (void*)swapchain, 0, 0, (void*)queue);
+        RenderContext ctx = {};
+        CHECK(!VulkanOverlay::Render(callbacks, ctx, queue, presentInfo));
+        VulkanOverlay::NoteSwapchain(device, swapchain, info);
+        presentInfo.swapchainCount = 2;
+        presentInfo.pSwapchains = swapchains;
+        presentInfo.pImageIndices = imageIndices;
+        CHECK(!VulkanOverlay::Render(callbacks, ctx, queue, presentInfo));
+    }
+    CHECK(renders == 3);
+
+    // What the vkDestroySwapchainKHR and vkDestroyDevice hooks do
+    VulkanOverlay::ForgetSwapchain(swapchain);
+    vkDestroySwapchainKHR(device, swapchain, nullptr);
+    VulkanOverlay::ForgetDevice(device);
+
+    CHECK(CallbackRegistry::Unsubscribe(id));
+    OverlayLayer::Configure(false, 0.0);
+    VulkanOverlay::Shutdown();
+    VulkanQueues::Shutdown();
+    vkDestroySemaphore(device, acquired, nullptr);
+    vkDestroySemaphore(device, rendered, nullptr);
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    vkDestroyDevice(device, nullptr);
+    vkDestroySurfaceKHR(instance, surface, nullptr);
+    vkDestroyInstance(instance, nullptr);
+    std::printf("VulkanOverlayTest passed\n");
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include "VulkanProbe.h"
+#include "VulkanQueues.h"
+#include "Check.h"
+#include <dlfcn.h>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Runs against whichever driver the loader picks; set VK_ICD_FILENAMES to Mesa's lvp_icd json to
+// run on lavapipe. Skipped without a Vulkan loader or device.
+static constexpr int kSkipped = 77;
+
+static PFN_vkGetInstanceProcAddr LoadLoader() {
+    void* library = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+    return library ? (PFN_vkGetInstanceProcAddr)dlsym(library, "vkGetInstanceProcAddr") : nullptr;
+}
+
+// Real submits through the probed entry points, recorded the way the vkQueueSubmit(2) hooks do
+static void SubmitThroughProbe(PFN_vkGetDeviceProcAddr getDeviceProcAddr, VkDevice device, VkQueue queue,
+    const VulkanEntryPoints& entryPoints, VkQueueFlags queueFlags) {
+    auto vkCreateCommandPool = (PFN_vkCreateCommandPool)getDeviceProcAddr(device, "vkCreateCommandPool");
+    auto vkDestroyCommandPool = (PFN_vkDestroyCommandPool)getDeviceProcAddr(device, "vkDestroyCommandPool");
+    auto vkAllocateCommandBuffers = (PFN_vkAllocateCommandBuffers)getDeviceProcAddr(device, "vkAllocateCommandBuffers");
+    auto vkBeginCommandBuffer = (PFN_vkBeginCommandBuffer)getDeviceProcAddr(device, "vkBeginCommandBuffer");
+    auto vkEndCommandBuffer = (PFN_vkEndCommandBuffer)getDeviceProcAddr(device, "vkEndCommandBuffer");
+    auto vkCreateSemaphore = (PFN_vkCreateSemaphore)getDeviceProcAddr(device, "vkCreateSemaphore");
+    auto vkDestroySemaphore = (PFN_vkDestroySemaphore)getDeviceProcAddr(device, "vkDestroySemaphore");
+    auto vkQueueWaitIdle = (PFN_vkQueueWaitIdle)getDeviceProcAddr(device, "vkQueueWaitIdle");
+    auto queueSubmit = (PFN_vkQueueSubmit)entryPoints.queueSubmit;
+    auto queueSubmit2 = (PFN_vkQueueSubmit2)entryPoints.queueSubmit2;
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = 0;
+    VkCommandPool pool;
+    CHECK(vkCreateCommandPool(device, &poolInfo, nullptr, &pool) == VK_SUCCESS);
+
+    VkCommandBufferAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.commandPool = pool;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = 2;
+    VkCommandBuffer commandBuffers[2];
+    CHECK(vkAllocateCommandBuffers(device, &allocateInfo, commandBuffers) == VK_SUCCESS);
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    for (VkCommandBuffer commandBuffer : commandBuffers) {
+        CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS);
+        CHECK(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS);
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkSemaphore semaphore;
+    CHECK(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) == VK_SUCCESS);
+
+    WorkCounters::SetSubmissionsEnabled(true);
+    WorkCounters::EndFrame();
+
+    // Two batches chained by a semaphore: 3 command buffers, 1 wait, 1 signal
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkSubmitInfo submits[2] = {};
+    submits[0].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submits[0].commandBufferCount = 2;
+    submits[0].pCommandBuffers = commandBuffers;
+    submits[0].signalSemaphoreCount = 1;
+    submits[0].pSignalSemaphores = &semaphore;
+    submits[1].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submits[1].waitSemaphoreCount = 1;
+    submits[1].pWaitSemaphores = &semaphore;
+    submits[1].pWaitDstStageMask = &waitStage;
+    submits[1].commandBufferCount = 1;
+    submits[1].pCommandBuffers = &commandBuffers[0];
+
+    SubmissionCounts counts = VulkanQueues::CountSubmits(2, submits);
+    CHECK(counts.batches == 2 && counts.commandLists == 3 && counts.waitSemaphores == 1 && counts.signalSemaphores == 1);
+    CHECK(queueSubmit(queue, 2, submits, VK_NULL_HANDLE) == VK_SUCCESS);
+    VulkanQueues::RecordSubmission(queue, counts);
+    CHECK(vkQueueWaitIdle(queue) == VK_SUCCESS);
+
+    // The same chain through vkQueueSubmit2
+    uint64_t expectedSubmissions = 1;
+    if (queueSubmit2) {
+        VkCommandBufferSubmitInfo commandBufferInfos[2] = {};
+        for (uint32_t i = 0; i < 2; i++) {
+            commandBufferInfos[i].sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+            commandBufferInfos[i].commandBuffer = commandBuffers[i];
+        }
+        VkSemaphoreSubmitInfo semaphoreInfo2 = {};
+        semaphoreInfo2.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        semaphoreInfo2.semaphore = semaphore;
+        semaphoreInfo2.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo2 submits2[2] = {};
+        submits2[0].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+        submits2[0].commandBufferInfoCount = 2;
+        submits2[0].pCommandBufferInfos = commandBufferInfos;
+        submits2[0].signalSemaphoreInfoCount = 1;
+        submits2[0].pSignalSemaphoreInfos = &semaphoreInfo2;
+        submits2[1].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+        submits2[1].waitSemaphoreInfoCount = 1;
+        submits2[1].pWaitSemaphoreInfos = &semaphoreInfo2;
+        submits2[1].commandBufferInfoCount = 1;
+        submits2[1].pCommandBufferInfos = commandBufferInfos;
+
+        SubmissionCounts counts2 = VulkanQueues::CountSubmits(2, submits2);
+        CHECK(counts2.batches == 2 && counts2.commandLists == 3 && counts2.waitSemaphores == 1 && counts2.signalSemaphores == 1);
+        CHECK(queueSubmit2(queue, 2, submits2, VK_NULL_HANDLE) == VK_SUCCESS);
+        VulkanQueues::RecordSubmission(queue, counts2);
+        CHECK(vkQueueWaitIdle(queue) == VK_SUCCESS);
+        expectedSubmissions = 2;
+    }
+
+    WorkCounters::EndFrame();
+    SubmissionStats stats = WorkCounters::GetSubmissions();
+    CHECK(stats.submissions == expectedSubmissions);
+    CHECK(stats.batches == 2 * expectedSubmissions);
+    CHECK(stats.commandLists == 3 * expectedSubmissions);
+    CHECK(stats.queueCount == 1 && stats.queues[0].queue == (void*)queue);
+    CHECK(stats.queues[0].type == queueFlags);
+    CHECK(stats.queues[0].waitSemaphores == expectedSubmissions);
+    CHECK(stats.queues[0].signalSemaphores == expectedSubmissions);
+    if (queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        CHECK(stats.directSubmissions == expectedSubmissions);
+
+    // Nothing submitted since, nothing counted
+    WorkCounters::EndFrame();
+    CHECK(WorkCounters::GetSubmissions().submissions == 0);
+    WorkCounters::SetSubmissionsEnabled(false);
+
+    vkDestroySemaphore(device, semaphore, nullptr);
+    vkDestroyCommandPool(device, pool, nullptr);
+}
+
+int main() {
+    PFN_vkGetInstanceProcAddr getInstanceProcAddr = LoadLoader();
+    if (!getInstanceProcAddr) {
+        std::printf("No Vulkan loader, skipped\n");
+        return kSkipped;
+    }
+
+    VkInstance instance;
+    VulkanEntryPoints entryPoints;
+    if (!VulkanProbe::Resolve(getInstanceProcAddr, instance, entryPoints)) {
+        std::printf("No Vulkan device with VK_KHR_swapchain, skipped\n");
+        return kSkipped;
+    }
+
+    auto vkDestroyInstance = (PFN_vkDestroyInstance)getInstanceProcAddr(instance, "vkDestroyInstance");
+    auto vkEnumeratePhysicalDevices = (PFN_vkEnumeratePhysicalDevices)getInstanceProcAddr(instance, "vkEnumeratePhysicalDevices");
+    auto vkGetPhysicalDeviceProperties = (PFN_vkGetPhysicalDeviceProperties)getInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties");
+    auto vkGetPhysicalDeviceQueueFamilyProperties = (PFN_vkGetPhysicalDeviceQueueFamilyProperties)getInstanceProcAddr(instance, "vkGetPhysicalDeviceQueueFamilyProperties");
+    auto vkCreateDevice = (PFN_vkCreateDevice)getInstanceProcAddr(instance, "vkCreateDevice");
+    auto vkGetDeviceProcAddr = (PFN_vkGetDeviceProcAddr)getInstanceProcAddr(instance, "vkGetDeviceProcAddr");
+
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+    VkPhysicalDevice physicalDevice = devices[0];
+
+    // Never more than the physical device supports, and vkQueueSubmit2 whenever the device has it
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    std::printf("%s, Vulkan %u.%u, probed for %u.%u%s\n", properties.deviceName,
+        VK_API_VERSION_MAJOR(properties.apiVersion), VK_API_VERSION_MINOR(properties.apiVersion),
+        VK_API_VERSION_MAJOR(entryPoints.apiVersion), VK_API_VERSION_MINOR(entryPoints.apiVersion),
+        entryPoints.synchronization2 ? " with VK_KHR_synchronization2" : "");
+    CHECK(VK_API_VERSION_MINOR(entryPoints.apiVersion) <= VK_API_VERSION_MINOR(properties.apiVersion));
+    CHECK(entryPoints.queueSubmit && entryPoints.getDeviceQueue);
+    CHECK(!entryPoints.synchronization2 || entryPoints.apiVersion < VK_API_VERSION_1_3);
+    CHECK(!!entryPoints.queueSubmit2 == (entryPoints.apiVersion >= VK_API_VERSION_1_3 || entryPoints.synchronization2));
+    CHECK(!!entryPoints.getDeviceQueue2 == (entryPoints.apiVersion >= VK_API_VERSION_1_1));
+
+    // A device created by the game, independent of the probe's
+    float queuePriority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = 0;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &queuePriority;
+
+    // vkQueueSubmit2 needs the feature turned on, which every device offering it supports
+    VkPhysicalDeviceSynchronization2Features synchronization2Features = {};
+    synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+    synchronization2Features.synchronization2 = VK_TRUE;
+
+    const char* synchronization2 = "VK_KHR_synchronization2";
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.pNext = entryPoints.queueSubmit2 ? &synchronization2Features : nullptr;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    deviceInfo.enabledExtensionCount = entryPoints.synchronization2 ? 1 : 0;
+    deviceInfo.ppEnabledExtensionNames = &synchronization2;
+
+    VkDevice device;
+    CHECK(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) == VK_SUCCESS);
+    auto vkGetDeviceQueue = (PFN_vkGetDeviceQueue)vkGetDeviceProcAddr(device, "vkGetDeviceQueue");
+    auto vkDestroyDevice = (PFN_vkDestroyDevice)vkGetDeviceProcAddr(device, "vkDestroyDevice");
+
+    VkQueue queue;
+    vkGetDeviceQueue(device, 0, 0, &queue);
+
+    // What the vkGetDeviceQueue hook records
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+    VulkanQueues::Initialize(vkGetPhysicalDeviceQueueFamilyProperties);
+    CHECK(VulkanQueues::GetType(queue) == kUnknownQueueType);
+    // Devices created before the hooks have no physical device on record
+    VulkanQueues::NoteQueue(device, queue, 0);
+    CHECK(VulkanQueues::GetType(queue) == kUnknownQueueType);
+    CHECK(VulkanQueues::GetFamily(queue) == 0);
+    VulkanQueues::NoteDevice(device, physicalDevice);
+    CHECK(VulkanQueues::GetPhysicalDevice(device) == physicalDevice);
+    VulkanQueues::NoteQueue(device, queue, 0);
+    CHECK(VulkanQueues::GetType(queue) == families[0].queueFlags);
+    if (families[0].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        CHECK(VulkanQueues::GetGroup(VulkanQueues::GetType(queue)) == QueueGroup::Direct);
+    SubmitThroughProbe(vkGetDeviceProcAddr, device, queue, entryPoints, families[0].queueFlags);
+    VulkanQueues::ForgetDevice(device);
+    CHECK(VulkanQueues::GetType(queue) == kUnknownQueueType);
+    CHECK(!VulkanQueues::GetPhysicalDevice(device));
+    VulkanQueues::Shutdown();
+
+    // The hooks patch the probed entry points, so they must accept the game's handles
+    CHECK(((PFN_vkQueueSubmit)entryPoints.queueSubmit)(queue, 0, nullptr, VK_NULL_HANDLE) == VK_SUCCESS);
+    if (entryPoints.queueSubmit2)
+        CHECK(((PFN_vkQueueSubmit2)entryPoints.queueSubmit2)(queue, 0, nullptr, VK_NULL_HANDLE) == VK_SUCCESS);
+
+    vkDestroyDevice(device, nullptr);
+    vkDestroyInstance(instance, nullptr);
+    std::printf("VulkanProbeTest passed\n");
+    return 0;
+}
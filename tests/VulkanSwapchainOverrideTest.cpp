@@ -0,0 +1,190 @@
+#include "VulkanSwapchainOverride.h"
+#include "VulkanQueues.h"
+#include "Check.h"
+#include <algorithm>
+#include <cstring>
+#include <dlfcn.h>
+#include <vector>
+
+using namespace FrameJacker;
+
+// Creates real swapchains from rewritten create infos on a VK_EXT_headless_surface surface. Runs
+// against whichever driver the loader picks; set VK_ICD_FILENAMES to Mesa's lvp_icd json to run on
+// lavapipe. Skipped without a Vulkan loader or headless surface support.
+static constexpr int kSkipped = 77;
+
+static PFN_vkGetInstanceProcAddr LoadLoader() {
+    void* library = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+    return library ? (PFN_vkGetInstanceProcAddr)dlsym(library, "vkGetInstanceProcAddr") : nullptr;
+}
+
+template<typename Properties, typename Enumerate>
+static bool HasExtension(Enumerate enumerate, const char* name) {
+    uint32_t count = 0;
+    enumerate(&count, nullptr);
+    std::vector<Properties> extensions(count);
+    enumerate(&count, extensions.data());
+    return std::any_of(extensions.begin(), extensions.end(),
+        [name](const Properties& extension) { return strcmp(extension.extensionName, name) == 0; });
+}
+
+int main() {
+    PFN_vkGetInstanceProcAddr getInstanceProcAddr = LoadLoader();
+    if (!getInstanceProcAddr) {
+        std::printf("No Vulkan loader, skipped\n");
+        return kSkipped;
+    }
+
+    auto vkEnumerateInstanceExtensionProperties = (PFN_vkEnumerateInstanceExtensionProperties)getInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceExtensionProperties");
+    auto vkCreateInstance = (PFN_vkCreateInstance)getInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance");
+    auto enumerateInstance = [&](uint32_t* count, VkExtensionProperties* extensions) {
+        return vkEnumerateInstanceExtensionProperties(nullptr, count, extensions);
+    };
+    if (!HasExtension<VkExtensionProperties>(enumerateInstance, "VK_EXT_headless_surface")) {
+        std::printf("No VK_EXT_headless_surface, skipped\n");
+        return kSkipped;
+    }
+
+    const char* instanceExtensions[] = { "VK_KHR_surface", "VK_EXT_headless_surface" };
+    VkInstanceCreateInfo instanceInfo = {};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.enabledExtensionCount = 2;
+    instanceInfo.ppEnabledExtensionNames = instanceExtensions;
+
+    VkInstance instance;
+    CHECK(vkCreateInstance(&instanceInfo, nullptr, &instance) == VK_SUCCESS);
+
+#define LOAD(name) auto name = (PFN_##name)getInstanceProcAddr(instance, #name); CHECK(name)
+    LOAD(vkDestroyInstance);
+    LOAD(vkEnumeratePhysicalDevices);
+    LOAD(vkEnumerateDeviceExtensionProperties);
+    LOAD(vkCreateDevice);
+    LOAD(vkGetDeviceProcAddr);
+    LOAD(vkCreateHeadlessSurfaceEXT);
+    LOAD(vkDestroySurfaceKHR);
+    LOAD(vkGetPhysicalDeviceSurfaceSupportKHR);
+    LOAD(vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
+    LOAD(vkGetPhysicalDeviceSurfaceFormatsKHR);
+    LOAD(vkGetPhysicalDeviceSurfacePresentModesKHR);
+#undef LOAD
+
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+    auto enumerateDevice = [&](uint32_t* count, VkExtensionProperties* extensions) {
+        return vkEnumerateDeviceExtensionProperties(devices[0], nullptr, count, extensions);
+    };
+    if (deviceCount == 0 || !HasExtension<VkExtensionProperties>(enumerateDevice, "VK_KHR_swapchain")) {
+        std::printf("No Vulkan device with VK_KHR_swapchain, skipped\n");
+        vkDestroyInstance(instance, nullptr);
+        return kSkipped;
+    }
+    VkPhysicalDevice physicalDevice = devices[0];
+
+    VkHeadlessSurfaceCreateInfoEXT surfaceInfo = {};
+    surfaceInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+    VkSurfaceKHR surface;
+    CHECK(vkCreateHeadlessSurfaceEXT(instance, &surfaceInfo, nullptr, &surface) == VK_SUCCESS);
+
+    VkBool32 supported = VK_FALSE;
+    CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, 0, surface, &supported) == VK_SUCCESS && supported);
+
+    float queuePriority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &queuePriority;
+
+    const char* swapchainExtension = "VK_KHR_swapchain";
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    deviceInfo.enabledExtensionCount = 1;
+    deviceInfo.ppEnabledExtensionNames = &swapchainExtension;
+
+    VkDevice device;
+    CHECK(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) == VK_SUCCESS);
+    auto vkDestroyDevice = (PFN_vkDestroyDevice)vkGetDeviceProcAddr(device, "vkDestroyDevice");
+    auto vkCreateSwapchainKHR = (PFN_vkCreateSwapchainKHR)vkGetDeviceProcAddr(device, "vkCreateSwapchainKHR");
+    auto vkDestroySwapchainKHR = (PFN_vkDestroySwapchainKHR)vkGetDeviceProcAddr(device, "vkDestroySwapchainKHR");
+
+    VkSurfaceCapabilitiesKHR capabilities;
+    CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities) == VK_SUCCESS);
+    uint32_t formatCount = 1;
+    VkSurfaceFormatKHR format;
+    VkResult formats = vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, &format);
+    CHECK((formats == VK_SUCCESS || formats == VK_INCOMPLETE) && formatCount == 1);
+    uint32_t modeCount = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, nullptr);
+    std::vector<VkPresentModeKHR> modes(modeCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, modes.data());
+
+    // What a game hard-coding FIFO with the minimum image count asks for
+    VkSwapchainCreateInfoKHR info = {};
+    info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    info.surface = surface;
+    info.minImageCount = capabilities.minImageCount;
+    info.imageFormat = format.format;
+    info.imageColorSpace = format.colorSpace;
+    info.imageExtent = capabilities.currentExtent.width != 0xFFFFFFFF ? capabilities.currentExtent : VkExtent2D{ 640, 480 };
+    info.imageArrayLayers = 1;
+    info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.preTransform = capabilities.currentTransform;
+    info.compositeAlpha = (VkCompositeAlphaFlagBitsKHR)(capabilities.supportedCompositeAlpha & (0u - capabilities.supportedCompositeAlpha));
+    info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    info.clipped = VK_TRUE;
+
+    VulkanSwapchainOverride::Initialize(vkGetPhysicalDeviceSurfaceCapabilitiesKHR, vkGetPhysicalDeviceSurfacePresentModesKHR);
+    VkSwapchainCreateInfoKHR rewritten;
+
+    // Devices created before the hooks are left alone
+    VulkanSwapchainPolicy policy;
+    policy.PresentMode = VulkanPresentMode::Mailbox;
+    policy.MinImageCount = capabilities.minImageCount + 1;
+    VulkanSwapchainOverride::SetPolicy(policy);
+    CHECK(!VulkanSwapchainOverride::Apply(device, info, rewritten));
+
+    VulkanQueues::NoteDevice(device, physicalDevice);
+
+    uint32_t expectedCount = capabilities.maxImageCount ? std::min(policy.MinImageCount, capabilities.maxImageCount) : policy.MinImageCount;
+    for (VulkanPresentMode mode : { VulkanPresentMode::Immediate, VulkanPresentMode::Mailbox, VulkanPresentMode::FifoRelaxed }) {
+        policy.PresentMode = mode;
+        VulkanSwapchainOverride::SetPolicy(policy);
+        bool supportedMode = std::find(modes.begin(), modes.end(), (VkPresentModeKHR)mode) != modes.end();
+
+        bool overridden = VulkanSwapchainOverride::Apply(device, info, rewritten);
+        CHECK(overridden == (supportedMode || expectedCount != info.minImageCount));
+        if (!overridden)
+            continue;
+        CHECK(rewritten.presentMode == (supportedMode ? (VkPresentModeKHR)mode : info.presentMode));
+        CHECK(rewritten.minImageCount == expectedCount);
+
+        VkSwapchainKHR swapchain;
+        CHECK(vkCreateSwapchainKHR(device, &rewritten, nullptr, &swapchain) == VK_SUCCESS);
+        vkDestroySwapchainKHR(device, swapchain, nullptr);
+    }
+
+    // Nothing to rewrite
+    VulkanSwapchainOverride::SetPolicy({});
+    CHECK(!VulkanSwapchainOverride::Apply(device, info, rewritten));
+
+    // What the vkDestroySurfaceKHR and vkDestroyDevice hooks do before the handles are reused
+    policy.PresentMode = VulkanPresentMode::Fifo;
+    VulkanSwapchainOverride::SetPolicy(policy);
+    VulkanSwapchainOverride::ForgetSurface(surface);
+    CHECK(VulkanSwapchainOverride::Apply(device, info, rewritten) == (expectedCount != info.minImageCount));
+    VulkanQueues::ForgetDevice(device);
+    CHECK(!VulkanSwapchainOverride::Apply(device, info, rewritten));
+
+    VulkanSwapchainOverride::SetPolicy({});
+    VulkanSwapchainOverride::Shutdown();
+    VulkanQueues::Shutdown();
+    vkDestroyDevice(device, nullptr);
+    vkDestroySurfaceKHR(instance, surface, nullptr);
+    vkDestroyInstance(instance, nullptr);
+    std::printf("VulkanSwapchainOverrideTest passed\n");
+    return 0;
+}
@@ -0,0 +1,17 @@
+#include <FrameJacker/TraceFile.h>
+#include <cstdio>
+
+// Converts a trace written by FrameJacker::Trace::Start into a PresentMon-style CSV
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <trace file> <csv file>\n", argv[0]);
+        return 1;
+    }
+
+    if (!FrameJacker::ConvertTraceToCsv(argv[1], argv[2])) {
+        fprintf(stderr, "Failed to convert %s\n", argv[1]);
+        return 1;
+    }
+
+    return 0;
+}